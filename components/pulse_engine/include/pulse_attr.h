@@ -0,0 +1,23 @@
+#pragma once
+
+#include "esp_attr.h"
+#include "sdkconfig.h"
+
+// Com as bordas disparadas pela ISR do timer, tudo o que ela chama (e os
+// dados que lê) fica fora da flash: gravações na NVS desligam o cache e uma
+// falta de cache no caminho da borda viraria dezenas de µs de jitter.
+#if CONFIG_PULSE_EDGE_ISR
+#define PULSE_IRAM          IRAM_ATTR
+#else
+#define PULSE_IRAM
+#endif
+
+// Agendamento (RNG, MMPP, tempo morto). Com a fila de prazos a ISR só
+// consome prazos prontos e o agendamento roda na task, então volta à flash.
+#if CONFIG_PULSE_EDGE_ISR && !CONFIG_PULSE_LOOKAHEAD
+#define PULSE_SCHED_IRAM    IRAM_ATTR
+#define PULSE_SCHED_DRAM    DRAM_ATTR
+#else
+#define PULSE_SCHED_IRAM
+#define PULSE_SCHED_DRAM
+#endif
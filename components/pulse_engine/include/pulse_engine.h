@@ -0,0 +1,353 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#if CONFIG_PULSE_MODE_RANDOM || CONFIG_PULSE_MODE_BURST
+#include "pulse_random.h"
+#endif
+#if CONFIG_PULSE_MODE_REPLAY
+#include "pattern_lib.h"
+#endif
+#if CONFIG_PULSE_MODE_MOTION
+#include "pulse_motion.h"
+#endif
+#if CONFIG_PULSE_MODE_QUADRATURE
+#include "pulse_quadrature.h"
+#endif
+#if CONFIG_PULSE_MODE_METER
+#include "pulse_meter.h"
+#endif
+#if CONFIG_PULSE_MODE_NCO
+#include "pulse_nco.h"
+#endif
+#if CONFIG_PULSE_RAMP
+#include "pulse_ramp.h"
+#endif
+#if CONFIG_PULSE_WIDTH_SEQ
+#include "pulse_width.h"
+#endif
+
+// Motor de geração: agendamento das bordas, tasks de pulso, estatísticas e
+// log adiado. Não fala com o console; quem configura preenche os
+// pulse_config_t, chama pulse_engine_start() e consome status e log.
+
+#define PULSE_CHANNELS      CONFIG_PULSE_CHANNELS
+
+// Modos fora do build (Kconfig "Modos compilados") somem do binário e do
+// switch por borda; com só o modo fixo o agendamento vira uma soma direta.
+#if CONFIG_PULSE_MODE_RANDOM || CONFIG_PULSE_MODE_BURST
+#define PULSE_RANDOM_ENGINE 1
+#endif
+
+// ========== TIPOS ==========
+typedef enum {
+    MODE_DEFINED,
+    MODE_RANDOM,
+    MODE_BURST,
+    MODE_REPLAY,
+    MODE_MOTION,
+    MODE_QUADRATURE,
+    MODE_METER,
+    MODE_NCO
+} pulse_mode_t;
+
+// O que fazer com um pulso que sairia além da tolerância de atraso
+typedef enum {
+    DEADLINE_FIRE_LATE,     // dispara atrasado e mantém a grade original
+    DEADLINE_SKIP,          // descarta o pulso e segue para o próximo prazo
+    DEADLINE_REPHASE        // dispara agora e desloca a grade pelo atraso
+} deadline_policy_t;
+
+typedef enum {
+    STATE_RUNNING,
+    STATE_PAUSED,
+    STATE_STOPPED
+} generator_state_t;
+
+#if CONFIG_PULSE_MODE_REPLAY
+// Reprodução de um padrão da biblioteca na flash mapeada
+typedef struct {
+    pattern_cursor_t cur;
+    const pattern_lib_t *lib;
+    const pattern_entry_t *entry;
+    uint32_t scale_permille; // 1000 = tempo original
+} replay_t;
+#endif
+
+// Saúde temporal de uma saída; atualizada pela task de pulso sob o lock do motor
+typedef struct {
+    uint64_t samples;
+    uint64_t late_sum_us;
+    uint32_t late_max_us;
+    uint64_t width_err_sum_us;
+    uint32_t width_err_max_us;
+    uint64_t missed;
+    uint64_t skipped;
+    uint64_t last_missed_us; // tempo de execução do último prazo perdido
+    uint64_t edge_cycles_sum; // ciclos de CPU do agendamento por borda
+    uint32_t edge_cycles_max;
+    uint32_t fifo_drain_max;  // maior consumo da fila de prazos à frente da task
+    uint32_t underruns;       // vezes em que a fila de prazos secou
+} pulse_stats_t;
+
+typedef struct {
+    uint32_t tolerance_us;
+    deadline_policy_t policy;
+} deadline_t;
+
+// Mudança de parâmetros durante a geração; 0 mantém o valor atual
+typedef struct {
+    uint32_t interval_us;    // só MODE_DEFINED
+    uint32_t width_us;       // menos replay, quadratura e sequência de larguras
+    uint32_t mhz;            // só MODE_NCO
+} pulse_change_t;
+
+#if CONFIG_PULSE_COUNT_MIRROR
+// Contagem espelhada fora do motor (memória RTC, que sobrevive a reset). Cada
+// pulso grava a vaga do bit baixo da contagem com check = ~count; um reset no
+// meio da gravação estraga só essa vaga e a outra segue válida.
+typedef struct {
+    struct {
+        uint64_t count;
+        uint64_t check;
+    } slot[2];
+} pulse_mirror_t;
+#endif
+
+typedef struct {
+    uint64_t count;
+    uint64_t at_us;          // início do pulso (ou prazo perdido), µs desde o boot
+    uint32_t late_us;
+    uint8_t channel;
+    bool missed;
+} log_record_t;
+
+typedef struct {
+    int gpio;
+    uint32_t interval_us;    // intervalo (médio, nos modos aleatórios) entre pulsos
+    int pulse_duration_ms;
+    pulse_mode_t mode;
+    const char *label;
+    uint64_t max_pulses;     // 0 = contínuo
+    generator_state_t state;
+    uint64_t pulse_count;    // escrito sob o lock do motor (64 bits não é atômico no C3)
+    uint64_t next_due_us;    // instante do próximo pulso no tempo de execução
+    uint32_t width_us;       // largura do próximo pulso
+    uint32_t min_gap_us;     // folga exigida pelas mudanças entre o fim do pulso e o próximo
+#if PULSE_RANDOM_ENGINE
+    uint32_t rng;            // estado do xorshift32
+#endif
+#if CONFIG_PULSE_MODE_BURST
+    mmpp_t mmpp;
+#endif
+#if CONFIG_PULSE_MODE_RANDOM
+    random_stream_t common;  // eventos coincidentes (mesma semente nas duas saídas)
+    random_stream_t indep;   // eventos próprios da saída
+#endif
+#if CONFIG_PULSE_DEADTIME
+    deadtime_t dead;
+#endif
+#if CONFIG_PULSE_MODE_REPLAY
+    replay_t replay;
+#endif
+#if CONFIG_PULSE_MODE_MOTION
+    motion_t motion;
+    uint32_t step_width_us;  // largura do STEP
+#endif
+#if CONFIG_PULSE_MODE_QUADRATURE
+    quadrature_t quad;
+    int gpio_b;              // linha B (gpio é a linha A)
+    int gpio_z;              // índice; -1 = sem
+    uint8_t levels;          // níveis de A, B e índice depois da próxima contagem
+#endif
+#if CONFIG_PULSE_MODE_METER
+    meter_t meter;
+#endif
+#if CONFIG_PULSE_MODE_NCO
+    nco_t nco;
+    nco_tuning_t nco_tune;   // frequência inicial
+#endif
+#if CONFIG_PULSE_RAMP
+    ramp_t ramp;             // rampas do intervalo fixo
+    uint64_t ramp_count;     // prazos já calculados (fim da descida com max_pulses)
+    volatile bool finishing; // pulse_engine_finish(): descer e terminar
+#endif
+#if CONFIG_PULSE_WIDTH_SEQ
+    width_seq_t wseq;        // largura por pulso; WIDTH_FIXED usa pulse_duration_ms
+#endif
+    pulse_change_t staged;   // mudança aguardando pulse_engine_commit()
+    bool staged_set;
+    volatile bool staged_armed; // aplicar no primeiro prazo >= staged_at_us
+    uint64_t staged_at_us;
+#if CONFIG_PULSE_COUNT_MIRROR
+    pulse_mirror_t *mirror;  // NULL = sem espelho
+#endif
+    pulse_stats_t stats;
+    deadline_t deadline;
+    TaskHandle_t task;
+} pulse_config_t;
+
+// Cópia consistente do estado de uma saída
+typedef struct {
+    generator_state_t state;
+    pulse_mode_t mode;
+    uint64_t pulse_count;
+    pulse_stats_t stats;
+    uint32_t stack_free;     // marca d'água da pilha da task, em bytes
+} pulse_channel_status_t;
+
+typedef struct {
+    bool running;
+    bool paused;
+    uint64_t run_time_us;
+    uint32_t log_drops;
+    int channel_count;
+    pulse_channel_status_t channels[PULSE_CHANNELS];
+} pulse_engine_status_t;
+
+// ========== CONFIGURAÇÃO ==========
+
+// Estado inicial de uma saída com intervalo e largura já definidos: semeia o
+// RNG e deixa os fluxos aleatórios na taxa do intervalo
+void pulse_config_init(pulse_config_t *config);
+
+#if CONFIG_PULSE_MODE_RANDOM && PULSE_CHANNELS == 2
+// Fluxo comum de taxa p * min(r1, r2) somado a fluxos independentes que
+// completam a taxa de cada saída; as coincidências ficam exatas e a
+// sequência inteira é reproduzível a partir da semente (0 = aleatória).
+void pulse_coincidence_setup(pulse_config_t *a, pulse_config_t *b, int permille, uint32_t seed);
+#endif
+
+#if CONFIG_PULSE_DEADTIME
+// Converte a taxa observada pedida na taxa verdadeira do processo subjacente.
+// Exato para Poisson; no MMPP é uma aproximação. Com coincidências, o fluxo
+// comum fica igual nas duas saídas e só o próprio de cada uma é acelerado; o
+// tempo morto age por saída, então eventos comuns podem ser perdidos em uma só.
+// Retorna false se a taxa é inatingível; true_rate recebe a taxa em eventos/s.
+bool pulse_deadtime_apply(pulse_config_t *config, double *true_rate);
+#endif
+
+#if CONFIG_PULSE_MODE_REPLAY
+// Associa o padrão à saída e ajusta o intervalo médio equivalente
+void pulse_replay_select(pulse_config_t *config, const pattern_lib_t *lib,
+                         const pattern_entry_t *entry, uint32_t scale_permille);
+#endif
+
+#if CONFIG_PULSE_MODE_MOTION
+// Movimento de motor de passo: a saída vira STEP com o perfil planejado e
+// max_pulses recebe o número de passos. false se motion_plan() recusa.
+bool pulse_motion_select(pulse_config_t *config, motion_profile_t profile, uint32_t steps,
+                         uint32_t v_max, uint32_t accel, uint32_t step_width_us);
+
+// Pino DIR fixo no nível da direção durante o movimento
+void pulse_engine_dir_set(int gpio, bool level);
+#endif
+
+#if CONFIG_PULSE_MODE_QUADRATURE
+// Encoder em quadratura com o programa já montado em config->quad: cada
+// prazo é uma contagem e a mesma borda escreve A (config->gpio), B e o
+// índice. Não há largura nem limite de pulsos; o programa define o fim. A
+// política DEADLINE_SKIP não serve aqui: pular uma contagem quebra a
+// sequência Gray, então quem configura deve usar outra.
+void pulse_quadrature_select(pulse_config_t *config, int gpio_b, int gpio_z);
+#endif
+
+#if CONFIG_PULSE_MODE_METER
+// Saída S0 com a tabela já copiada em config->meter.points: valida com
+// meter_setup() e deixa o intervalo no pico do perfil. O fim vem do perfil
+// (ou nunca, repetindo); max_pulses fica 0.
+bool pulse_meter_select(pulse_config_t *config, uint16_t count, uint32_t imp_per_kwh, bool repeat);
+#endif
+
+#if CONFIG_PULSE_MODE_NCO
+// Frequência exata em mHz por acumulador de fase (pulse_nco.h)
+void pulse_nco_select(pulse_config_t *config, uint32_t mhz);
+#endif
+
+#if CONFIG_PULSE_RAMP
+// Rampas de subida e descida do intervalo fixo (pulse_ramp.h), com o
+// intervalo já definido. A subida vale na partida e na retomada da pausa; a
+// descida em pulse_engine_finish() e, com max_pulses, termina exatamente no
+// último pulso: pulsos das rampas contam no limite, e os descartados por
+// DEADLINE_SKIP são repostos (antes da descida ela começa mais tarde; os
+// descartados nela saem depois dela, no intervalo mais lento). false se
+// nenhuma rampa cabe.
+bool pulse_ramp_select(pulse_config_t *config, uint32_t up_ms, uint32_t down_ms);
+#endif
+
+#if CONFIG_PULSE_WIDTH_SEQ
+// Largura por pulso da sequência já preenchida em config->wseq. Só no
+// intervalo fixo e no NCO, em que o intervalo seguinte nunca fica abaixo do
+// configurado (as rampas só o alongam): a maior largura da sequência tem de
+// caber nele, então nenhum pulso invade o próximo. false se a sequência é
+// inválida, o modo não serve ou a largura não cabe.
+bool pulse_width_select(pulse_config_t *config);
+#endif
+
+// ========== SEQUÊNCIA ==========
+// Prazos de uma saída sem task nem timer, para backends que renderizam a
+// saída adiantado (stream por DMA). Conta os pulsos em pulse_count.
+
+void pulse_sequence_start(pulse_config_t *config);
+
+// Próximo pulso: prazo no tempo de execução e largura, em µs; false no fim
+bool pulse_sequence_next(pulse_config_t *config, uint64_t *due_us, uint32_t *width_us);
+
+// ========== EXECUÇÃO ==========
+
+// Pino em nível ocioso (alto) antes de iniciar
+void pulse_engine_gpio_init(int gpio);
+
+// Zera relógio, log e contadores e cria uma task por saída
+void pulse_engine_start(pulse_config_t *configs, int count);
+
+// Pede o fim das tasks; elas param no próximo ciclo
+void pulse_engine_stop(void);
+
+#if CONFIG_PULSE_RAMP
+// Fim suave: cada saída termina no limite de período, passando pela rampa
+// de descida se tiver uma. Com PULSE_LOOKAHEAD os prazos já enfileirados
+// saem antes. Pausado, para na hora como pulse_engine_stop().
+void pulse_engine_finish(void);
+#endif
+
+// Alterna pausa de todas as saídas; retorna true se ficou pausado
+bool pulse_engine_toggle_pause(void);
+
+// true enquanto alguma saída não chegou a STATE_STOPPED
+bool pulse_engine_busy(void);
+
+void pulse_engine_snapshot(pulse_engine_status_t *out);
+
+// ========== MUDANÇAS DURANTE A GERAÇÃO ==========
+// Uma mudança é preparada por saída e depois confirmada; ela entra num
+// limite de período: o primeiro pulso a partir do instante combinado já sai
+// com a largura nova e o intervalo que começa nele também é o novo, então
+// não há pulso cortado nem intervalo misturado. Pulsos já calculados não
+// mudam: com PULSE_LOOKAHEAD a troca vem depois dos prazos enfileirados.
+
+// Prepara a mudança de uma saída (substitui a anterior que ainda não entrou).
+// false se a saída não existe, o campo não vale no modo dela ou a largura
+// em vigor depois da troca, mais min_gap_us, não cabe no intervalo.
+bool pulse_engine_stage(int channel, const pulse_change_t *change);
+
+// Confirma as mudanças preparadas nas saídas de mask (bit 0 = OUT1). Com
+// together, todas entram a partir do mesmo instante: o próximo prazo ainda
+// não calculado mais tardio entre elas. Retorna quantas saídas confirmou.
+int pulse_engine_commit(uint32_t mask, bool together);
+
+#if CONFIG_PULSE_MODE_NCO
+// Atalho: prepara e confirma só a frequência de uma saída em MODE_NCO; a
+// fase segue contínua na troca
+bool pulse_engine_set_frequency(int channel, uint32_t mhz);
+#endif
+
+// Zera atraso, erro de largura e prazos perdidos (não os contadores de pulso)
+// para medir uma janela nova
+void pulse_engine_reset_stats(void);
+
+// Retira um registro do log adiado; false se vazio
+bool pulse_engine_log_pop(log_record_t *rec);
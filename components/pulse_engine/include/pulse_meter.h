@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+// Saída S0 de medidor de energia: a potência segue uma tabela de perfil de
+// carga (interpolação linear entre pontos) e um acumulador de fase integra a
+// energia; cada 1/N kWh vira um pulso. A energia é inteira (mW·µs × N) e o
+// resto passa de um pulso ao próximo, então o total de pulsos é exatamente o
+// piso da energia integrada vezes N, e cada pulso custa uma divisão.
+//
+// O perfil é percorrido em fatias de até PULSE_METER_SLICE_MS que não cruzam
+// pontos da tabela; na fatia a potência é a média das pontas interpoladas
+// (exato para o trecho linear, a menos do arredondamento em mW nas pontas).
+// tools/meter_profile.py reproduz a mesma aritmética e dá o total esperado.
+
+#define METER_MAX_POINTS    CONFIG_PULSE_METER_MAX_POINTS
+#define METER_SLICE_US      ((uint64_t)CONFIG_PULSE_METER_SLICE_MS * 1000u)
+
+// Potência máxima de um ponto: mantém a interpolação em 64 bits
+#define METER_MAX_POWER_MW  1000000000u
+
+// Energia de um pulso no acumulador: a fatia soma as duas pontas da potência
+// vezes N por µs, então 1/N kWh vale 2 × 3,6e15 mW·µs
+#define METER_PULSE_ENERGY  7200000000000000ull
+
+typedef struct {
+    uint32_t t_ms;           // desde o início do perfil
+    uint32_t power_mw;
+} meter_point_t;
+
+typedef struct {
+    meter_point_t points[METER_MAX_POINTS];
+    uint16_t count;
+    uint32_t imp_per_kwh;
+    bool repeat;             // recomeça o perfil ao fim
+    // Estado da execução
+    uint16_t seg;            // primeiro ponto do trecho em curso
+    uint64_t origin_us;      // início da passada em curso
+    uint64_t t_us;           // último pulso ou fim da última fatia
+    uint64_t slice_end_us;
+    uint64_t rate;           // (P no início + P no fim da fatia) × N, por µs
+    uint64_t phase;          // energia desde o último pulso
+} meter_t;
+
+// Valida a tabela já copiada em m->points (ao menos 2 pontos, o primeiro em
+// t = 0, tempos crescentes, potência até METER_MAX_POWER_MW) e a constante N.
+// false também se o pico passa de 1e6 pulsos/s ou se um perfil repetido não
+// tem energia.
+bool meter_setup(meter_t *m, uint16_t count, uint32_t imp_per_kwh, bool repeat);
+
+// Taxa de pulsos no ponto de maior potência, em pulsos/s arredondados para cima
+uint32_t meter_peak_rate(const meter_t *m);
+
+// Energia de uma passada pelo perfil, em Wh (trapézios, para exibição)
+double meter_energy_wh(const meter_t *m);
+
+void meter_start(meter_t *m);
+
+// Instante do próximo pulso em µs desde o início; UINT64_MAX no fim do perfil
+uint64_t meter_next_us(meter_t *m);
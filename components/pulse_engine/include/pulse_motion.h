@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pulse_attr.h"
+
+// Perfis de movimento para motor de passo (STEP/DIR). O planejamento usa
+// ponto flutuante uma vez; por passo só há aritmética inteira. Tempos em µs
+// Q8 (1/256 µs) para a soma dos intervalos não acumular o arredondamento do
+// µs inteiro.
+//
+// Trapézio: recorrência do AVR446, c_n = c_(n-1) - (2 c_(n-1) + resto) / (4n + 1),
+// semeada com 0,676 c_0 e com n negativo na desaceleração; o primeiro e o
+// último intervalo saem exatos (c_0 = sqrt(2/a)). Uma divisão de 32 bits por
+// passo.
+// Curva S: velocidade v = v_pico * s(t/T), s(u) = 3u² - 2u³ (aceleração
+// contínua, nula nas pontas, pico 1,5 v_pico / T). O AVR446 não tem forma para
+// aceleração variável; cada passo resolve a posição exata p(u) = k com duas
+// iterações de Newton a partir do passo anterior, então o erro não acumula.
+// Uma divisão de 32 bits por iteração.
+//
+// Rampas simétricas (a mesma aceleração nas duas pontas); no cruzeiro o
+// instante sai direto do número do passo. Um trapézio que chega a v_max antes
+// do primeiro passo é cruzeiro do início ao fim, com o atraso exato de v/2a
+// da partida e da parada.
+
+typedef enum {
+    MOTION_TRAPEZOID,
+    MOTION_SCURVE
+} motion_profile_t;
+
+typedef struct {
+    motion_profile_t profile;
+    uint32_t steps;          // passos do movimento (intervalos = steps - 1)
+    uint64_t ramp_q16;       // passos em cada rampa, Q16
+    uint32_t ramp_steps;     // parte inteira de ramp_q16
+    uint32_t c0_q8;          // primeiro intervalo exato
+    uint32_t c_min_q8;       // intervalo na velocidade de pico
+    uint32_t c_min_frac;     // fração de c_min_q8, Q16 (cruzeiro sem deriva)
+    uint64_t ramp_end_q8;    // fim da aceleração
+    uint64_t ramp_end_plan_q8; // ramp_end_q8 na partida
+    // Curva S
+    uint32_t v_peak_q4;      // passos/s Q4
+    uint32_t v_floor_q4;     // piso de velocidade perto do repouso
+    uint32_t vt_q8;          // v_pico * T em passos, Q8
+    uint32_t ramp_q4;        // T em µs Q4
+    uint32_t inv_ramp;       // 2^(30 + ramp_shift) / T, T em µs Q8
+    uint8_t ramp_shift;
+    uint32_t u1_q30;         // fração da rampa no primeiro passo
+    // Estado do movimento em curso
+    uint32_t step;           // passos já agendados
+    uint64_t t_q8;           // instante do último passo agendado
+    uint64_t phase_t0_q8;    // início da desaceleração
+    uint32_t c_q8;           // estado da recorrência do AVR446
+    int32_t n;               // índice do AVR446 (negativo na desaceleração)
+    uint32_t rest;
+    uint32_t u_q30;          // fração da rampa no último passo (curva S)
+    uint32_t du_q30;
+} motion_t;
+
+// Rampa mais longa aceita por motion_plan()
+#define MOTION_MAX_RAMP_S   60
+
+// Planeja steps passos até v_max passos/s com aceleração accel passos/s²
+// (o pico, na curva S). Movimentos curtos não chegam a v_max. Retorna false
+// com parâmetros nulos ou rampa mais longa que MOTION_MAX_RAMP_S.
+bool motion_plan(motion_t *m, motion_profile_t profile, uint32_t steps,
+                 uint32_t v_max, uint32_t accel);
+
+// Velocidade de pico efetivamente alcançada, em passos/s
+uint32_t motion_peak_rate(const motion_t *m);
+
+void motion_start(motion_t *m);
+
+// Instante do próximo passo em µs desde o início (o primeiro é 0);
+// UINT64_MAX depois do último
+uint64_t motion_next_us(motion_t *m);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Oscilador de controle numérico: uma fase de 64 bits avança a palavra de
+// frequência a cada µs (o tick do motor) e cada estouro é um pulso. Em vez de
+// somar tick a tick, o próximo estouro sai direto: com a fase abaixo da
+// palavra depois de cada estouro, o período é q ou q + 1 µs, decidido por uma
+// comparação com o limiar pré-calculado. Sem divisão por pulso, e a taxa
+// média é exata dentro da palavra (~5e-14 Hz).
+//
+// Uma frequência nova vale a partir do último pulso calculado, com a fase
+// contínua: o resto do período em curso é cumprido na frequência nova (uma
+// divisão de 64 bits nessa troca).
+
+typedef struct {
+    uint64_t word;           // ciclos por µs em Q64
+    uint64_t q;              // período curto em µs: (2^64 - 1) / word
+    uint64_t thr;            // fase a partir da qual o período curto basta
+} nco_tuning_t;
+
+typedef struct {
+    nco_tuning_t tune;
+    uint64_t phase;          // fase logo depois do último pulso
+    uint64_t t_us;           // instante do último pulso
+    bool retune;             // tune mudou desde o último pulso
+} nco_t;
+
+// Palavra para mhz milihertz (0 = parado), abaixo de 1 MHz: um pulso por tick
+// já estoura a fase de 64 bits
+void nco_tuning(nco_tuning_t *tune, uint32_t mhz);
+
+// Primeiro pulso em t = 0
+void nco_start(nco_t *n, const nco_tuning_t *tune);
+
+// Troca a frequência sem perder a fase
+void nco_retune(nco_t *n, const nco_tuning_t *tune);
+
+// Instante do próximo estouro em µs desde o início; UINT64_MAX com frequência 0
+uint64_t nco_next_us(nco_t *n);
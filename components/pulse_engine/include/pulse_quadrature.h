@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pulse_attr.h"
+#include "pulse_motion.h"
+
+// Emulação de encoder em quadratura: A e B em sequência Gray (uma só linha
+// muda por contagem) e índice opcional uma vez por volta. A velocidade de
+// cada trecho segue um perfil de pulse_motion.h em contagens/s; trechos em
+// sentidos opostos fazem a reversão, com parada opcional entre eles.
+// Cada trecho parte do repouso e para no repouso: o perfil tem uma posição a
+// mais que as contagens, e a posição inicial não gera transição.
+
+#define QUAD_MAX_SEGMENTS   4
+
+// Níveis das linhas depois de uma contagem
+#define QUAD_LEVEL_A        0x01
+#define QUAD_LEVEL_B        0x02
+#define QUAD_LEVEL_Z        0x04
+
+typedef struct {
+    motion_t profile;        // contagens + 1 posições, do repouso ao repouso
+    bool reverse;            // sentido negativo: B adiantado em relação a A
+} quadrature_segment_t;
+
+typedef struct {
+    quadrature_segment_t seg[QUAD_MAX_SEGMENTS];
+    uint8_t count;           // trechos do programa
+    uint32_t dwell_us;       // parada entre trechos e entre ciclos
+    uint32_t cycles;         // repetições do programa (0 = contínuo)
+    uint32_t counts_per_rev; // contagens entre índices (0 = sem índice)
+    // Estado da execução
+    uint8_t cur;             // trecho em curso
+    uint32_t cycle;
+    uint64_t seg_t0_us;      // repouso de onde o trecho em curso parte
+    uint64_t last_us;        // instante da última contagem
+    int64_t position;        // contagens com sinal desde o início
+    uint32_t rev_phase;      // posição dentro da volta, 0 = índice
+    uint8_t state;           // posição na sequência Gray
+} quadrature_t;
+
+// Define o trecho index (0 a QUAD_MAX_SEGMENTS - 1) com counts contagens até
+// v_max contagens/s; count passa a incluir o trecho. false se motion_plan()
+// recusa o perfil.
+bool quad_segment_set(quadrature_t *q, uint8_t index, motion_profile_t profile, uint32_t counts,
+                      uint32_t v_max, uint32_t accel, bool reverse);
+
+// Maior taxa de contagens do programa, em contagens/s
+uint32_t quad_peak_rate(const quadrature_t *q);
+
+void quad_start(quadrature_t *q);
+
+// Níveis na posição atual (antes da primeira contagem, o estado inicial)
+uint8_t quad_levels(const quadrature_t *q);
+
+// Próxima contagem: instante absoluto em µs e níveis depois dela; false no fim
+bool quad_next(quadrature_t *q, uint64_t *at_us, uint8_t *levels);
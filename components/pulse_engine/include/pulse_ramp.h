@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pulse_attr.h"
+
+// Rampas de partida e parada do intervalo fixo. A taxa sobe em progressão
+// geométrica: cada intervalo é o anterior vezes uma razão fixa, de
+// RAMP_START_RATIO vezes o intervalo pleno até ele, e a descida faz o
+// caminho inverso. O planejamento usa ponto flutuante uma vez; por pulso são
+// só multiplicações (razão e intervalo em Q32, sem divisão), então
+// roda na ISR de borda.
+
+// Taxa no começo da subida e no fim da descida, como fração da plena
+#define RAMP_START_RATIO    16
+
+typedef enum {
+    RAMP_FULL,               // taxa plena, fora das rampas
+    RAMP_UP,
+    RAMP_DOWN
+} ramp_phase_t;
+
+typedef struct {
+    uint32_t up_steps;       // intervalos da subida; 0 = sem
+    uint32_t up_factor_q32;  // razão entre intervalos seguidos (< 1)
+    uint64_t up_start_q32;   // primeiro intervalo da subida, µs Q32
+    uint32_t down_steps;     // intervalos da descida; 0 = sem
+    uint64_t down_factor_q32; // razão na descida (> 1)
+    uint64_t down_end_q32;   // último intervalo da descida
+    uint64_t down_cap_q32;   // a partir daqui o próximo já é o último
+    // Estado da rampa em curso
+    ramp_phase_t phase;
+    uint32_t left;           // intervalos que faltam na fase
+    uint64_t iv_q32;         // próximo intervalo
+    uint32_t frac_q32;       // fração de µs carregada entre intervalos
+} ramp_t;
+
+// Rampas para um intervalo pleno de interval_us, com subida e descida de
+// cerca de up_ms e down_ms (0 = sem). Uma rampa curta demais para caber em
+// 4 intervalos plenos fica desligada; retorna false se nenhuma coube.
+bool ramp_plan(ramp_t *r, uint32_t interval_us, uint32_t up_ms, uint32_t down_ms);
+
+// Começa a subida (partida ou retomada); sem subida planejada fica em RAMP_FULL
+void ramp_up(ramp_t *r);
+
+// Começa a descida a partir do intervalo em curso; false sem descida
+// planejada. Chamada por pulso, também na ISR de borda.
+bool ramp_down(ramp_t *r, uint32_t interval_us);
+
+// Próximo intervalo em µs numa rampa (phase != RAMP_FULL); 0 quando a
+// descida terminou. A subida volta a RAMP_FULL no último intervalo dela.
+uint32_t ramp_next_us(ramp_t *r, uint32_t interval_us);
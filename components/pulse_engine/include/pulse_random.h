@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include "pulse_attr.h"
+
+// Geradores aleatórios do motor. Tudo o que roda por borda é aritmética
+// inteira: xorshift32 + -ln(U) em ponto fixo Q16.
+
+typedef enum {
+    DEADTIME_NONE,
+    DEADTIME_NONPARALYZABLE,
+    DEADTIME_PARALYZABLE
+} deadtime_model_t;
+
+// Processo de Poisson modulado por cadeia de Markov (MMPP) de dois estados.
+// A troca de estado é sorteada a cada pulso, então a fração de pulsos em
+// rajada é p01 / (p01 + p10).
+typedef struct {
+    uint32_t mean_us[2];     // intervalo médio em cada estado (0 = base, 1 = rajada)
+    uint32_t switch_p[2];    // probabilidade de troca por pulso (escala 2^32)
+    uint8_t state;
+    uint64_t next_us;        // instante do último evento gerado
+} mmpp_t;
+
+// Fluxo de Poisson independente; mean_us == 0 desativa o fluxo
+typedef struct {
+    uint32_t rng;
+    uint32_t mean_us;
+    uint64_t next_us;        // próximo evento no tempo de execução
+} random_stream_t;
+
+// Tempo morto de detector aplicado sobre os eventos "verdadeiros" do processo
+typedef struct {
+    deadtime_model_t model;
+    uint32_t tau_us;
+    uint64_t last_true_us;   // último evento verdadeiro (modelo paralisável)
+} deadtime_t;
+
+static inline PULSE_SCHED_IRAM uint32_t rng_next(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Semente não nula do RNG de hardware
+uint32_t rng_seed(void);
+
+// splitmix32: deriva sementes independentes a partir de uma semente do usuário
+uint32_t seed_derive(uint32_t seed, uint32_t index);
+
+// -ln(U) em Q16 para U uniforme em (0, 1]
+uint32_t rng_exp_q16(uint32_t *state);
+
+// Intervalo exponencial com a média pedida
+uint32_t random_exp_us(uint32_t *state, uint32_t mean_us);
+
+// Configura o MMPP para que a taxa média de longo prazo seja a do intervalo pedido
+void mmpp_setup(mmpp_t *m, uint32_t mean_interval_us, int burst_factor,
+                int enter_permille, int leave_permille);
+uint32_t mmpp_next_us(mmpp_t *m, uint32_t *rng);
+
+void random_stream_start(random_stream_t *s);
+
+// Intercala o fluxo comum e o independente; retorna o instante do evento consumido
+uint64_t random_streams_pop(random_stream_t *common, random_stream_t *indep);
+
+// Taxas em eventos/s e tau em s. Não paralisável: m = n / (1 + n tau).
+// Paralisável: m = n e^(-n tau), com máximo 1 / (e tau) em n = 1 / tau.
+double deadtime_observed_rate(double true_rate, double tau_s, deadtime_model_t model);
+
+// Inverso das fórmulas acima (ramo n tau < 1 no paralisável); < 0 se inatingível
+double deadtime_true_rate(double observed_rate, double tau_s, deadtime_model_t model);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pulse_attr.h"
+#include "sdkconfig.h"
+
+// Largura variável por pulso, independente do intervalo: tabela cíclica
+// (dados codificados em PWM), varredura linear em dente de serra ou
+// triângulo, ou sorteio uniforme. Cada largura sai com somas, comparações e,
+// no sorteio, o xorshift32 de pulse_random.h e uma multiplicação de
+// 32 x 32 bits; sem divisão, então roda na ISR de borda.
+
+#define WIDTH_MAX_TABLE     CONFIG_PULSE_WIDTH_TABLE_SIZE
+
+typedef enum {
+    WIDTH_FIXED,             // largura de pulse_duration_ms (sem sequência)
+    WIDTH_TABLE,
+    WIDTH_SWEEP,
+    WIDTH_RANDOM
+} width_source_t;
+
+typedef struct {
+    width_source_t source;
+    uint32_t table[WIDTH_MAX_TABLE]; // larguras em µs, na ordem
+    uint16_t count;
+    uint32_t from_us;        // varredura: primeira largura; sorteio: mínimo
+    uint32_t to_us;          // varredura: última largura; sorteio: máximo
+    uint32_t step_us;        // varredura: incremento por pulso
+    bool triangle;           // varredura: volta descendo em vez de recomeçar
+    uint32_t seed;           // sorteio: semente não nula
+    // Estado da sequência em curso
+    uint16_t index;
+    uint32_t cur_us;
+    bool falling;
+    uint32_t rng;            // estado do xorshift32 (rng_next)
+} width_seq_t;
+
+// Valida a fonte já preenchida: tabela com 1 a WIDTH_MAX_TABLE larguras não
+// nulas, varredura com passo não nulo e limites não nulos, sorteio com
+// 0 < from_us <= to_us
+bool width_setup(const width_seq_t *w);
+
+// Maior largura que a sequência pode dar
+uint32_t width_max_us(const width_seq_t *w);
+
+// Recomeça a sequência do início
+void width_start(width_seq_t *w);
+
+// Largura do próximo pulso em µs
+uint32_t width_next_us(width_seq_t *w);
@@ -0,0 +1,1313 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "sdkconfig.h"
+#if CONFIG_PULSE_EDGE_ISR
+#include "driver/gptimer.h"
+#include "hal/gpio_ll.h"
+#endif
+#if CONFIG_PULSE_WIDTH_SEQ
+#include "esp_random.h"
+#endif
+#include "pulse_attr.h"
+#include "pulse_engine.h"
+
+// ========== CONFIGURAÇÕES ==========
+// Tamanhos vêm do menu "Gerador de pulsos: motor" (Kconfig do componente)
+#define SPIN_WINDOW_US      (portTICK_PERIOD_MS * 1000)
+#define LOG_RING_SIZE       CONFIG_PULSE_LOG_RING_SIZE
+#define PULSE_TASK_STACK    CONFIG_PULSE_TASK_STACK_SIZE
+#define PULSE_TASK_PRIO     CONFIG_PULSE_TASK_PRIORITY
+
+// ========== VARIÁVEIS GLOBAIS ==========
+static pulse_config_t *engine_configs = NULL;
+static int engine_outputs = 0;
+static volatile bool engine_running = false;
+static volatile bool engine_paused = false;
+static int64_t run_start_us = 0;
+static volatile int64_t paused_total_us = 0;
+static int64_t pause_start_us = 0;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Log adiado: as tasks de pulso só enfileiram, quem consome imprime
+static log_record_t log_ring[LOG_RING_SIZE];
+static uint32_t log_head = 0;
+static uint32_t log_tail = 0;
+static uint32_t log_drops = 0;
+
+// Tempo de execução em µs, descontando pausas (base comum a todas as saídas)
+static uint64_t run_time_us(void) {
+    return (uint64_t)(esp_timer_get_time() - run_start_us - paused_total_us);
+}
+
+// ========== CONFIGURAÇÃO ==========
+
+void pulse_config_init(pulse_config_t *config) {
+#if PULSE_RANDOM_ENGINE
+    config->rng = rng_seed();
+#endif
+#if CONFIG_PULSE_MODE_RANDOM
+    config->indep.rng = config->rng;
+    config->indep.mean_us = config->interval_us;
+    config->common.mean_us = 0;
+#endif
+#if CONFIG_PULSE_DEADTIME
+    config->dead.model = DEADTIME_NONE;
+#endif
+#if CONFIG_PULSE_RAMP
+    ramp_plan(&config->ramp, config->interval_us, 0, 0);
+#endif
+#if CONFIG_PULSE_WIDTH_SEQ
+    config->wseq.source = WIDTH_FIXED;
+#endif
+#if CONFIG_PULSE_COUNT_MIRROR
+    config->mirror = NULL;
+#endif
+    config->state = STATE_STOPPED;
+    config->pulse_count = 0;
+    config->task = NULL;
+}
+
+#if CONFIG_PULSE_MODE_RANDOM && PULSE_CHANNELS == 2
+void pulse_coincidence_setup(pulse_config_t *a, pulse_config_t *b, int permille, uint32_t seed) {
+    uint32_t base = seed ? seed : rng_seed();
+    a->indep.rng = seed_derive(base, 1);
+    b->indep.rng = seed_derive(base, 2);
+    if (permille == 0) {
+        return;
+    }
+
+    uint64_t slow_us = (a->indep.mean_us > b->indep.mean_us) ? a->indep.mean_us : b->indep.mean_us;
+    uint64_t common_us = slow_us * 1000u / (uint32_t)permille;
+    if (common_us > UINT32_MAX) common_us = UINT32_MAX;
+    pulse_config_t *outs[2] = {a, b};
+
+    for (int i = 0; i < 2; i++) {
+        uint64_t own_us = outs[i]->indep.mean_us;
+        outs[i]->common.rng = seed_derive(base, 0);
+        outs[i]->common.mean_us = (uint32_t)common_us;
+        // 1/m_ind = 1/m - 1/m_comum
+        uint64_t indep_us = (common_us > own_us) ? own_us * common_us / (common_us - own_us) : 0;
+        outs[i]->indep.mean_us = (indep_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)indep_us;
+    }
+}
+#endif
+
+#if CONFIG_PULSE_DEADTIME
+bool pulse_deadtime_apply(pulse_config_t *config, double *true_rate) {
+    deadtime_t *d = &config->dead;
+    double observed = 1e6 / (double)config->interval_us;
+    *true_rate = observed;
+    if (d->model == DEADTIME_NONE) {
+        return true;
+    }
+
+    double n = deadtime_true_rate(observed, d->tau_us * 1e-6, d->model);
+    if (n <= 0.0) {
+        return false;
+    }
+
+#if CONFIG_PULSE_MODE_RANDOM
+    if (config->mode == MODE_RANDOM) {
+        // O fluxo comum é o mesmo nas duas saídas: só o próprio completa a taxa
+        double common = config->common.mean_us ? 1e6 / config->common.mean_us : 0.0;
+        if (n <= common) {
+            return false;
+        }
+        double indep_us = 1e6 / (n - common);
+        config->indep.mean_us = (indep_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)indep_us;
+    }
+#endif
+#if CONFIG_PULSE_MODE_BURST
+    if (config->mode == MODE_BURST) {
+        double scale = observed / n;
+        for (int i = 0; i < 2; i++) {
+            config->mmpp.mean_us[i] = (uint32_t)(config->mmpp.mean_us[i] * scale);
+        }
+    }
+#endif
+    *true_rate = n;
+    return true;
+}
+#endif
+
+#if CONFIG_PULSE_MODE_REPLAY
+void pulse_replay_select(pulse_config_t *config, const pattern_lib_t *lib,
+                         const pattern_entry_t *entry, uint32_t scale_permille) {
+    config->replay.lib = lib;
+    config->replay.entry = entry;
+    config->replay.scale_permille = scale_permille;
+    uint64_t mean_us = entry->duration_us * scale_permille / 1000u / entry->event_count;
+    config->interval_us = (mean_us < 1u) ? 1u : (mean_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)mean_us;
+}
+#endif
+
+#if CONFIG_PULSE_MODE_MOTION
+bool pulse_motion_select(pulse_config_t *config, motion_profile_t profile, uint32_t steps,
+                         uint32_t v_max, uint32_t accel, uint32_t step_width_us) {
+    if (!motion_plan(&config->motion, profile, steps, v_max, accel)) {
+        return false;
+    }
+    config->step_width_us = step_width_us;
+    config->max_pulses = steps;
+    config->interval_us = 1000000u / motion_peak_rate(&config->motion);
+    return true;
+}
+
+void pulse_engine_dir_set(int gpio, bool level) {
+    gpio_reset_pin(gpio);
+    gpio_set_direction(gpio, GPIO_MODE_OUTPUT);
+    gpio_set_level(gpio, level);
+}
+#endif
+
+#if CONFIG_PULSE_MODE_QUADRATURE
+void pulse_quadrature_select(pulse_config_t *config, int gpio_b, int gpio_z) {
+    config->gpio_b = gpio_b;
+    config->gpio_z = gpio_z;
+    config->width_us = 0;
+    config->max_pulses = 0;
+    config->interval_us = 1000000u / quad_peak_rate(&config->quad);
+
+    int pins[] = {gpio_b, gpio_z};
+    for (size_t i = 0; i < sizeof(pins) / sizeof(pins[0]); i++) {
+        if (pins[i] >= 0) {
+            gpio_reset_pin(pins[i]);
+            gpio_set_direction(pins[i], GPIO_MODE_OUTPUT);
+        }
+    }
+}
+#endif
+
+#if CONFIG_PULSE_MODE_METER
+bool pulse_meter_select(pulse_config_t *config, uint16_t count, uint32_t imp_per_kwh, bool repeat) {
+    if (!meter_setup(&config->meter, count, imp_per_kwh, repeat)) {
+        return false;
+    }
+    uint32_t peak = meter_peak_rate(&config->meter);
+    config->max_pulses = 0;
+    config->interval_us = peak ? 1000000u / peak : UINT32_MAX;
+    return true;
+}
+#endif
+
+#if CONFIG_PULSE_MODE_NCO
+void pulse_nco_select(pulse_config_t *config, uint32_t mhz) {
+    nco_tuning(&config->nco_tune, mhz);
+    uint64_t interval_us = 1000000000ull / mhz;
+    config->interval_us = (interval_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)interval_us;
+}
+#endif
+
+#if CONFIG_PULSE_RAMP
+bool pulse_ramp_select(pulse_config_t *config, uint32_t up_ms, uint32_t down_ms) {
+    return ramp_plan(&config->ramp, config->interval_us, up_ms, down_ms);
+}
+#endif
+
+#if CONFIG_PULSE_WIDTH_SEQ
+bool pulse_width_select(pulse_config_t *config) {
+    width_seq_t *w = &config->wseq;
+    if (!width_setup(w) || (config->mode != MODE_DEFINED && config->mode != MODE_NCO) ||
+        width_max_us(w) >= config->interval_us) {
+        return false;
+    }
+    if (w->source == WIDTH_RANDOM && w->seed == 0) {
+        w->seed = esp_random() | 1u;
+    }
+    return true;
+}
+#endif
+
+// ========== AGENDAMENTO ==========
+
+#if PULSE_RANDOM_ENGINE
+static PULSE_SCHED_IRAM uint64_t next_true_event_us(pulse_config_t *config) {
+#if CONFIG_PULSE_MODE_BURST
+    if (config->mode == MODE_BURST) {
+        config->mmpp.next_us += mmpp_next_us(&config->mmpp, &config->rng);
+        return config->mmpp.next_us;
+    }
+#endif
+#if CONFIG_PULSE_MODE_RANDOM
+    return random_streams_pop(&config->common, &config->indep);
+#else
+    return UINT64_MAX;
+#endif
+}
+
+// Descarta os eventos verdadeiros que caem no tempo morto do último pulso
+static PULSE_SCHED_IRAM uint64_t next_observed_event_us(pulse_config_t *config) {
+    uint64_t t = next_true_event_us(config);
+#if CONFIG_PULSE_DEADTIME
+    deadtime_t *d = &config->dead;
+
+    switch (d->model) {
+    case DEADTIME_NONPARALYZABLE:
+        while (t < config->next_due_us + d->tau_us) {
+            t = next_true_event_us(config);
+        }
+        break;
+    case DEADTIME_PARALYZABLE:
+        while (t - d->last_true_us < d->tau_us) {
+            d->last_true_us = t;
+            t = next_true_event_us(config);
+        }
+        d->last_true_us = t;
+        break;
+    default:
+        break;
+    }
+#endif
+    return t;
+}
+#endif // PULSE_RANDOM_ENGINE
+
+#if CONFIG_PULSE_MODE_REPLAY
+// Lê o próximo evento do padrão: avança o prazo e define a largura do pulso
+static void replay_next(pulse_config_t *config, uint64_t from_us) {
+    uint64_t delta;
+    uint32_t width;
+
+    if (!pattern_cursor_next(&config->replay.cur, &delta, &width)) {
+        config->next_due_us = UINT64_MAX;
+        return;
+    }
+    config->next_due_us = from_us + delta * config->replay.scale_permille / 1000u;
+    config->width_us = width ? width : (uint32_t)config->pulse_duration_ms * 1000u;
+}
+#endif
+
+#if CONFIG_PULSE_MODE_MOTION
+// O perfil dá instantes absolutos; o prazo avança pela diferença para a
+// política de refase poder deslocar a grade
+static PULSE_SCHED_IRAM void motion_step(pulse_config_t *config) {
+    uint64_t prev_us = (config->motion.t_q8 + 128u) >> 8;
+    uint64_t t_us = motion_next_us(&config->motion);
+    config->next_due_us = (t_us == UINT64_MAX) ? UINT64_MAX : config->next_due_us + (t_us - prev_us);
+}
+#endif
+
+#if CONFIG_PULSE_MODE_QUADRATURE
+// Mesmo esquema do motion_step(), com os níveis da contagem
+static PULSE_SCHED_IRAM void quad_step(pulse_config_t *config) {
+    uint64_t prev_us = config->quad.last_us;
+    uint64_t t_us;
+
+    if (!quad_next(&config->quad, &t_us, &config->levels)) {
+        config->next_due_us = UINT64_MAX;
+        return;
+    }
+    config->next_due_us += t_us - prev_us;
+}
+#endif
+
+#if CONFIG_PULSE_MODE_METER
+// Mesmo esquema do motion_step(); a divisão de 64 bits fica fora da ISR
+// porque o modo exige a fila de prazos junto com PULSE_EDGE_ISR
+static void meter_step(pulse_config_t *config) {
+    uint64_t prev_us = config->meter.t_us;
+    uint64_t t_us = meter_next_us(&config->meter);
+    config->next_due_us = (t_us == UINT64_MAX) ? UINT64_MAX : config->next_due_us + (t_us - prev_us);
+}
+#endif
+
+#if CONFIG_PULSE_MODE_NCO
+static void nco_step(pulse_config_t *config) {
+    uint64_t prev_us = config->nco.t_us;
+    uint64_t t_us = nco_next_us(&config->nco);
+    config->next_due_us = (t_us == UINT64_MAX) ? UINT64_MAX : config->next_due_us + (t_us - prev_us);
+}
+#endif
+
+static void schedule_first(pulse_config_t *config) {
+    config->width_us = (uint32_t)config->pulse_duration_ms * 1000u;
+
+    switch (config->mode) {
+#if CONFIG_PULSE_MODE_RANDOM
+    case MODE_RANDOM:
+        random_stream_start(&config->common);
+        random_stream_start(&config->indep);
+        config->next_due_us = random_streams_pop(&config->common, &config->indep);
+        break;
+#endif
+#if CONFIG_PULSE_MODE_BURST
+    case MODE_BURST:
+        config->mmpp.next_us = 0;
+        config->next_due_us = 0;
+        break;
+#endif
+#if CONFIG_PULSE_MODE_REPLAY
+    case MODE_REPLAY:
+        pattern_cursor_init(&config->replay.cur, config->replay.lib, config->replay.entry);
+        replay_next(config, 0);
+        break;
+#endif
+#if CONFIG_PULSE_MODE_MOTION
+    case MODE_MOTION:
+        config->width_us = config->step_width_us;
+        motion_start(&config->motion);
+        config->next_due_us = motion_next_us(&config->motion);
+        break;
+#endif
+#if CONFIG_PULSE_MODE_QUADRATURE
+    case MODE_QUADRATURE:
+        quad_start(&config->quad);
+        config->next_due_us = 0;
+        quad_step(config);
+        break;
+#endif
+#if CONFIG_PULSE_MODE_NCO
+    case MODE_NCO:
+        nco_start(&config->nco, &config->nco_tune);
+        config->next_due_us = 0;
+        break;
+#endif
+#if CONFIG_PULSE_MODE_METER
+    case MODE_METER:
+        meter_start(&config->meter);
+        config->next_due_us = meter_next_us(&config->meter);
+        break;
+#endif
+    default:
+        config->next_due_us = 0;
+        break;
+    }
+#if CONFIG_PULSE_DEADTIME
+    config->dead.last_true_us = config->next_due_us;
+#endif
+#if CONFIG_PULSE_WIDTH_SEQ
+    if (config->wseq.source != WIDTH_FIXED) {
+        width_start(&config->wseq);
+        config->width_us = width_next_us(&config->wseq);
+    }
+#endif
+}
+
+// Desloca todos os instantes pendentes (usado pela política de refase).
+// Com coincidências, a saída refaseada deixa de coincidir com a outra.
+// Com a fila de prazos, a ISR acumula o deslocamento e o gerador não muda.
+#if !CONFIG_PULSE_LOOKAHEAD
+static PULSE_SCHED_IRAM void schedule_shift(pulse_config_t *config, uint64_t delta_us) {
+    uint64_t *pending[] = {
+        &config->next_due_us,
+#if CONFIG_PULSE_MODE_RANDOM
+        &config->common.next_us, &config->indep.next_us,
+#endif
+#if CONFIG_PULSE_MODE_BURST
+        &config->mmpp.next_us,
+#endif
+#if CONFIG_PULSE_DEADTIME
+        &config->dead.last_true_us,
+#endif
+    };
+    for (size_t i = 0; i < sizeof(pending) / sizeof(pending[0]); i++) {
+        if (*pending[i] != UINT64_MAX) {
+            *pending[i] += delta_us;
+        }
+    }
+}
+#endif
+
+#if CONFIG_PULSE_RAMP
+// Intervalo fixo com rampas. Com max_pulses a descida começa quando os
+// prazos que faltam cabem nela, então o último pulso é o do limite; o fim
+// pedido começa a descida no próximo prazo. Prazos pulados por
+// DEADLINE_SKIP não contam no limite: antes da descida eles a adiam, e os
+// pulados nela são repostos depois dela, no intervalo mais lento.
+static PULSE_SCHED_IRAM void ramp_step(pulse_config_t *config) {
+    ramp_t *r = &config->ramp;
+
+    portENTER_CRITICAL_SAFE(&stats_lock);
+    uint64_t limit = config->max_pulses + config->stats.skipped;
+    portEXIT_CRITICAL_SAFE(&stats_lock);
+
+    if (r->phase != RAMP_DOWN) {
+        uint64_t left = limit - config->ramp_count;
+        if (config->finishing) {
+            if (!ramp_down(r, config->interval_us)) {
+                config->next_due_us = UINT64_MAX;
+                return;
+            }
+        } else if (config->max_pulses != 0 && config->ramp_count < limit &&
+                   left <= r->down_steps &&
+                   (r->phase != RAMP_UP || left <= r->up_steps - r->left) &&
+                   ramp_down(r, config->interval_us)) {
+            if (left < r->left) r->left = (uint32_t)left;
+        }
+    }
+    config->ramp_count++;
+
+    if (r->phase == RAMP_FULL) {
+        config->next_due_us += config->interval_us;
+        return;
+    }
+    uint32_t dt_us = ramp_next_us(r, config->interval_us);
+    if (dt_us == 0 && config->max_pulses != 0 && !config->finishing &&
+        config->ramp_count <= limit) {
+        dt_us = (uint32_t)(r->iv_q32 >> 32);
+    }
+    config->next_due_us = dt_us ? config->next_due_us + dt_us : UINT64_MAX;
+}
+#endif
+
+// Mudança confirmada entra quando o prazo recém-calculado alcança o instante
+// combinado: a largura desse pulso ainda não foi copiada para a fila ou para
+// o timer, e o intervalo seguinte parte dele com o valor novo
+static PULSE_SCHED_IRAM void staged_apply(pulse_config_t *config) {
+    if (!config->staged_armed) {
+        return;
+    }
+    portENTER_CRITICAL_SAFE(&stats_lock);
+    bool due = config->staged_armed && config->next_due_us >= config->staged_at_us;
+    pulse_change_t change = config->staged;
+    if (due) {
+        config->staged_armed = false;
+    }
+    portEXIT_CRITICAL_SAFE(&stats_lock);
+    if (!due) {
+        return;
+    }
+
+    if (change.interval_us) {
+        config->interval_us = change.interval_us;
+    }
+    if (change.width_us) {
+        config->width_us = change.width_us;
+    }
+#if CONFIG_PULSE_MODE_NCO
+    // NCO exige a fila de prazos junto com a ISR, então aqui é contexto de task
+    if (change.mhz) {
+        nco_tuning_t tune;
+        nco_tuning(&tune, change.mhz);
+        nco_retune(&config->nco, &tune);
+        config->interval_us = (tune.q > UINT32_MAX) ? UINT32_MAX : (uint32_t)tune.q;
+    }
+#endif
+}
+
+static PULSE_SCHED_IRAM void schedule_next(pulse_config_t *config) {
+    switch (config->mode) {
+#if CONFIG_PULSE_MODE_RANDOM
+    case MODE_RANDOM:
+#endif
+#if CONFIG_PULSE_MODE_BURST
+    case MODE_BURST:
+#endif
+#if PULSE_RANDOM_ENGINE
+        config->next_due_us = next_observed_event_us(config);
+        break;
+#endif
+#if CONFIG_PULSE_MODE_REPLAY
+    case MODE_REPLAY:
+        replay_next(config, config->next_due_us);
+        break;
+#endif
+#if CONFIG_PULSE_MODE_MOTION
+    case MODE_MOTION:
+        motion_step(config);
+        break;
+#endif
+#if CONFIG_PULSE_MODE_QUADRATURE
+    case MODE_QUADRATURE:
+        quad_step(config);
+        break;
+#endif
+#if CONFIG_PULSE_MODE_METER
+    case MODE_METER:
+        meter_step(config);
+        break;
+#endif
+#if CONFIG_PULSE_MODE_NCO
+    case MODE_NCO:
+        nco_step(config);
+        break;
+#endif
+    default:
+#if CONFIG_PULSE_RAMP
+        ramp_step(config);
+#else
+        config->next_due_us += config->interval_us;
+#endif
+        break;
+    }
+#if CONFIG_PULSE_WIDTH_SEQ
+    if (config->wseq.source != WIDTH_FIXED) {
+        config->width_us = width_next_us(&config->wseq);
+    }
+#endif
+#if CONFIG_PULSE_RAMP
+    // Os outros modos não têm descida: o fim pedido corta no próximo prazo
+    if (config->finishing && config->mode != MODE_DEFINED) {
+        config->next_due_us = UINT64_MAX;
+    }
+#endif
+    staged_apply(config);
+}
+
+void pulse_sequence_start(pulse_config_t *config) {
+    config->pulse_count = 0;
+    config->next_due_us = 0;
+    config->staged_set = false;
+    config->staged_armed = false;
+#if CONFIG_PULSE_RAMP
+    config->ramp_count = 1;
+    config->finishing = false;
+    ramp_up(&config->ramp);
+#endif
+    memset(&config->stats, 0, sizeof(config->stats));
+    schedule_first(config);
+}
+
+bool pulse_sequence_next(pulse_config_t *config, uint64_t *due_us, uint32_t *width_us) {
+    if (config->next_due_us == UINT64_MAX ||
+        (config->max_pulses != 0 && config->pulse_count >= config->max_pulses)) {
+        return false;
+    }
+    *due_us = config->next_due_us;
+    *width_us = config->width_us;
+
+    portENTER_CRITICAL(&stats_lock);
+    config->pulse_count++;
+    portEXIT_CRITICAL(&stats_lock);
+
+    schedule_next(config);
+    return true;
+}
+
+// ========== LOG ADIADO E ESTATÍSTICAS ==========
+
+static PULSE_IRAM void log_push(const log_record_t *rec) {
+    portENTER_CRITICAL_SAFE(&stats_lock);
+    if (log_head - log_tail < LOG_RING_SIZE) {
+        log_ring[log_head % LOG_RING_SIZE] = *rec;
+        log_head++;
+    } else {
+        log_drops++;
+    }
+    portEXIT_CRITICAL_SAFE(&stats_lock);
+}
+
+// Tempo de execução para o relógio do boot, o mesmo das linhas de log e do
+// uptime do status; pausas só mudam o deslocamento enquanto nada pulsa
+static PULSE_IRAM uint64_t boot_time_us(uint64_t run_us) {
+    return run_us + (uint64_t)(run_start_us + paused_total_us);
+}
+
+static PULSE_IRAM void log_pulse(uint8_t channel, uint64_t count, uint64_t start_us) {
+    log_record_t rec = {.channel = channel, .count = count, .at_us = boot_time_us(start_us)};
+    log_push(&rec);
+}
+
+bool pulse_engine_log_pop(log_record_t *rec) {
+    portENTER_CRITICAL(&stats_lock);
+    bool empty = (log_tail == log_head);
+    if (!empty) {
+        *rec = log_ring[log_tail % LOG_RING_SIZE];
+        log_tail++;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+    return !empty;
+}
+
+// Conta o pulso emitido e registra atraso, erro de largura e custo do agendamento
+static PULSE_IRAM void stats_record(pulse_config_t *config, uint64_t late_us, uint32_t width_err_us,
+                         uint32_t edge_cycles) {
+    pulse_stats_t *st = &config->stats;
+    uint32_t late = (late_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)late_us;
+
+    portENTER_CRITICAL_SAFE(&stats_lock);
+    config->pulse_count++;
+#if CONFIG_PULSE_COUNT_MIRROR
+    if (config->mirror) {
+        uint64_t count = config->pulse_count;
+        config->mirror->slot[count & 1].count = count;
+        config->mirror->slot[count & 1].check = ~count;
+    }
+#endif
+    st->samples++;
+    st->late_sum_us += late;
+    if (late > st->late_max_us) st->late_max_us = late;
+    st->width_err_sum_us += width_err_us;
+    if (width_err_us > st->width_err_max_us) st->width_err_max_us = width_err_us;
+    st->edge_cycles_sum += edge_cycles;
+    if (edge_cycles > st->edge_cycles_max) st->edge_cycles_max = edge_cycles;
+    portEXIT_CRITICAL_SAFE(&stats_lock);
+}
+
+static PULSE_IRAM void deadline_missed(pulse_config_t *config, uint64_t now_us, uint64_t late_us) {
+    log_record_t rec = {
+        .channel = (uint8_t)(config - engine_configs),
+        .missed = true,
+        .count = config->pulse_count + 1,
+        .late_us = (late_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)late_us,
+        .at_us = boot_time_us(now_us),
+    };
+
+    portENTER_CRITICAL_SAFE(&stats_lock);
+    config->stats.missed++;
+    if (config->deadline.policy == DEADLINE_SKIP) config->stats.skipped++;
+    config->stats.last_missed_us = now_us;
+    portEXIT_CRITICAL_SAFE(&stats_lock);
+
+    log_push(&rec);
+}
+
+// Fotografia do estado sem parar a geração: só copia contadores sob o lock
+void pulse_engine_snapshot(pulse_engine_status_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->running = engine_running;
+    out->paused = engine_paused;
+    out->run_time_us = engine_running ? run_time_us() : 0;
+    out->channel_count = engine_outputs;
+
+    portENTER_CRITICAL(&stats_lock);
+    out->log_drops = log_drops;
+    portEXIT_CRITICAL(&stats_lock);
+
+    for (int i = 0; i < engine_outputs; i++) {
+        pulse_config_t *config = &engine_configs[i];
+        pulse_channel_status_t *ch = &out->channels[i];
+
+        portENTER_CRITICAL(&stats_lock);
+        ch->stats = config->stats;
+        ch->pulse_count = config->pulse_count;
+        ch->state = config->state;
+        ch->stack_free = config->task ?
+            uxTaskGetStackHighWaterMark(config->task) * sizeof(StackType_t) : 0;
+        portEXIT_CRITICAL(&stats_lock);
+
+        ch->mode = config->mode;
+    }
+}
+
+// ========== MUDANÇAS DURANTE A GERAÇÃO ==========
+
+bool pulse_engine_stage(int channel, const pulse_change_t *change) {
+    if (!engine_running || channel < 0 || channel >= engine_outputs) {
+        return false;
+    }
+    pulse_config_t *config = &engine_configs[channel];
+    uint32_t interval_us = config->interval_us;
+
+    if (change->interval_us) {
+        if (config->mode != MODE_DEFINED) return false;
+        interval_us = change->interval_us;
+    }
+    if (change->mhz) {
+#if CONFIG_PULSE_MODE_NCO
+        if (config->mode != MODE_NCO) return false;
+        uint64_t period_us = 1000000000ull / change->mhz;
+        interval_us = (period_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)period_us;
+#else
+        return false;
+#endif
+    }
+    // Replay tira a largura do padrão; a quadratura não tem largura
+    if (change->width_us && (config->mode == MODE_REPLAY || config->mode == MODE_QUADRATURE)) {
+        return false;
+    }
+    // A largura em vigor depois da troca, com a folga, tem de caber no
+    // intervalo em vigor: nem pulso cortado nem pulsos emendados
+    uint32_t width_us = change->width_us ? change->width_us : config->width_us;
+#if CONFIG_PULSE_WIDTH_SEQ
+    if (config->wseq.source != WIDTH_FIXED) {
+        if (change->width_us) return false; // a largura vem da sequência
+        width_us = width_max_us(&config->wseq);
+    }
+#endif
+    if ((config->mode == MODE_DEFINED || config->mode == MODE_NCO) &&
+        (width_us >= interval_us || interval_us - width_us < config->min_gap_us)) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    config->staged = *change;
+    config->staged_set = true;
+    config->staged_armed = false;
+    portEXIT_CRITICAL(&stats_lock);
+    return true;
+}
+
+// No C3 de um núcleo, dentro da seção crítica nem a ISR nem a task de pulso
+// (de prioridade maior que o console) estão no meio de uma escrita de
+// next_due_us, então o instante combinado é consistente
+int pulse_engine_commit(uint32_t mask, bool together) {
+    uint64_t at_us = 0;
+    int armed = 0;
+
+    portENTER_CRITICAL(&stats_lock);
+    for (int i = 0; together && i < engine_outputs; i++) {
+        uint64_t next_us = engine_configs[i].next_due_us;
+        if ((mask & (1u << i)) && engine_configs[i].staged_set && next_us != UINT64_MAX &&
+            next_us + 1u > at_us) {
+            at_us = next_us + 1u;
+        }
+    }
+    for (int i = 0; i < engine_outputs; i++) {
+        pulse_config_t *config = &engine_configs[i];
+        if ((mask & (1u << i)) && config->staged_set) {
+            config->staged_at_us = at_us;
+            config->staged_set = false;
+            config->staged_armed = true;
+            armed++;
+        }
+    }
+    portEXIT_CRITICAL(&stats_lock);
+    return armed;
+}
+
+#if CONFIG_PULSE_MODE_NCO
+bool pulse_engine_set_frequency(int channel, uint32_t mhz) {
+    pulse_change_t change = {.mhz = mhz};
+    return pulse_engine_stage(channel, &change) && pulse_engine_commit(1u << channel, false) == 1;
+}
+#endif
+
+void pulse_engine_reset_stats(void) {
+    for (int i = 0; i < engine_outputs; i++) {
+        portENTER_CRITICAL(&stats_lock);
+        memset(&engine_configs[i].stats, 0, sizeof(engine_configs[i].stats));
+        portEXIT_CRITICAL(&stats_lock);
+    }
+}
+
+// ========== TASK DE PULSO ==========
+
+// Na quadratura as linhas guardam a posição: sem nível ocioso nem pisca de fim
+static inline bool quad_mode(const pulse_config_t *config) {
+#if CONFIG_PULSE_MODE_QUADRATURE
+    return config->mode == MODE_QUADRATURE;
+#else
+    (void)config;
+    return false;
+#endif
+}
+
+#if CONFIG_PULSE_MODE_QUADRATURE
+// A, B e índice na mesma borda, em sequência: a fase entre eles não escorrega
+static PULSE_IRAM void quad_write(const pulse_config_t *config, uint8_t levels) {
+#if CONFIG_PULSE_EDGE_ISR
+    gpio_ll_set_level(&GPIO, config->gpio, levels & QUAD_LEVEL_A);
+    gpio_ll_set_level(&GPIO, config->gpio_b, (levels & QUAD_LEVEL_B) != 0);
+    if (config->gpio_z >= 0) {
+        gpio_ll_set_level(&GPIO, config->gpio_z, (levels & QUAD_LEVEL_Z) != 0);
+    }
+#else
+    gpio_set_level(config->gpio, levels & QUAD_LEVEL_A);
+    gpio_set_level(config->gpio_b, (levels & QUAD_LEVEL_B) != 0);
+    if (config->gpio_z >= 0) {
+        gpio_set_level(config->gpio_z, (levels & QUAD_LEVEL_Z) != 0);
+    }
+#endif
+}
+#endif
+
+#if CONFIG_PULSE_EDGE_ISR
+// ========== BORDAS POR INTERRUPÇÃO ==========
+// Um gptimer de 1 MHz por saída conta o tempo de execução da saída (fica
+// parado durante a pausa) e o alarme marca a próxima borda. A ISR e tudo o
+// que ela chama estão em IRAM, então as bordas saem no horário mesmo com o
+// cache da flash desligado por uma gravação na NVS.
+
+#if CONFIG_PULSE_LOOKAHEAD
+// Fila de prazos: a task de pulso calcula os próximos K prazos e a ISR só
+// retira o da frente, com o mesmo custo em qualquer modo. Produtor único
+// (task) e consumidor único (ISR); no C3 de um núcleo basta a barreira do
+// compilador entre escrever o slot e publicá-lo.
+#define LOOKAHEAD_DEPTH     CONFIG_PULSE_LOOKAHEAD_DEPTH
+#define LOOKAHEAD_REFILL    CONFIG_PULSE_LOOKAHEAD_REFILL
+
+_Static_assert(LOOKAHEAD_REFILL < LOOKAHEAD_DEPTH,
+               "PULSE_LOOKAHEAD_REFILL deve ser menor que PULSE_LOOKAHEAD_DEPTH");
+
+typedef struct {
+    uint64_t due_us;
+    uint32_t width_us;
+#if CONFIG_PULSE_MODE_QUADRATURE
+    uint8_t levels;
+#endif
+} edge_slot_t;
+#endif
+
+typedef struct {
+    gptimer_handle_t timer;
+    TaskHandle_t waiter;     // task de pulso da saída
+    volatile bool finished;  // ISR terminou a saída
+    bool low;                // pulso em andamento
+    uint64_t due_us;         // prazo da próxima borda de descida
+    uint32_t width_us;       // largura desse pulso
+    uint64_t fall_us;        // instante real da borda de descida
+    uint64_t late_us;        // atraso dessa borda em relação ao prazo
+#if CONFIG_PULSE_MODE_QUADRATURE
+    uint8_t levels;          // níveis da contagem nesse prazo
+#endif
+#if CONFIG_PULSE_LOOKAHEAD
+    edge_slot_t fifo[LOOKAHEAD_DEPTH];
+    volatile uint32_t head;  // escrito só pela task
+    volatile uint32_t tail;  // escrito pela ISR, ou pela task com a saída parada
+    uint64_t queued;         // prazos já enfileirados
+    volatile bool last_queued; // o gerador não tem mais prazos
+    volatile bool starved;   // a ISR achou a fila vazia e parou
+    uint64_t shift_us;       // deslocamento acumulado pela política de refase
+#endif
+} edge_timer_t;
+
+static edge_timer_t edge_timers[PULSE_CHANNELS];
+
+#if CONFIG_PULSE_LOOKAHEAD
+// Calcula prazos até encher a fila. Com limite de pulsos, os pulados pela
+// política de prazo não contam, então o limite acompanha stats.skipped.
+static void edge_refill(pulse_config_t *config, edge_timer_t *et) {
+    portENTER_CRITICAL(&stats_lock);
+    uint64_t limit = config->max_pulses + config->stats.skipped;
+    portEXIT_CRITICAL(&stats_lock);
+
+    while (et->head - et->tail < LOOKAHEAD_DEPTH &&
+           (config->max_pulses == 0 || et->queued < limit)) {
+        if (config->next_due_us == UINT64_MAX) {
+            et->last_queued = true;
+            return;
+        }
+        edge_slot_t *slot = &et->fifo[et->head % LOOKAHEAD_DEPTH];
+        slot->due_us = config->next_due_us;
+        slot->width_us = config->width_us;
+#if CONFIG_PULSE_MODE_QUADRATURE
+        slot->levels = config->levels;
+#endif
+        __asm__ __volatile__("" ::: "memory");
+        et->head++;
+        et->queued++;
+        schedule_next(config);
+    }
+}
+
+static PULSE_IRAM uint32_t edge_pop(edge_timer_t *et) {
+    uint32_t fill = et->head - et->tail;
+    if (fill == 0) {
+        return UINT32_MAX;
+    }
+    const edge_slot_t *slot = &et->fifo[et->tail % LOOKAHEAD_DEPTH];
+    et->due_us = slot->due_us + et->shift_us;
+    et->width_us = slot->width_us;
+#if CONFIG_PULSE_MODE_QUADRATURE
+    et->levels = slot->levels;
+#endif
+    et->tail++;
+    return fill - 1;
+}
+
+static PULSE_IRAM void stats_fifo(pulse_config_t *config, uint32_t left, bool underrun) {
+    uint32_t drain = LOOKAHEAD_DEPTH - left;
+
+    portENTER_CRITICAL_SAFE(&stats_lock);
+    if (drain > config->stats.fifo_drain_max) config->stats.fifo_drain_max = drain;
+    if (underrun) config->stats.underruns++;
+    portEXIT_CRITICAL_SAFE(&stats_lock);
+}
+#endif
+
+// Avança para o próximo prazo; false se não há um pronto
+static PULSE_IRAM bool edge_advance(pulse_config_t *config, edge_timer_t *et, BaseType_t *woken) {
+#if CONFIG_PULSE_LOOKAHEAD
+    uint32_t left = edge_pop(et);
+    if (left == UINT32_MAX) {
+        return false;
+    }
+    stats_fifo(config, left, false);
+    if (left <= LOOKAHEAD_REFILL) {
+        vTaskNotifyGiveFromISR(et->waiter, woken);
+    }
+    return true;
+#else
+    schedule_next(config);
+    et->due_us = config->next_due_us;
+    et->width_us = config->width_us;
+#if CONFIG_PULSE_MODE_QUADRATURE
+    et->levels = config->levels;
+#endif
+    return et->due_us != UINT64_MAX;
+#endif
+}
+
+// Alarme já vencido dispara na hora, então um prazo perdido vira atraso medido
+static PULSE_IRAM void edge_arm(edge_timer_t *et, uint64_t at_us) {
+    gptimer_alarm_config_t alarm = {.alarm_count = at_us};
+    gptimer_set_alarm_action(et->timer, &alarm);
+}
+
+// Arma a próxima borda, termina a saída ou, com a fila vazia, espera a task
+static PULSE_IRAM bool edge_continue(pulse_config_t *config, edge_timer_t *et, bool ready,
+                                     BaseType_t *woken) {
+    bool done = !engine_running ||
+                (config->max_pulses != 0 && config->pulse_count >= config->max_pulses);
+#if CONFIG_PULSE_LOOKAHEAD
+    if (!done && !ready && !et->last_queued) {
+        stats_fifo(config, 0, true);
+        et->starved = true;
+        vTaskNotifyGiveFromISR(et->waiter, woken);
+        return *woken == pdTRUE;
+    }
+#endif
+    if (done || !ready) {
+        et->finished = true;
+        vTaskNotifyGiveFromISR(et->waiter, woken);
+        return *woken == pdTRUE;
+    }
+    edge_arm(et, et->due_us);
+    return *woken == pdTRUE;
+}
+
+static PULSE_IRAM bool edge_isr(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata,
+                                void *ctx) {
+    pulse_config_t *config = (pulse_config_t *)ctx;
+    edge_timer_t *et = &edge_timers[config - engine_configs];
+    uint64_t now_us = edata->count_value;
+    BaseType_t woken = pdFALSE;
+
+    if (et->low) {
+        gpio_ll_set_level(&GPIO, config->gpio, 1);
+        et->low = false;
+
+        uint64_t width = now_us - et->fall_us;
+        uint64_t width_err = (width > et->width_us) ? width - et->width_us
+                                                    : et->width_us - width;
+        uint32_t c0 = esp_cpu_get_cycle_count();
+        bool ready = edge_advance(config, et, &woken);
+        uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+
+        stats_record(config, et->late_us, (uint32_t)width_err, cycles);
+        log_pulse((uint8_t)(config - engine_configs), config->pulse_count, et->fall_us);
+        return edge_continue(config, et, ready, &woken);
+    }
+
+    uint64_t late_us = (now_us > et->due_us) ? now_us - et->due_us : 0;
+    if (late_us > config->deadline.tolerance_us) {
+        deadline_missed(config, now_us, late_us);
+        if (config->deadline.policy == DEADLINE_SKIP) {
+            return edge_continue(config, et, edge_advance(config, et, &woken), &woken);
+        }
+        if (config->deadline.policy == DEADLINE_REPHASE) {
+#if CONFIG_PULSE_LOOKAHEAD
+            et->shift_us += late_us;
+#else
+            schedule_shift(config, late_us);
+#endif
+            et->due_us += late_us;
+        }
+    }
+
+#if CONFIG_PULSE_MODE_QUADRATURE
+    // Uma contagem por alarme, sem borda de subida
+    if (config->mode == MODE_QUADRATURE) {
+        quad_write(config, et->levels);
+        uint32_t c0 = esp_cpu_get_cycle_count();
+        bool ready = edge_advance(config, et, &woken);
+        uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+
+        stats_record(config, late_us, 0, cycles);
+        log_pulse((uint8_t)(config - engine_configs), config->pulse_count, now_us);
+        return edge_continue(config, et, ready, &woken);
+    }
+#endif
+
+    gpio_ll_set_level(&GPIO, config->gpio, 0);
+    et->low = true;
+    et->fall_us = now_us;
+    et->late_us = late_us;
+    edge_arm(et, now_us + et->width_us);
+    return false;
+}
+
+// A task prepara o timer e depois só espera a ISR: avisos de fim e, com a
+// fila de prazos, pedidos de reabastecimento
+static void pulse_run(pulse_config_t *config) {
+    edge_timer_t *et = &edge_timers[config - engine_configs];
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,
+    };
+    gptimer_event_callbacks_t cbs = {.on_alarm = edge_isr};
+
+    memset(et, 0, sizeof(*et));
+    et->waiter = xTaskGetCurrentTaskHandle();
+#if CONFIG_PULSE_LOOKAHEAD
+    edge_refill(config, et);
+    if (edge_pop(et) == UINT32_MAX) {
+        return;
+    }
+#else
+    if (config->next_due_us == UINT64_MAX) {
+        return;
+    }
+    et->due_us = config->next_due_us;
+    et->width_us = config->width_us;
+#if CONFIG_PULSE_MODE_QUADRATURE
+    et->levels = config->levels;
+#endif
+#endif
+
+    ESP_ERROR_CHECK(gptimer_new_timer(&timer_config, &et->timer));
+    ESP_ERROR_CHECK(gptimer_register_event_callbacks(et->timer, &cbs, config));
+    ESP_ERROR_CHECK(gptimer_enable(et->timer));
+    ESP_ERROR_CHECK(gptimer_set_raw_count(et->timer, run_time_us()));
+    edge_arm(et, et->due_us);
+    if (config->state == STATE_RUNNING) {
+        gptimer_start(et->timer);
+    }
+
+    while (engine_running && !et->finished) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+#if CONFIG_PULSE_LOOKAHEAD
+        edge_refill(config, et);
+        // Com a fila vazia a ISR está parada, então a task pode consumir e rearmar
+        if (et->starved && !et->finished) {
+            if (edge_pop(et) != UINT32_MAX) {
+                et->starved = false;
+                edge_arm(et, et->due_us);
+            } else if (et->last_queued) {
+                et->finished = true;
+            }
+        }
+#endif
+    }
+
+    gptimer_stop(et->timer);
+    gptimer_disable(et->timer);
+    gptimer_del_timer(et->timer);
+    et->timer = NULL;
+    if (!quad_mode(config)) {
+        gpio_set_level(config->gpio, 1);
+    }
+}
+
+// Para/retoma todos os timers juntos para as saídas não se defasarem
+static void edge_timers_pause(bool paused) {
+    for (int i = 0; i < engine_outputs; i++) {
+        if (edge_timers[i].timer && engine_configs[i].state != STATE_STOPPED) {
+            if (paused) {
+                gptimer_stop(edge_timers[i].timer);
+            } else {
+                gptimer_start(edge_timers[i].timer);
+            }
+        }
+    }
+}
+
+#else
+
+// Ticks inteiros com vTaskDelay e o resto em espera ativa
+static uint32_t generate_pulse(int gpio, uint32_t width_us) {
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us = start_us + width_us;
+    gpio_set_level(gpio, 0);
+    if (width_us >= SPIN_WINDOW_US) {
+        vTaskDelay(pdMS_TO_TICKS(width_us / 1000u) - 1);
+    }
+    while (esp_timer_get_time() < end_us) {
+    }
+    gpio_set_level(gpio, 1);
+    return (uint32_t)(esp_timer_get_time() - start_us);
+}
+
+static bool pulse_done(const pulse_config_t *config) {
+    return !engine_running || config->next_due_us == UINT64_MAX ||
+           (config->max_pulses != 0 && config->pulse_count >= config->max_pulses);
+}
+
+static void pulse_run(pulse_config_t *config) {
+    while (!pulse_done(config)) {
+        // Verificar se está pausado
+        if (config->state == STATE_PAUSED) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+
+        // Verifica se é hora do próximo pulso; dentro do último tick espera
+        // ativamente para acertar o instante com resolução de µs
+        uint64_t now_us = run_time_us();
+        if (now_us + SPIN_WINDOW_US >= config->next_due_us) {
+            while ((now_us = run_time_us()) < config->next_due_us) {
+            }
+
+            uint64_t late_us = now_us - config->next_due_us;
+            if (late_us > config->deadline.tolerance_us) {
+                deadline_missed(config, now_us, late_us);
+                if (config->deadline.policy == DEADLINE_SKIP) {
+                    schedule_next(config);
+                    continue;
+                }
+                if (config->deadline.policy == DEADLINE_REPHASE) {
+                    schedule_shift(config, late_us);
+                }
+            }
+
+            uint32_t width = config->width_us;
+#if CONFIG_PULSE_MODE_QUADRATURE
+            if (config->mode == MODE_QUADRATURE) {
+                quad_write(config, config->levels);
+            } else
+#endif
+            width = generate_pulse(config->gpio, config->width_us);
+            uint32_t width_err = (width > config->width_us) ? width - config->width_us
+                                                            : config->width_us - width;
+            uint32_t c0 = esp_cpu_get_cycle_count();
+            schedule_next(config);
+            uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+
+            stats_record(config, late_us, width_err, cycles);
+            log_pulse((uint8_t)(config - engine_configs), config->pulse_count, now_us);
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(1)); // Delay mínimo para não sobrecarregar
+    }
+}
+#endif // CONFIG_PULSE_EDGE_ISR
+
+static void pulse_task(void *pvParameter) {
+    pulse_config_t *config = (pulse_config_t *)pvParameter;
+
+    if (!config) {
+        vTaskDelete(NULL);
+        return;
+    }
+
+    // Configuração inicial
+#if CONFIG_PULSE_MODE_QUADRATURE
+    if (config->mode == MODE_QUADRATURE) {
+        quad_start(&config->quad);
+        quad_write(config, quad_levels(&config->quad));
+    } else
+#endif
+    gpio_set_level(config->gpio, 1);
+    pulse_sequence_start(config);
+
+    pulse_run(config);
+
+    portENTER_CRITICAL(&stats_lock);
+    config->state = STATE_STOPPED;
+    config->task = NULL;
+    portEXIT_CRITICAL(&stats_lock);
+
+    // Sinalização visual de fim
+    for (int i = 0; i < 3 && !quad_mode(config); i++) {
+        gpio_set_level(config->gpio, 0);
+        vTaskDelay(pdMS_TO_TICKS(100));
+        gpio_set_level(config->gpio, 1);
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+
+    vTaskDelete(NULL);
+}
+
+// ========== CONTROLE DE EXECUÇÃO ==========
+
+void pulse_engine_gpio_init(int gpio) {
+    gpio_reset_pin(gpio);
+    gpio_set_direction(gpio, GPIO_MODE_OUTPUT);
+    gpio_set_level(gpio, 1);
+}
+
+void pulse_engine_start(pulse_config_t *configs, int count) {
+    static const char *task_names[] = {"pulse_1", "pulse_2"};
+
+    engine_configs = configs;
+    engine_outputs = count;
+    run_start_us = esp_timer_get_time();
+    paused_total_us = 0;
+    engine_paused = false;
+    log_head = log_tail = log_drops = 0;
+    engine_running = true;
+
+    for (int i = 0; i < count; i++) {
+        configs[i].state = STATE_RUNNING;
+        xTaskCreate(pulse_task, task_names[i], PULSE_TASK_STACK, &configs[i],
+                    PULSE_TASK_PRIO, &configs[i].task);
+    }
+}
+
+void pulse_engine_stop(void) {
+    engine_running = false;
+}
+
+#if CONFIG_PULSE_RAMP
+void pulse_engine_finish(void) {
+    if (engine_paused) {
+        pulse_engine_stop();
+        return;
+    }
+    for (int i = 0; i < engine_outputs; i++) {
+        engine_configs[i].finishing = true;
+    }
+}
+
+// Na retomada a subida recomeça logo depois do prazo já armado. Com a fila
+// de prazos, os enfileirados na taxa plena são descartados e recalculados
+// na rampa: o timer está parado e, com o escalonador suspenso, a task de
+// pulso não reabastece ao mesmo tempo.
+static void ramp_resume(pulse_config_t *config, int channel) {
+    if (config->mode != MODE_DEFINED || config->ramp.up_steps == 0 ||
+        config->ramp.phase == RAMP_DOWN || config->finishing || config->state == STATE_STOPPED) {
+        return;
+    }
+#if CONFIG_PULSE_LOOKAHEAD
+    edge_timer_t *et = &edge_timers[channel];
+    if (!et->timer || et->starved || et->last_queued) {
+        return;
+    }
+    vTaskSuspendAll();
+    uint32_t dropped = et->head - et->tail;
+    et->head = et->tail;
+    et->queued -= dropped;
+    config->ramp_count -= dropped + 1u;
+    config->next_due_us = et->due_us - et->shift_us;
+    ramp_up(&config->ramp);
+    schedule_next(config);
+    edge_refill(config, et);
+    xTaskResumeAll();
+#else
+    (void)channel;
+    portENTER_CRITICAL(&stats_lock);
+    ramp_up(&config->ramp);
+    portEXIT_CRITICAL(&stats_lock);
+#endif
+}
+#endif
+
+bool pulse_engine_toggle_pause(void) {
+    engine_paused = !engine_paused;
+    int64_t now_us = esp_timer_get_time();
+
+    if (engine_paused) {
+        pause_start_us = now_us;
+    } else {
+        paused_total_us += now_us - pause_start_us;
+#if CONFIG_PULSE_RAMP
+        for (int i = 0; i < engine_outputs; i++) {
+            ramp_resume(&engine_configs[i], i);
+        }
+#endif
+    }
+#if CONFIG_PULSE_EDGE_ISR
+    edge_timers_pause(engine_paused);
+#endif
+    for (int i = 0; i < engine_outputs; i++) {
+        if (engine_configs[i].state != STATE_STOPPED) {
+            engine_configs[i].state = engine_paused ? STATE_PAUSED : STATE_RUNNING;
+        }
+    }
+    return engine_paused;
+}
+
+bool pulse_engine_busy(void) {
+    for (int i = 0; i < engine_outputs; i++) {
+        if (engine_configs[i].state != STATE_STOPPED) {
+            return true;
+        }
+    }
+    return false;
+}
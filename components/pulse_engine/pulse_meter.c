@@ -0,0 +1,117 @@
+#include "pulse_meter.h"
+
+bool meter_setup(meter_t *m, uint16_t count, uint32_t imp_per_kwh, bool repeat) {
+    if (count < 2 || count > METER_MAX_POINTS || imp_per_kwh == 0 || m->points[0].t_ms != 0) {
+        return false;
+    }
+    uint32_t peak_mw = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        if (m->points[i].power_mw > METER_MAX_POWER_MW ||
+            (i > 0 && m->points[i].t_ms <= m->points[i - 1].t_ms)) {
+            return false;
+        }
+        if (m->points[i].power_mw > peak_mw) {
+            peak_mw = m->points[i].power_mw;
+        }
+    }
+    // Repetir um perfil sem energia nunca daria pulso; e a taxa por µs de
+    // uma fatia tem de ficar abaixo da energia de um pulso (< 1e6 pulsos/s)
+    if ((repeat && peak_mw == 0) ||
+        2u * (uint64_t)peak_mw * imp_per_kwh >= METER_PULSE_ENERGY) {
+        return false;
+    }
+    m->count = count;
+    m->imp_per_kwh = imp_per_kwh;
+    m->repeat = repeat;
+    return true;
+}
+
+uint32_t meter_peak_rate(const meter_t *m) {
+    uint32_t peak_mw = 0;
+    for (uint16_t i = 0; i < m->count; i++) {
+        if (m->points[i].power_mw > peak_mw) {
+            peak_mw = m->points[i].power_mw;
+        }
+    }
+    // P[mW] × N / 3,6e9 pulsos/s
+    uint64_t rate = ((uint64_t)peak_mw * m->imp_per_kwh + 3599999999ull) / 3600000000ull;
+    return (rate > UINT32_MAX) ? UINT32_MAX : (uint32_t)rate;
+}
+
+double meter_energy_wh(const meter_t *m) {
+    double mw_ms = 0;
+    for (uint16_t i = 1; i < m->count; i++) {
+        const meter_point_t *a = &m->points[i - 1];
+        const meter_point_t *b = &m->points[i];
+        mw_ms += ((double)a->power_mw + b->power_mw) / 2.0 * (b->t_ms - a->t_ms);
+    }
+    return mw_ms / 3.6e9;
+}
+
+void meter_start(meter_t *m) {
+    m->seg = 0;
+    m->origin_us = 0;
+    m->t_us = 0;
+    m->slice_end_us = 0;
+    m->rate = 0;
+    m->phase = 0;
+}
+
+// Potência em mW no instante t_ms do trecho a-b; |dP| × t cabe em 64 bits
+// pelo limite de METER_MAX_POWER_MW
+static uint64_t meter_power(const meter_point_t *a, const meter_point_t *b, uint32_t t_ms) {
+    int64_t dp = (int64_t)b->power_mw - (int64_t)a->power_mw;
+    return (uint64_t)((int64_t)a->power_mw +
+                      dp * (int64_t)(t_ms - a->t_ms) / (int64_t)(b->t_ms - a->t_ms));
+}
+
+// Próxima fatia a partir de t_us; false no fim do perfil sem repetição.
+// Fatias e pontos caem em ms inteiros, então a posição no perfil também.
+static bool slice_begin(meter_t *m) {
+    uint32_t tp_ms = (uint32_t)((m->t_us - m->origin_us) / 1000u);
+
+    while (m->seg + 1 < m->count && m->points[m->seg + 1].t_ms <= tp_ms) {
+        m->seg++;
+    }
+    if (m->seg + 1 == m->count) {
+        if (!m->repeat) {
+            return false;
+        }
+        m->origin_us = m->t_us;
+        m->seg = 0;
+        tp_ms = 0;
+    }
+
+    const meter_point_t *a = &m->points[m->seg];
+    const meter_point_t *b = a + 1;
+    uint32_t end_ms = b->t_ms;
+    if (end_ms - tp_ms > CONFIG_PULSE_METER_SLICE_MS) {
+        end_ms = tp_ms + CONFIG_PULSE_METER_SLICE_MS;
+    }
+    m->slice_end_us = m->origin_us + (uint64_t)end_ms * 1000u;
+    m->rate = (meter_power(a, b, tp_ms) + meter_power(a, b, end_ms)) * m->imp_per_kwh;
+    return true;
+}
+
+// O resto de energia de cada pulso fica no acumulador, então arredondar o
+// instante para µs não acumula erro. O acúmulo nunca passa de
+// METER_PULSE_ENERGY + rate, folgado em 64 bits.
+uint64_t meter_next_us(meter_t *m) {
+    for (;;) {
+        if (m->t_us == m->slice_end_us && !slice_begin(m)) {
+            return UINT64_MAX;
+        }
+        uint64_t left_us = m->slice_end_us - m->t_us;
+        if (m->rate) {
+            uint64_t need = METER_PULSE_ENERGY - m->phase;
+            uint64_t dt_us = (need + m->rate - 1) / m->rate;
+            if (dt_us <= left_us) {
+                m->t_us += dt_us;
+                m->phase = m->phase + m->rate * dt_us - METER_PULSE_ENERGY;
+                return m->t_us;
+            }
+        }
+        m->phase += m->rate * left_us;
+        m->t_us = m->slice_end_us;
+    }
+}
@@ -0,0 +1,240 @@
+#include <math.h>
+#include "pulse_motion.h"
+
+// ========== CONFIGURAÇÕES ==========
+#define TICKS_PER_S         256000000.0      // µs Q8
+#define Q4_TICKS            4096000000u      // 256e6 * 16: v Q4 -> intervalo Q8
+#define AVR446_C0_Q16       44302u           // 0,676 em Q16, sem ponto flutuante na ISR
+#define U_ONE               (1u << 30)
+#define NEWTON_ITERATIONS   2
+#define NEWTON_START_STEPS  16               // perto do repouso u ~ k^(1/3): mais iterações
+#define NEWTON_START_ITER   4
+#define NEWTON_MAX_ERR_Q16  (16u << 16)      // passo de Newton limitado a 16 passos
+
+// ========== PLANEJAMENTO ==========
+
+// Posição normalizada da curva S: p(u) = ∫s = u³ - u⁴/2 (em v_pico T)
+static double scurve_position(double u) {
+    return u * u * u - u * u * u * u / 2.0;
+}
+
+// Fração da rampa no primeiro passo saindo do repouso: p(u) v T = 1
+static double scurve_first_u(double vt) {
+    double target = 1.0 / vt;
+    double u = cbrt(target);
+    for (int i = 0; i < 4 && u < 1.0; i++) {
+        u -= (scurve_position(u) - target) / (3.0 * u * u - 2.0 * u * u * u);
+    }
+    return (u > 1.0) ? 1.0 : u;
+}
+
+bool motion_plan(motion_t *m, motion_profile_t profile, uint32_t steps,
+                 uint32_t v_max, uint32_t accel) {
+    if (steps == 0 || v_max == 0 || accel == 0) {
+        return false;
+    }
+    double half = (steps - 1) / 2.0;
+    double v = v_max;
+    double a = accel;
+    // Trapézio: v² = 2 a n. Curva S: a rampa de T = 1,5 v / a percorre 0,75 v² / a
+    double k = (profile == MOTION_TRAPEZOID) ? 0.5 : 0.75;
+    double ramp = k * v * v / a;
+    if (ramp > half) {
+        ramp = half;
+        v = sqrt(ramp * a / k);
+    }
+    if (v < 1.0) {
+        v = 1.0;
+    }
+    double ramp_s = (profile == MOTION_TRAPEZOID) ? v / a : 1.5 * v / a;
+    if (ramp_s > MOTION_MAX_RAMP_S) {
+        return false;
+    }
+
+    m->profile = profile;
+    m->steps = steps;
+    m->ramp_q16 = (uint64_t)(ramp * 65536.0);
+    m->ramp_steps = (uint32_t)(m->ramp_q16 >> 16);
+    if (profile == MOTION_TRAPEZOID) {
+        // O AVR446 anda em passos inteiros; o cruzeiro parte do último deles
+        m->ramp_q16 = (uint64_t)m->ramp_steps << 16;
+    }
+    double c_min = TICKS_PER_S / v;
+    m->c_min_q8 = (uint32_t)c_min;
+    m->c_min_frac = (uint32_t)((c_min - m->c_min_q8) * 65536.0);
+
+    if (profile == MOTION_TRAPEZOID) {
+        m->c0_q8 = (uint32_t)(sqrt(2.0 / a) * TICKS_PER_S);
+        // O cruzeiro passa pela posição x em x / v + v / 2a; com rampa de
+        // um passo ele parte do primeiro, dado por c_0
+        m->ramp_end_plan_q8 = (m->ramp_steps == 0) ? (uint64_t)(v / (2.0 * a) * TICKS_PER_S) :
+                              (m->ramp_steps == 1) ? m->c0_q8 : 0;
+        return true;
+    }
+
+    double ramp_q8 = ramp_s * TICKS_PER_S;
+    double u1 = scurve_first_u(v * ramp_s);
+    m->ramp_end_plan_q8 = (uint64_t)ramp_q8;
+    m->v_peak_q4 = (uint32_t)(v * 16.0);
+    m->v_floor_q4 = (uint32_t)(m->v_peak_q4 * (3.0 * u1 * u1 - 2.0 * u1 * u1 * u1)) + 1;
+    m->vt_q8 = (uint32_t)(v * ramp_s * 256.0);
+    m->ramp_q4 = (uint32_t)(ramp_q8 / 16.0);
+    m->u1_q30 = (uint32_t)(u1 * U_ONE);
+    // inv_ramp em [2^27, 2^28): o produto com um intervalo Q8 (< 2^34) cabe em 64 bits
+    m->ramp_shift = 0;
+    while (ldexp(1.0, 30 + m->ramp_shift) / ramp_q8 < 134217728.0 && m->ramp_shift < 32) {
+        m->ramp_shift++;
+    }
+    m->inv_ramp = (uint32_t)(ldexp(1.0, 30 + m->ramp_shift) / ramp_q8);
+    return true;
+}
+
+uint32_t motion_peak_rate(const motion_t *m) {
+    return (uint32_t)(256000000u / m->c_min_q8);
+}
+
+PULSE_SCHED_IRAM void motion_start(motion_t *m) {
+    // O trapézio com rampa de 2 passos ou mais o recalcula no fim dela
+    m->ramp_end_q8 = m->ramp_end_plan_q8;
+    m->step = 0;
+    m->t_q8 = 0;
+    m->phase_t0_q8 = 0;
+    m->c_q8 = (uint32_t)(((uint64_t)m->c0_q8 * AVR446_C0_Q16) >> 16);
+    m->n = 0;
+    m->rest = 0;
+    m->u_q30 = 0;
+    m->du_q30 = m->u1_q30;
+}
+
+// ========== POR PASSO ==========
+
+// Instante em que o cruzeiro passa pela posição x (passos Q16, x >= rampa)
+static PULSE_SCHED_IRAM uint64_t cruise_time(const motion_t *m, uint64_t x_q16) {
+    uint64_t d = x_q16 - m->ramp_q16;
+    uint64_t whole = d >> 16;
+    uint64_t frac = d & 0xFFFFu;
+    return m->ramp_end_q8 + whole * m->c_min_q8 + ((whole * m->c_min_frac) >> 16) +
+           ((frac * m->c_min_q8) >> 16);
+}
+
+static PULSE_SCHED_IRAM uint32_t avr446_interval(motion_t *m) {
+    int32_t c = (int32_t)m->c_q8;
+    int32_t num = 2 * c + (int32_t)m->rest;
+    int32_t den = 4 * m->n + 1;
+    c -= num / den;
+    m->rest = (uint32_t)(num % den);
+    if (c < (int32_t)m->c_min_q8) c = (int32_t)m->c_min_q8;
+    return (uint32_t)c;
+}
+
+// Passo k do trapézio: AVR446 nas rampas, cruzeiro direto do índice
+static PULSE_SCHED_IRAM uint64_t trapezoid_step(motion_t *m, uint32_t k) {
+    uint32_t n_ramp = m->ramp_steps;
+    // Sem rampa o último passo é o único que desacelera
+    uint32_t decel_from = m->steps - 1 - (n_ramp ? n_ramp : 1);
+
+    if (k <= n_ramp) {
+        if (k == 1) {
+            return m->c0_q8;
+        }
+        m->n++;
+        m->c_q8 = avr446_interval(m);
+        if (k == n_ramp) {
+            m->ramp_end_q8 = m->t_q8 + m->c_q8;
+        }
+        return m->t_q8 + m->c_q8;
+    }
+    if (k <= decel_from) {
+        return cruise_time(m, (uint64_t)k << 16);
+    }
+    if (n_ramp == 0) {
+        return cruise_time(m, (uint64_t)k << 16) + m->ramp_end_q8;
+    }
+    if (k == decel_from + 1) {
+        m->n = -(int32_t)n_ramp;
+        m->rest = 0;
+    }
+    m->c_q8 = avr446_interval(m);
+    m->n++;
+    return m->t_q8 + ((m->n == 0) ? m->c0_q8 : m->c_q8);
+}
+
+// Posição (passos Q16) e velocidade (Q4) na fração u da rampa
+static PULSE_SCHED_IRAM int64_t scurve_eval(const motion_t *m, uint32_t u, bool decel, uint32_t *v_q4) {
+    uint64_t u2 = ((uint64_t)u * u) >> 30;
+    uint64_t u3 = (u2 * u) >> 30;
+    uint64_t u4 = (u2 * u2) >> 30;
+    uint64_t p = u3 - u4 / 2;
+    uint64_t s = 3 * u2 - 2 * u3;
+    if (decel) {
+        p = u - p;
+        s = U_ONE - s;
+    }
+    uint32_t v = (uint32_t)(((uint64_t)m->v_peak_q4 * s) >> 30);
+    *v_q4 = (v < m->v_floor_q4) ? m->v_floor_q4 : v;
+    return (int64_t)(((uint64_t)m->vt_q8 * p) >> 22);
+}
+
+// Newton em p(u) = x a partir da extrapolação do passo anterior
+static PULSE_SCHED_IRAM uint32_t scurve_solve(motion_t *m, int64_t x_q16, bool decel, int iterations) {
+    uint32_t u = m->u_q30 + m->du_q30;
+    if (u > U_ONE) u = U_ONE;
+
+    for (int i = 0; i < iterations; i++) {
+        uint32_t v;
+        int64_t err = scurve_eval(m, u, decel, &v) - x_q16;
+        uint64_t mag = (uint64_t)(err < 0 ? -err : err);
+        if (mag > NEWTON_MAX_ERR_Q16) mag = NEWTON_MAX_ERR_Q16;
+        // du = erro / p'(u) = erro * intervalo / T
+        uint64_t dt = (mag * (Q4_TICKS / v)) >> 16;
+        if (dt > m->ramp_end_q8) dt = m->ramp_end_q8;
+        uint32_t du = (uint32_t)((dt * m->inv_ramp) >> m->ramp_shift);
+        if (err > 0) {
+            u = (du > u) ? 0 : u - du;
+        } else {
+            u = (du > U_ONE - u) ? U_ONE : u + du;
+        }
+    }
+    return u;
+}
+
+// Passo k da curva S: Newton nas rampas, cruzeiro direto do índice
+static PULSE_SCHED_IRAM uint64_t scurve_step(motion_t *m, uint32_t k) {
+    uint64_t x = (uint64_t)k << 16;
+    uint64_t decel_q16 = ((uint64_t)(m->steps - 1) << 16) - m->ramp_q16;
+    uint32_t u;
+    uint64_t t0;
+    bool decel = x > decel_q16;
+
+    if (x < m->ramp_q16) {
+        u = (k == 1) ? m->u1_q30 :
+            scurve_solve(m, (int64_t)x, false, (k < NEWTON_START_STEPS) ? NEWTON_START_ITER : NEWTON_ITERATIONS);
+        t0 = 0;
+    } else if (!decel) {
+        return cruise_time(m, x);
+    } else {
+        if (m->phase_t0_q8 == 0) {
+            m->phase_t0_q8 = cruise_time(m, decel_q16);
+            m->u_q30 = 0;
+        }
+        x -= decel_q16;
+        uint32_t left = m->steps - 1 - k;
+        u = (x >= m->ramp_q16) ? U_ONE :
+            scurve_solve(m, (int64_t)x, true, (left < NEWTON_START_STEPS) ? NEWTON_START_ITER : NEWTON_ITERATIONS);
+        t0 = m->phase_t0_q8;
+    }
+    m->du_q30 = u - m->u_q30;
+    m->u_q30 = u;
+    return t0 + (((uint64_t)u * m->ramp_q4) >> 26);
+}
+
+PULSE_SCHED_IRAM uint64_t motion_next_us(motion_t *m) {
+    if (m->step >= m->steps) {
+        return UINT64_MAX;
+    }
+    uint32_t k = m->step++;
+    if (k > 0) {
+        m->t_q8 = (m->profile == MOTION_TRAPEZOID) ? trapezoid_step(m, k) : scurve_step(m, k);
+    }
+    return (m->t_q8 + 128u) >> 8;
+}
@@ -0,0 +1,41 @@
+#include "pulse_nco.h"
+
+void nco_tuning(nco_tuning_t *tune, uint32_t mhz) {
+    // 2^64 / 1e9 = 18446744073,709551616 por mHz, sem ponto flutuante
+    tune->word = (uint64_t)mhz * 18446744073ull + (uint64_t)mhz * 709551616ull / 1000000000ull;
+    tune->q = tune->word ? UINT64_MAX / tune->word : 0;
+    tune->thr = 0u - tune->word * tune->q;
+}
+
+void nco_start(nco_t *n, const nco_tuning_t *tune) {
+    n->tune = *tune;
+    n->phase = 0;
+    n->t_us = 0;
+    n->retune = false;
+}
+
+void nco_retune(nco_t *n, const nco_tuning_t *tune) {
+    n->tune = *tune;
+    n->retune = true;
+}
+
+// Depois de um estouro a fase fica abaixo da palavra, então o próximo vem em
+// q ou q + 1 µs. Logo após uma troca a fase veio da palavra antiga e o
+// período sai da divisão: o menor dt com fase + word × dt >= 2^64.
+uint64_t nco_next_us(nco_t *n) {
+    const nco_tuning_t *tune = &n->tune;
+    uint64_t dt_us;
+
+    if (tune->word == 0) {
+        return UINT64_MAX;
+    }
+    if (n->retune) {
+        dt_us = ~n->phase / tune->word + 1u;
+        n->retune = false;
+    } else {
+        dt_us = (n->phase >= tune->thr) ? tune->q : tune->q + 1u;
+    }
+    n->phase += tune->word * dt_us;
+    n->t_us += dt_us;
+    return n->t_us;
+}
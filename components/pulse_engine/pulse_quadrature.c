@@ -0,0 +1,86 @@
+#include "pulse_quadrature.h"
+
+// Sequência Gray no sentido positivo: A sobe antes de B
+static PULSE_SCHED_DRAM const uint8_t quad_gray[4] = {
+    0, QUAD_LEVEL_A, QUAD_LEVEL_A | QUAD_LEVEL_B, QUAD_LEVEL_B
+};
+
+bool quad_segment_set(quadrature_t *q, uint8_t index, motion_profile_t profile, uint32_t counts,
+                      uint32_t v_max, uint32_t accel, bool reverse) {
+    if (index >= QUAD_MAX_SEGMENTS || counts == 0 || counts == UINT32_MAX ||
+        !motion_plan(&q->seg[index].profile, profile, counts + 1, v_max, accel)) {
+        return false;
+    }
+    q->seg[index].reverse = reverse;
+    q->count = index + 1;
+    return true;
+}
+
+uint32_t quad_peak_rate(const quadrature_t *q) {
+    uint32_t peak = 0;
+    for (uint8_t i = 0; i < q->count; i++) {
+        uint32_t rate = motion_peak_rate(&q->seg[i].profile);
+        if (rate > peak) {
+            peak = rate;
+        }
+    }
+    return peak;
+}
+
+// Começa um trecho no repouso: a posição 0 do perfil não é contagem
+static PULSE_SCHED_IRAM void segment_begin(quadrature_t *q, uint64_t t0_us) {
+    motion_t *m = &q->seg[q->cur].profile;
+    motion_start(m);
+    motion_next_us(m);
+    q->seg_t0_us = t0_us;
+}
+
+void quad_start(quadrature_t *q) {
+    q->cur = 0;
+    q->cycle = 0;
+    q->last_us = 0;
+    q->position = 0;
+    q->rev_phase = 0;
+    q->state = 0;
+    segment_begin(q, 0);
+}
+
+PULSE_SCHED_IRAM uint8_t quad_levels(const quadrature_t *q) {
+    uint8_t levels = quad_gray[q->state];
+    if (q->counts_per_rev && q->rev_phase == 0) {
+        levels |= QUAD_LEVEL_Z;
+    }
+    return levels;
+}
+
+PULSE_SCHED_IRAM bool quad_next(quadrature_t *q, uint64_t *at_us, uint8_t *levels) {
+    uint64_t t_us = motion_next_us(&q->seg[q->cur].profile);
+
+    // Fim do trecho: o próximo parte do repouso depois da parada
+    if (t_us == UINT64_MAX) {
+        if (++q->cur == q->count) {
+            q->cur = 0;
+            if (q->cycles && ++q->cycle >= q->cycles) {
+                return false;
+            }
+        }
+        segment_begin(q, q->last_us + q->dwell_us);
+        t_us = motion_next_us(&q->seg[q->cur].profile);
+    }
+
+    if (q->seg[q->cur].reverse) {
+        q->state = (q->state + 3) & 3;
+        q->position--;
+        q->rev_phase = (q->rev_phase ? q->rev_phase : q->counts_per_rev) - 1;
+    } else {
+        q->state = (q->state + 1) & 3;
+        q->position++;
+        if (++q->rev_phase >= q->counts_per_rev) {
+            q->rev_phase = 0;
+        }
+    }
+    q->last_us = q->seg_t0_us + t_us;
+    *at_us = q->last_us;
+    *levels = quad_levels(q);
+    return true;
+}
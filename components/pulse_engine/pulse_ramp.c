@@ -0,0 +1,113 @@
+#include <math.h>
+#include "pulse_ramp.h"
+
+// ========== PLANEJAMENTO ==========
+
+// Rampa de ramp_us entre o intervalo inicial i0 (metade da rampa, no máximo
+// RAMP_START_RATIO vezes o pleno) e o pleno. A soma dos N intervalos i0,
+// i0 g, ..., i0 g^(N-1) com i0 g^N = pleno é (i0 - pleno) / (1 - g), o que dá
+// g para a duração pedida; N sai arredondado e g é recalculado para o último
+// passo cair exato no pleno.
+static uint32_t ramp_steps(double ramp_us, double interval_us, double *ratio, double *start_us) {
+    double start = ramp_us / 2.0;
+    if (start > RAMP_START_RATIO * interval_us) {
+        start = RAMP_START_RATIO * interval_us;
+    }
+    if (start < 2.0 * interval_us) {
+        return 0;
+    }
+    double g = 1.0 - (start - interval_us) / ramp_us;
+    double n = round(log(start / interval_us) / -log(g));
+    if (n < 1.0) {
+        n = 1.0;
+    }
+    *ratio = pow(interval_us / start, 1.0 / n);
+    *start_us = start;
+    return (uint32_t)n;
+}
+
+bool ramp_plan(ramp_t *r, uint32_t interval_us, uint32_t up_ms, uint32_t down_ms) {
+    double g;
+    double start_us;
+
+    r->phase = RAMP_FULL;
+    r->left = 0;
+    r->up_steps = ramp_steps(up_ms * 1000.0, interval_us, &g, &start_us);
+    if (r->up_steps) {
+        double factor = ldexp(g, 32);
+        r->up_factor_q32 = (factor >= 4294967295.0) ? UINT32_MAX : (uint32_t)factor;
+        r->up_start_q32 = (uint64_t)ldexp(start_us, 32);
+    }
+    r->down_steps = ramp_steps(down_ms * 1000.0, interval_us, &g, &start_us);
+    if (r->down_steps) {
+        r->down_factor_q32 = (uint64_t)ldexp(1.0 / g, 32);
+        r->down_end_q32 = (uint64_t)ldexp(start_us, 32);
+        r->down_cap_q32 = (uint64_t)ldexp(start_us * g, 32);
+    }
+    return r->up_steps || r->down_steps;
+}
+
+void ramp_up(ramp_t *r) {
+    if (r->up_steps == 0) {
+        r->phase = RAMP_FULL;
+        return;
+    }
+    r->phase = RAMP_UP;
+    r->left = r->up_steps;
+    r->iv_q32 = r->up_start_q32;
+    r->frac_q32 = 0;
+}
+
+PULSE_SCHED_IRAM bool ramp_down(ramp_t *r, uint32_t interval_us) {
+    if (r->down_steps == 0) {
+        return false;
+    }
+    uint64_t full_q32 = (uint64_t)interval_us << 32;
+    // No meio da subida a descida parte de onde ela parou
+    if (r->phase != RAMP_UP || r->iv_q32 < full_q32) {
+        r->iv_q32 = full_q32;
+    }
+    r->phase = RAMP_DOWN;
+    // Já mais lento que o fim da descida: termina no próximo limite
+    r->left = (full_q32 >= r->down_end_q32) ? 0 : r->down_steps;
+    return true;
+}
+
+// ========== POR PULSO ==========
+
+// x * f / 2^32 arredondado, com x < 2^61 e o resultado também, em
+// multiplicações de 32 bits
+static PULSE_SCHED_IRAM uint64_t mul_q32(uint64_t x, uint64_t f) {
+    uint32_t xl = (uint32_t)x;
+    uint32_t xh = (uint32_t)(x >> 32);
+    uint32_t fl = (uint32_t)f;
+    uint32_t fh = (uint32_t)(f >> 32);
+    return (((uint64_t)xh * fh) << 32) + (uint64_t)xh * fl + (uint64_t)xl * fh +
+           (((uint64_t)xl * fl + 0x80000000u) >> 32);
+}
+
+PULSE_SCHED_IRAM uint32_t ramp_next_us(ramp_t *r, uint32_t interval_us) {
+    if (r->phase == RAMP_DOWN) {
+        if (r->left == 0) {
+            return 0;
+        }
+        r->iv_q32 = (r->iv_q32 >= r->down_cap_q32) ? r->down_end_q32
+                                                   : mul_q32(r->iv_q32, r->down_factor_q32);
+    }
+
+    uint64_t sum = r->iv_q32 + r->frac_q32;
+    uint32_t us = (uint32_t)(sum >> 32);
+    r->frac_q32 = (uint32_t)sum;
+    r->left--;
+
+    if (r->phase == RAMP_UP) {
+        r->iv_q32 = mul_q32(r->iv_q32, r->up_factor_q32);
+        if (r->left == 0) {
+            r->phase = RAMP_FULL;
+        }
+        if (us < interval_us) {
+            us = interval_us;
+        }
+    }
+    return us;
+}
@@ -0,0 +1,125 @@
+#include <math.h>
+#include "esp_random.h"
+#include "pulse_random.h"
+
+#define LN2_Q16             45426u
+
+// log2(1 + i/64) em Q16, i = 0..64
+static const uint32_t log2_frac_q16[65] PULSE_SCHED_DRAM = {
+        0,  1466,  2909,  4331,  5732,  7112,  8473,  9814, 11136, 12440, 13727,
+    14996, 16248, 17484, 18704, 19909, 21098, 22272, 23433, 24579, 25711, 26830,
+    27936, 29029, 30109, 31178, 32234, 33279, 34312, 35334, 36346, 37346, 38336,
+    39316, 40286, 41246, 42196, 43137, 44068, 44990, 45904, 46809, 47705, 48593,
+    49472, 50344, 51207, 52063, 52911, 53751, 54584, 55410, 56229, 57040, 57845,
+    58643, 59434, 60219, 60997, 61769, 62534, 63294, 64047, 64794, 65536
+};
+
+uint32_t rng_seed(void) {
+    uint32_t seed;
+    do {
+        seed = esp_random();
+    } while (seed == 0);
+    return seed;
+}
+
+uint32_t seed_derive(uint32_t seed, uint32_t index) {
+    uint32_t z = seed + index * 0x9E3779B9u;
+    z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+    z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+    z ^= z >> 16;
+    return z ? z : 0x6D2B79F5u;
+}
+
+PULSE_SCHED_IRAM uint32_t rng_exp_q16(uint32_t *state) {
+    uint32_t x = rng_next(state) | 1u;
+    int lz = __builtin_clz(x);
+    uint32_t m = x << lz;                       // mantissa normalizada, bit 31 = 1
+    uint32_t idx = (m >> 25) & 63u;
+    uint32_t t = (m >> 9) & 0xFFFFu;            // posição entre idx e idx + 1
+    uint32_t frac = log2_frac_q16[idx] +
+                    (((log2_frac_q16[idx + 1] - log2_frac_q16[idx]) * t) >> 16);
+    uint32_t log2_x = ((uint32_t)(31 - lz) << 16) + frac;
+    uint32_t neg_log2_u = (32u << 16) - log2_x;
+    return (uint32_t)(((uint64_t)neg_log2_u * LN2_Q16) >> 16);
+}
+
+PULSE_SCHED_IRAM uint32_t random_exp_us(uint32_t *state, uint32_t mean_us) {
+    uint64_t us = ((uint64_t)mean_us * rng_exp_q16(state)) >> 16;
+    return (us > UINT32_MAX - 1000u) ? UINT32_MAX - 1000u : (uint32_t)us;
+}
+
+// ========== MMPP ==========
+
+// Probabilidade em ‰ para limiar de comparação com uma palavra de 32 bits
+static uint32_t permille_to_p32(int permille) {
+    uint64_t p = ((uint64_t)permille << 32) / 1000u;
+    return (p > UINT32_MAX) ? UINT32_MAX : (uint32_t)p;
+}
+
+void mmpp_setup(mmpp_t *m, uint32_t mean_interval_us, int burst_factor,
+                int enter_permille, int leave_permille) {
+    double pi1 = (double)enter_permille / (enter_permille + leave_permille);
+    double base_us = mean_interval_us / ((1.0 - pi1) + pi1 / burst_factor);
+
+    m->mean_us[0] = (base_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)base_us;
+    m->mean_us[1] = m->mean_us[0] / burst_factor;
+    m->switch_p[0] = permille_to_p32(enter_permille);
+    m->switch_p[1] = permille_to_p32(leave_permille);
+    m->state = 0;
+}
+
+PULSE_SCHED_IRAM uint32_t mmpp_next_us(mmpp_t *m, uint32_t *rng) {
+    if (rng_next(rng) < m->switch_p[m->state]) {
+        m->state ^= 1u;
+    }
+    return random_exp_us(rng, m->mean_us[m->state]);
+}
+
+// ========== FLUXOS INDEPENDENTES ==========
+
+void random_stream_start(random_stream_t *s) {
+    s->next_us = s->mean_us ? random_exp_us(&s->rng, s->mean_us) : UINT64_MAX;
+}
+
+PULSE_SCHED_IRAM uint64_t random_streams_pop(random_stream_t *common, random_stream_t *indep) {
+    random_stream_t *s = (common->next_us <= indep->next_us) ? common : indep;
+    uint64_t t = s->next_us;
+    s->next_us += random_exp_us(&s->rng, s->mean_us);
+    return t;
+}
+
+// ========== TEMPO MORTO ==========
+
+double deadtime_observed_rate(double true_rate, double tau_s, deadtime_model_t model) {
+    switch (model) {
+    case DEADTIME_NONPARALYZABLE:
+        return true_rate / (1.0 + true_rate * tau_s);
+    case DEADTIME_PARALYZABLE:
+        return true_rate * exp(-true_rate * tau_s);
+    default:
+        return true_rate;
+    }
+}
+
+double deadtime_true_rate(double observed_rate, double tau_s, deadtime_model_t model) {
+    switch (model) {
+    case DEADTIME_NONPARALYZABLE:
+        if (observed_rate * tau_s >= 1.0) return -1.0;
+        return observed_rate / (1.0 - observed_rate * tau_s);
+    case DEADTIME_PARALYZABLE: {
+        if (observed_rate * tau_s > exp(-1.0)) return -1.0;
+        double n = observed_rate;
+        for (int i = 0; i < 50; i++) {
+            double e = exp(-n * tau_s);
+            double step = (n * e - observed_rate) / (e * (1.0 - n * tau_s));
+            n -= step;
+            // Na borda m tau = 1/e a derivada zera em n tau = 1: o limite é a raiz
+            if (n * tau_s >= 1.0) return 1.0 / tau_s;
+            if (fabs(step) < n * 1e-12) break;
+        }
+        return n;
+    }
+    default:
+        return observed_rate;
+    }
+}
@@ -0,0 +1,98 @@
+#include "pulse_width.h"
+#include "pulse_random.h"
+
+// ========== CONFIGURAÇÃO ==========
+
+bool width_setup(const width_seq_t *w) {
+    switch (w->source) {
+    case WIDTH_TABLE:
+        if (w->count == 0 || w->count > WIDTH_MAX_TABLE) {
+            return false;
+        }
+        for (uint16_t i = 0; i < w->count; i++) {
+            if (w->table[i] == 0) {
+                return false;
+            }
+        }
+        return true;
+    case WIDTH_SWEEP:
+        return w->from_us && w->to_us && w->step_us;
+    case WIDTH_RANDOM:
+        return w->from_us && w->from_us <= w->to_us && w->seed;
+    default:
+        return true;
+    }
+}
+
+uint32_t width_max_us(const width_seq_t *w) {
+    uint32_t max_us = 0;
+
+    switch (w->source) {
+    case WIDTH_TABLE:
+        for (uint16_t i = 0; i < w->count; i++) {
+            if (w->table[i] > max_us) max_us = w->table[i];
+        }
+        return max_us;
+    case WIDTH_SWEEP:
+    case WIDTH_RANDOM:
+        return (w->from_us > w->to_us) ? w->from_us : w->to_us;
+    default:
+        return 0;
+    }
+}
+
+void width_start(width_seq_t *w) {
+    w->index = 0;
+    w->cur_us = w->from_us;
+    w->falling = false;
+    w->rng = w->seed;
+}
+
+// ========== POR PULSO ==========
+
+// Anda um passo de cur para target; o último passo encurta para cair na ponta
+static PULSE_SCHED_IRAM uint32_t sweep_toward(uint32_t cur, uint32_t target, uint32_t step) {
+    if (target >= cur) {
+        return (target - cur > step) ? cur + step : target;
+    }
+    return (cur - target > step) ? cur - step : target;
+}
+
+// As duas pontas entram na varredura; no triângulo a ponta não se repete na
+// volta, no dente de serra a próxima depois de to_us é from_us
+static PULSE_SCHED_IRAM void sweep_advance(width_seq_t *w) {
+    uint32_t target = w->falling ? w->from_us : w->to_us;
+
+    if (w->cur_us != target) {
+        w->cur_us = sweep_toward(w->cur_us, target, w->step_us);
+    } else if (w->triangle && w->from_us != w->to_us) {
+        w->falling = !w->falling;
+        w->cur_us = sweep_toward(w->cur_us, w->falling ? w->from_us : w->to_us, w->step_us);
+    } else {
+        w->cur_us = w->from_us;
+    }
+}
+
+PULSE_SCHED_IRAM uint32_t width_next_us(width_seq_t *w) {
+    uint32_t width_us;
+
+    switch (w->source) {
+    case WIDTH_TABLE:
+        width_us = w->table[w->index];
+        if (++w->index == w->count) {
+            w->index = 0;
+        }
+        return width_us;
+    case WIDTH_SWEEP:
+        width_us = w->cur_us;
+        sweep_advance(w);
+        return width_us;
+    case WIDTH_RANDOM: {
+        // O produto por (span + 1) leva U[0, 2^32) a [0, span]
+        uint64_t span = (uint64_t)(w->to_us - w->from_us) + 1u;
+        return w->from_us + (uint32_t)((rng_next(&w->rng) * span) >> 32);
+    }
+    default:
+        return 0;
+    }
+}
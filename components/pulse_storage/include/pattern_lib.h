@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Biblioteca de padrões gravada na partição "patterns" por tools/patlib.py.
+// O mesmo leitor roda na placa, sobre o ponteiro de esp_partition_mmap, e
+// em test/host, sobre uma imagem montada pela ferramenta.
+//
+// Layout (little endian):
+//   pattern_lib_header_t
+//   pattern_entry_t[entry_count]      índice, nomes únicos
+//   dados de cada padrão, em offset relativo ao início da imagem
+//
+// Dados de um padrão: um evento por registro, delta em µs desde o evento
+// anterior (o primeiro é relativo ao início) em varint LEB128. Padrões
+// PATTERN_KIND_SEQUENCE trazem também a largura do pulso em µs.
+
+#define PATTERN_LIB_MAGIC       0x42494C50u   // "PLIB"
+#define PATTERN_LIB_VERSION     1
+#define PATTERN_NAME_LEN        16
+
+typedef enum {
+    PATTERN_KIND_TRACE = 1,     // só deltas; largura vem da configuração
+    PATTERN_KIND_SEQUENCE = 2   // pares (delta, largura)
+} pattern_kind_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_size;
+    uint32_t entry_count;
+    uint32_t image_size;
+} pattern_lib_header_t;
+
+typedef struct __attribute__((packed)) {
+    char name[PATTERN_NAME_LEN];  // terminado em zero se menor que 16
+    uint8_t kind;
+    uint8_t reserved[3];
+    uint32_t offset;
+    uint32_t length;
+    uint32_t event_count;
+    uint64_t duration_us;
+} pattern_entry_t;
+
+typedef struct {
+    const uint8_t *base;
+    const pattern_entry_t *entries;
+    uint32_t count;
+} pattern_lib_t;
+
+typedef struct {
+    const uint8_t *pos;
+    const uint8_t *end;
+    uint8_t kind;
+} pattern_cursor_t;
+
+// Valida cabeçalho e índice de uma imagem com 'size' bytes disponíveis
+bool pattern_lib_open(pattern_lib_t *lib, const void *base, size_t size);
+
+const pattern_entry_t *pattern_lib_entry(const pattern_lib_t *lib, uint32_t index);
+const pattern_entry_t *pattern_lib_find(const pattern_lib_t *lib, const char *name);
+
+void pattern_cursor_init(pattern_cursor_t *cur, const pattern_lib_t *lib,
+                         const pattern_entry_t *entry);
+
+// Próximo evento; width_us = 0 em padrões PATTERN_KIND_TRACE.
+// Retorna false no fim do padrão ou em dado truncado.
+bool pattern_cursor_next(pattern_cursor_t *cur, uint64_t *delta_us, uint32_t *width_us);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pattern_lib.h"
+
+// Partição de dados gravada por tools/patlib.py (ver partitions.csv)
+#define PATTERN_PARTITION   "patterns"
+#define PATTERN_SUBTYPE     0x40
+
+// Mapeia a partição uma única vez; a reprodução lê direto do cache da flash.
+// Retorna NULL (com o motivo no log) se a partição falta ou é inválida.
+const pattern_lib_t *pattern_storage_open(void);
+
+// Imagem nova recebida em pedaços, em ordem (tools/patlib.py send). Cada
+// setor é apagado quando a escrita chega nele. Depois de begin a biblioteca
+// anterior e os ponteiros dados por pattern_storage_open() não valem mais;
+// a imagem nova só abre depois de pattern_storage_finish().
+bool pattern_storage_begin(uint32_t total);
+bool pattern_storage_write(uint32_t offset, const void *data, uint32_t len);
+
+// Confere a imagem inteira e passa a mapeá-la; NULL se inválida
+const pattern_lib_t *pattern_storage_finish(void);
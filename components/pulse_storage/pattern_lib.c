@@ -0,0 +1,80 @@
+#include <string.h>
+#include "pattern_lib.h"
+
+bool pattern_lib_open(pattern_lib_t *lib, const void *base, size_t size) {
+    const pattern_lib_header_t *hdr = (const pattern_lib_header_t *)base;
+
+    if (size < sizeof(*hdr) || hdr->magic != PATTERN_LIB_MAGIC ||
+        hdr->version != PATTERN_LIB_VERSION || hdr->entry_size != sizeof(pattern_entry_t) ||
+        hdr->image_size > size) {
+        return false;
+    }
+
+    uint64_t index_end = sizeof(*hdr) + (uint64_t)hdr->entry_count * sizeof(pattern_entry_t);
+    if (index_end > hdr->image_size) {
+        return false;
+    }
+
+    const pattern_entry_t *entries = (const pattern_entry_t *)((const uint8_t *)base + sizeof(*hdr));
+    for (uint32_t i = 0; i < hdr->entry_count; i++) {
+        const pattern_entry_t *e = &entries[i];
+        if ((e->kind != PATTERN_KIND_TRACE && e->kind != PATTERN_KIND_SEQUENCE) ||
+            e->offset < index_end || (uint64_t)e->offset + e->length > hdr->image_size) {
+            return false;
+        }
+    }
+
+    lib->base = (const uint8_t *)base;
+    lib->entries = entries;
+    lib->count = hdr->entry_count;
+    return true;
+}
+
+const pattern_entry_t *pattern_lib_entry(const pattern_lib_t *lib, uint32_t index) {
+    return (index < lib->count) ? &lib->entries[index] : NULL;
+}
+
+const pattern_entry_t *pattern_lib_find(const pattern_lib_t *lib, const char *name) {
+    for (uint32_t i = 0; i < lib->count; i++) {
+        if (strncmp(lib->entries[i].name, name, PATTERN_NAME_LEN) == 0) {
+            return &lib->entries[i];
+        }
+    }
+    return NULL;
+}
+
+void pattern_cursor_init(pattern_cursor_t *cur, const pattern_lib_t *lib,
+                         const pattern_entry_t *entry) {
+    cur->pos = lib->base + entry->offset;
+    cur->end = cur->pos + entry->length;
+    cur->kind = entry->kind;
+}
+
+static bool read_varint(pattern_cursor_t *cur, uint64_t *value) {
+    uint64_t v = 0;
+    for (int shift = 0; cur->pos < cur->end && shift < 64; shift += 7) {
+        uint8_t b = *cur->pos++;
+        v |= (uint64_t)(b & 0x7Fu) << shift;
+        if (!(b & 0x80u)) {
+            *value = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool pattern_cursor_next(pattern_cursor_t *cur, uint64_t *delta_us, uint32_t *width_us) {
+    if (!read_varint(cur, delta_us)) {
+        return false;
+    }
+
+    *width_us = 0;
+    if (cur->kind == PATTERN_KIND_SEQUENCE) {
+        uint64_t width;
+        if (!read_varint(cur, &width) || width > UINT32_MAX) {
+            return false;
+        }
+        *width_us = (uint32_t)width;
+    }
+    return true;
+}
@@ -0,0 +1,118 @@
+#include <stdbool.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "pattern_storage.h"
+
+#define LOG_TAG             "PULSE_GEN"
+#define SECTOR_SIZE         4096u
+
+static pattern_lib_t pattern_lib;
+static bool pattern_lib_mapped = false;
+static esp_partition_mmap_handle_t pattern_map;
+static uint32_t upload_total = 0;
+static uint32_t upload_written = 0;
+static uint32_t upload_erased = 0;      // início do primeiro setor ainda não apagado
+static uint8_t upload_magic[sizeof(uint32_t)];
+
+static const esp_partition_t *pattern_partition(void) {
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           PATTERN_SUBTYPE, PATTERN_PARTITION);
+    if (!part) {
+        ESP_LOGE(LOG_TAG, "Partição '%s' não encontrada!", PATTERN_PARTITION);
+    }
+    return part;
+}
+
+static void pattern_unmap(void) {
+    if (pattern_lib_mapped) {
+        esp_partition_munmap(pattern_map);
+        pattern_lib_mapped = false;
+    }
+}
+
+const pattern_lib_t *pattern_storage_open(void) {
+    if (pattern_lib_mapped) {
+        return &pattern_lib;
+    }
+
+    const esp_partition_t *part = pattern_partition();
+    if (!part) {
+        return NULL;
+    }
+
+    const void *ptr;
+    if (esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &ptr, &pattern_map) != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Falha ao mapear a partição '%s'!", PATTERN_PARTITION);
+        return NULL;
+    }
+
+    if (!pattern_lib_open(&pattern_lib, ptr, part->size)) {
+        ESP_LOGE(LOG_TAG, "Biblioteca inválida na partição '%s'!", PATTERN_PARTITION);
+        esp_partition_munmap(pattern_map);
+        return NULL;
+    }
+
+    pattern_lib_mapped = true;
+    return &pattern_lib;
+}
+
+// ========== GRAVAÇÃO ==========
+
+bool pattern_storage_begin(uint32_t total) {
+    const esp_partition_t *part = pattern_partition();
+    if (!part || total < sizeof(pattern_lib_header_t) || total > part->size) {
+        return false;
+    }
+
+    // O mapeamento antigo mostraria o conteúdo de antes no cache
+    pattern_unmap();
+    upload_total = total;
+    upload_written = 0;
+    upload_erased = 0;
+    return true;
+}
+
+bool pattern_storage_write(uint32_t offset, const void *data, uint32_t len) {
+    const esp_partition_t *part = pattern_partition();
+    if (!part || upload_total == 0 || offset != upload_written || len > upload_total - offset) {
+        return false;
+    }
+
+    uint32_t end = offset + len;
+    if (end > upload_erased) {
+        uint32_t erase_end = (end + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE;
+        if (esp_partition_erase_range(part, upload_erased, erase_end - upload_erased) != ESP_OK) {
+            ESP_LOGE(LOG_TAG, "Falha ao apagar a partição '%s'!", PATTERN_PARTITION);
+            return false;
+        }
+        upload_erased = erase_end;
+    }
+
+    // A marca do cabeçalho é gravada por último: uma imagem interrompida no
+    // meio fica com a marca apagada e não abre
+    uint32_t skip = 0;
+    if (offset < sizeof(upload_magic)) {
+        skip = sizeof(upload_magic) - offset;
+        if (skip > len) skip = len;
+        memcpy(upload_magic + offset, data, skip);
+    }
+    if (len > skip &&
+        esp_partition_write(part, offset + skip, (const uint8_t *)data + skip, len - skip) != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Falha ao gravar a partição '%s'!", PATTERN_PARTITION);
+        return false;
+    }
+    upload_written = end;
+    return true;
+}
+
+const pattern_lib_t *pattern_storage_finish(void) {
+    const esp_partition_t *part = pattern_partition();
+    bool complete = part && upload_total != 0 && upload_written == upload_total;
+    upload_total = 0;
+    if (!complete ||
+        esp_partition_write(part, 0, upload_magic, sizeof(upload_magic)) != ESP_OK) {
+        return NULL;
+    }
+    return pattern_storage_open();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Renderizador de bit-planes: transforma a sequência de pulsos de uma saída
+// em um fluxo de amostras de 1 bit (1 = pulso ativo) para periféricos que
+// deslocam bits a taxa fixa (I2S, SPI). Cada canal tem seu próprio plano;
+// em alvos com barramento paralelo os planos são transpostos na saída.
+//
+// Palavras de 32 amostras, a primeira amostra no bit 31, que é a ordem em
+// que o I2S desloca uma palavra de 32 bits (para SPI, ver render_to_msb_bytes). Trechos sem borda são escritos
+// palavra a palavra, então o custo cresce com o número de bordas e com o
+// tamanho do buffer, não com a taxa de amostragem.
+
+// Fonte de pulsos em amostras: gap ocioso antes do pulso e largura ativa.
+// Retorna false quando não há mais pulsos.
+typedef bool (*render_source_t)(void *ctx, uint64_t *gap, uint32_t *width);
+
+typedef struct {
+    render_source_t source;
+    void *ctx;
+    uint64_t span_left;      // amostras restantes no trecho atual
+    uint32_t width_next;     // largura do pulso após o gap em curso
+    uint8_t level;           // nível do trecho atual (1 = ativo)
+    bool ended;              // fonte esgotada; o resto é ocioso
+    uint64_t pulses;         // pulsos com largura > 0 já iniciados
+} render_channel_t;
+
+void render_channel_init(render_channel_t *ch, render_source_t source, void *ctx);
+
+// Preenche n_words palavras. Retorna false quando a fonte acabou e o último
+// pulso já foi escrito por inteiro (o restante do buffer sai ocioso).
+bool render_plane(render_channel_t *ch, uint32_t *words, size_t n_words);
+
+// Reordena as palavras em fluxo de bytes com a primeira amostra no bit 7 do
+// byte 0, a ordem do SPI (byte a byte, MSB primeiro) em memória little-endian.
+// Palavras ociosas ou todas ativas não mudam e são puladas.
+void render_to_msb_bytes(uint32_t *words, size_t n_words);
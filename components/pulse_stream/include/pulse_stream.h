@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "pulse_engine.h"
+
+// Backend de stream: a saída é renderizada adiantado em bit-plane
+// (pulse_render.h) e um periférico a desloca com GDMA a taxa fixa, sem CPU
+// por borda. O backend (I2S ou SPI) é escolhido no Kconfig; os dois têm uma
+// só linha de dados no C3, então o stream cobre uma saída. A taxa é em MHz
+// inteiros, então os prazos do motor (em µs) caem exatamente na grade de
+// amostras.
+
+#if CONFIG_PULSE_STREAM_I2S
+#define PULSE_STREAM_NAME       "I2S"
+#define PULSE_STREAM_MAX_MHZ    10
+#elif CONFIG_PULSE_STREAM_SPI
+#define PULSE_STREAM_NAME       "SPI"
+#define PULSE_STREAM_MAX_MHZ    40
+#endif
+#define PULSE_STREAM_MIN_MHZ    1
+
+typedef struct {
+    bool running;
+    uint64_t samples;        // amostras entregues ao DMA
+    uint64_t pulses;         // pulsos renderizados (à frente do pino pelo buffer)
+    uint32_t underflows;     // DMA sem dados a tempo; a saída parou ociosa
+    uint32_t render_us_max;  // maior tempo de renderização de um bloco
+    uint32_t block_us;       // duração de um bloco na saída
+} pulse_stream_status_t;
+
+// true se o clock do periférico chega à taxa sem divisor fracionário
+bool pulse_stream_rate_valid(uint32_t sample_mhz);
+
+// Assume o pino da saída até o fim da sequência ou pulse_stream_stop()
+esp_err_t pulse_stream_start(pulse_config_t *config, uint32_t sample_mhz);
+
+void pulse_stream_stop(void);
+
+// true enquanto a task de stream não liberou o periférico
+bool pulse_stream_busy(void);
+
+void pulse_stream_snapshot(pulse_stream_status_t *out);
@@ -0,0 +1,82 @@
+#include <string.h>
+#include "pulse_render.h"
+
+void render_channel_init(render_channel_t *ch, render_source_t source, void *ctx) {
+    memset(ch, 0, sizeof(*ch));
+    ch->source = source;
+    ch->ctx = ctx;
+}
+
+// Próximo trecho: gap ocioso, depois o pulso, depois o próximo par da fonte
+static void render_advance(render_channel_t *ch) {
+    if (ch->level == 0 && ch->width_next) {
+        ch->level = 1;
+        ch->span_left = ch->width_next;
+        ch->width_next = 0;
+        ch->pulses++;
+        return;
+    }
+
+    uint64_t gap;
+    uint32_t width;
+    ch->level = 0;
+    if (ch->ended || !ch->source(ch->ctx, &gap, &width)) {
+        ch->ended = true;
+        ch->span_left = UINT64_MAX;
+        return;
+    }
+    ch->span_left = gap;
+    ch->width_next = width;
+}
+
+// Escreve count bits de valor level a partir do bit start
+static void render_fill(uint32_t *words, size_t start, size_t count, uint8_t level) {
+    uint32_t fill = level ? 0xFFFFFFFFu : 0;
+    size_t w = start / 32;
+    unsigned bit = start % 32;
+
+    if (bit) {
+        unsigned n = 32 - bit;
+        if (n > count) n = (unsigned)count;
+        uint32_t mask = (0xFFFFFFFFu >> bit) & ~(n + bit < 32 ? 0xFFFFFFFFu >> (bit + n) : 0);
+        words[w] = (words[w] & ~mask) | (fill & mask);
+        count -= n;
+        w++;
+    }
+    // Trecho longo sem borda: palavras inteiras
+    for (; count >= 32; count -= 32) {
+        words[w++] = fill;
+    }
+    if (count) {
+        uint32_t mask = ~(0xFFFFFFFFu >> count);
+        words[w] = (words[w] & ~mask) | (fill & mask);
+    }
+}
+
+bool render_plane(render_channel_t *ch, uint32_t *words, size_t n_words) {
+    size_t total = n_words * 32;
+    size_t pos = 0;
+
+    while (pos < total) {
+        while (ch->span_left == 0) {
+            render_advance(ch);
+        }
+        uint64_t take = total - pos;
+        if (ch->span_left < take) take = ch->span_left;
+        render_fill(words, pos, (size_t)take, ch->level);
+        pos += (size_t)take;
+        if (ch->span_left != UINT64_MAX) {
+            ch->span_left -= take;
+        }
+    }
+    return !(ch->ended && ch->level == 0);
+}
+
+void render_to_msb_bytes(uint32_t *words, size_t n_words) {
+    for (size_t i = 0; i < n_words; i++) {
+        uint32_t w = words[i];
+        if (w + 1u > 1u) {
+            words[i] = __builtin_bswap32(w);
+        }
+    }
+}
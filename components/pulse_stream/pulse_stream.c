@@ -0,0 +1,127 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "pulse_render.h"
+#include "pulse_stream.h"
+#include "stream_hw.h"
+
+// ========== CONFIGURAÇÕES ==========
+#define STREAM_BLOCK_WORDS  CONFIG_PULSE_STREAM_BLOCK_WORDS
+#define STREAM_TASK_STACK   CONFIG_PULSE_TASK_STACK_SIZE
+#define STREAM_TASK_PRIO    CONFIG_PULSE_TASK_PRIORITY
+
+typedef struct {
+    pulse_config_t *config;
+    uint32_t mhz;
+    uint64_t cursor;         // amostras já descritas pela fonte
+    render_channel_t render;
+} stream_t;
+
+// ========== VARIÁVEIS GLOBAIS ==========
+static stream_t stream;
+static volatile bool stream_running = false;
+static volatile bool stream_alive = false;
+static pulse_stream_status_t stream_status;
+static portMUX_TYPE stream_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Prazos absolutos do motor em gap e largura em amostras; um pulso que
+// começaria antes do fim do anterior sai logo depois dele
+static bool stream_source(void *ctx, uint64_t *gap, uint32_t *width) {
+    stream_t *s = (stream_t *)ctx;
+    uint64_t due_us;
+    uint32_t width_us;
+
+    if (!pulse_sequence_next(s->config, &due_us, &width_us)) {
+        return false;
+    }
+    uint64_t due = due_us * s->mhz;
+    uint64_t w = (uint64_t)width_us * s->mhz;
+    *gap = (due > s->cursor) ? due - s->cursor : 0;
+    *width = (w > UINT32_MAX) ? UINT32_MAX : (uint32_t)w;
+    s->cursor += *gap + *width;
+    return true;
+}
+
+void IRAM_ATTR stream_count_underflow(void) {
+    portENTER_CRITICAL_SAFE(&stream_lock);
+    stream_status.underflows++;
+    portEXIT_CRITICAL_SAFE(&stream_lock);
+}
+
+static bool stream_render(uint32_t *block) {
+    int64_t t0 = esp_timer_get_time();
+    bool more = render_plane(&stream.render, block, STREAM_BLOCK_WORDS);
+    uint32_t render_us = (uint32_t)(esp_timer_get_time() - t0);
+
+    portENTER_CRITICAL(&stream_lock);
+    stream_status.pulses = stream.render.pulses;
+    stream_status.samples += STREAM_BLOCK_WORDS * 32u;
+    if (render_us > stream_status.render_us_max) stream_status.render_us_max = render_us;
+    portEXIT_CRITICAL(&stream_lock);
+    return more;
+}
+
+static void stream_task(void *pvParameter) {
+    bool more = true;
+
+    while (stream_running && more) {
+        uint32_t *block = stream_hw_acquire();
+        more = stream_render(block);
+        stream_hw_submit(block);
+    }
+
+    stream_hw_finish();
+    stream.config->state = STATE_STOPPED;
+    stream_running = false;
+    stream_alive = false;
+    vTaskDelete(NULL);
+}
+
+esp_err_t pulse_stream_start(pulse_config_t *config, uint32_t sample_mhz) {
+    if (stream_alive) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!pulse_stream_rate_valid(sample_mhz)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(&stream, 0, sizeof(stream));
+    stream.config = config;
+    stream.mhz = sample_mhz;
+    esp_err_t err = stream_hw_open(config->gpio, sample_mhz);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    memset(&stream_status, 0, sizeof(stream_status));
+    stream_status.block_us = STREAM_BLOCK_WORDS * 32u / sample_mhz;
+    pulse_sequence_start(config);
+    render_channel_init(&stream.render, stream_source, &stream);
+
+    // Primeiro bloco pronto antes do clock para a saída começar sem preenchimento
+    uint32_t *block = stream_hw_acquire();
+    stream_running = stream_render(block);
+    stream_alive = true;
+    config->state = STATE_RUNNING;
+    stream_hw_start(block);
+    xTaskCreate(stream_task, "pulse_stream", STREAM_TASK_STACK, NULL, STREAM_TASK_PRIO, NULL);
+    return ESP_OK;
+}
+
+void pulse_stream_stop(void) {
+    stream_running = false;
+}
+
+bool pulse_stream_busy(void) {
+    return stream_alive;
+}
+
+void pulse_stream_snapshot(pulse_stream_status_t *out) {
+    portENTER_CRITICAL(&stream_lock);
+    *out = stream_status;
+    portEXIT_CRITICAL(&stream_lock);
+    out->running = stream_running;
+}
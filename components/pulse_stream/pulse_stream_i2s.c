@@ -0,0 +1,94 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/i2s_std.h"
+#include "esp_attr.h"
+#include "esp_rom_gpio.h"
+#include "soc/gpio_sig_map.h"
+#include "sdkconfig.h"
+#include "pulse_stream.h"
+#include "stream_hw.h"
+
+// ========== CONFIGURAÇÕES ==========
+#define STREAM_BLOCK_WORDS  CONFIG_PULSE_STREAM_BLOCK_WORDS
+#define STREAM_DMA_DESC     CONFIG_PULSE_STREAM_DMA_DESC
+#define STREAM_DMA_FRAMES   (STREAM_BLOCK_WORDS / 2)  // quadro estéreo = 2 palavras
+
+_Static_assert(STREAM_BLOCK_WORDS % 2 == 0, "PULSE_STREAM_BLOCK_WORDS deve ser par");
+
+// ========== VARIÁVEIS GLOBAIS ==========
+static i2s_chan_handle_t i2s_tx;
+static uint32_t i2s_block_us;
+// i2s_channel_write copia para os buffers do driver, então um bloco basta
+static uint32_t i2s_block[STREAM_BLOCK_WORDS];
+
+static bool IRAM_ATTR i2s_underflow(i2s_chan_handle_t handle, i2s_event_data_t *event, void *ctx) {
+    stream_count_underflow();
+    return false;
+}
+
+// MCLK = 256 fs = 4 × taxa, dividido do PLL de 160 MHz
+bool pulse_stream_rate_valid(uint32_t sample_mhz) {
+    return sample_mhz >= PULSE_STREAM_MIN_MHZ && sample_mhz <= PULSE_STREAM_MAX_MHZ &&
+           40 % sample_mhz == 0;
+}
+
+esp_err_t stream_hw_open(int gpio, uint32_t sample_mhz) {
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = STREAM_DMA_DESC;
+    chan_cfg.dma_frame_num = STREAM_DMA_FRAMES;
+    chan_cfg.auto_clear = true;
+
+    // BCLK = taxa de amostragem: 64 bits por quadro estéreo de 32 bits, em
+    // formato MSB (sem o bit de atraso do Philips), então os bits saem contínuos
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sample_mhz * 1000000u / 64u),
+        .slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT, I2S_SLOT_MODE_STEREO),
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = I2S_GPIO_UNUSED,
+            .ws = I2S_GPIO_UNUSED,
+            .dout = gpio,
+            .din = I2S_GPIO_UNUSED,
+        },
+    };
+    i2s_event_callbacks_t cbs = {.on_send_q_ovf = i2s_underflow};
+
+    esp_err_t err = i2s_new_channel(&chan_cfg, &i2s_tx, NULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = i2s_channel_init_std_mode(i2s_tx, &std_cfg);
+    if (err == ESP_OK) {
+        err = i2s_channel_register_event_callback(i2s_tx, &cbs, NULL);
+    }
+    if (err != ESP_OK) {
+        i2s_del_channel(i2s_tx);
+        return err;
+    }
+    // Bit 1 = pulso ativo; o pino invertido deixa os zeros do DMA ociosos em alto
+    esp_rom_gpio_connect_out_signal(gpio, I2SO_SD_OUT_IDX, true, false);
+    i2s_block_us = STREAM_BLOCK_WORDS * 32u / sample_mhz;
+    return ESP_OK;
+}
+
+uint32_t *stream_hw_acquire(void) {
+    return i2s_block;
+}
+
+void stream_hw_start(uint32_t *block) {
+    size_t loaded = 0;
+    i2s_channel_preload_data(i2s_tx, block, sizeof(i2s_block), &loaded);
+    i2s_channel_enable(i2s_tx);
+}
+
+void stream_hw_submit(uint32_t *block) {
+    size_t written = 0;
+    i2s_channel_write(i2s_tx, block, sizeof(i2s_block), &written, portMAX_DELAY);
+}
+
+void stream_hw_finish(void) {
+    // Com auto_clear o DMA manda zeros (nível ocioso) depois do último bloco
+    vTaskDelay(pdMS_TO_TICKS(STREAM_DMA_DESC * i2s_block_us / 1000u) + 1);
+    i2s_channel_disable(i2s_tx);
+    i2s_del_channel(i2s_tx);
+}
@@ -0,0 +1,107 @@
+#include "freertos/FreeRTOS.h"
+#include "driver/spi_master.h"
+#include "esp_attr.h"
+#include "esp_rom_gpio.h"
+#include "soc/gpio_sig_map.h"
+#include "sdkconfig.h"
+#include "pulse_render.h"
+#include "pulse_stream.h"
+#include "stream_hw.h"
+
+// ========== CONFIGURAÇÕES ==========
+#define STREAM_BLOCK_WORDS  CONFIG_PULSE_STREAM_BLOCK_WORDS
+#define STREAM_SPI_HOST     SPI2_HOST
+#define STREAM_SPI_BUFFERS  2
+
+// ========== VARIÁVEIS GLOBAIS ==========
+// Dois blocos: um sai pelo DMA enquanto a task renderiza o outro
+static spi_device_handle_t spi_dev;
+static DMA_ATTR uint32_t spi_block[STREAM_SPI_BUFFERS][STREAM_BLOCK_WORDS];
+static spi_transaction_t spi_trans[STREAM_SPI_BUFFERS];
+static int spi_next = 0;                 // próximo buffer a renderizar
+static int spi_inflight = 0;             // transações na fila do driver
+
+// Clock do SPI dividido dos 80 MHz do APB; só divisores inteiros dão a
+// grade exata
+bool pulse_stream_rate_valid(uint32_t sample_mhz) {
+    return sample_mhz >= PULSE_STREAM_MIN_MHZ && sample_mhz <= PULSE_STREAM_MAX_MHZ &&
+           80 % sample_mhz == 0;
+}
+
+esp_err_t stream_hw_open(int gpio, uint32_t sample_mhz) {
+    spi_bus_config_t bus_cfg = {
+        .mosi_io_num = gpio,
+        .miso_io_num = -1,
+        .sclk_io_num = -1,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = STREAM_BLOCK_WORDS * 4,
+    };
+    spi_device_interface_config_t dev_cfg = {
+        .mode = 0,
+        .clock_speed_hz = (int)(sample_mhz * 1000000u),
+        .spics_io_num = -1,
+        .queue_size = STREAM_SPI_BUFFERS,
+        .flags = SPI_DEVICE_HALFDUPLEX,
+    };
+
+    esp_err_t err = spi_bus_initialize(STREAM_SPI_HOST, &bus_cfg, SPI_DMA_CH_AUTO);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = spi_bus_add_device(STREAM_SPI_HOST, &dev_cfg, &spi_dev);
+    if (err != ESP_OK) {
+        spi_bus_free(STREAM_SPI_HOST);
+        return err;
+    }
+    // Bit 1 = pulso ativo; com o MOSI invertido a linha parada fica em alto
+    esp_rom_gpio_connect_out_signal(gpio, FSPID_OUT_IDX, true, false);
+    spi_next = 0;
+    spi_inflight = 0;
+    return ESP_OK;
+}
+
+uint32_t *stream_hw_acquire(void) {
+    spi_transaction_t *done;
+    if (spi_inflight == STREAM_SPI_BUFFERS) {
+        spi_device_get_trans_result(spi_dev, &done, portMAX_DELAY);
+        spi_inflight--;
+    }
+    return spi_block[spi_next];
+}
+
+static void spi_queue(uint32_t *block) {
+    render_to_msb_bytes(block, STREAM_BLOCK_WORDS);
+    spi_transaction_t *t = &spi_trans[spi_next];
+    t->length = STREAM_BLOCK_WORDS * 32;
+    t->tx_buffer = block;
+    spi_device_queue_trans(spi_dev, t, portMAX_DELAY);
+    spi_inflight++;
+    spi_next = (spi_next + 1) % STREAM_SPI_BUFFERS;
+}
+
+void stream_hw_start(uint32_t *block) {
+    spi_queue(block);
+}
+
+void stream_hw_submit(uint32_t *block) {
+    // Recolhe sem esperar o que já saiu; fila vazia aqui = a linha parou
+    spi_transaction_t *done;
+    while (spi_inflight > 0 && spi_device_get_trans_result(spi_dev, &done, 0) == ESP_OK) {
+        spi_inflight--;
+    }
+    if (spi_inflight == 0) {
+        stream_count_underflow();
+    }
+    spi_queue(block);
+}
+
+void stream_hw_finish(void) {
+    spi_transaction_t *done;
+    while (spi_inflight > 0) {
+        spi_device_get_trans_result(spi_dev, &done, portMAX_DELAY);
+        spi_inflight--;
+    }
+    spi_bus_remove_device(spi_dev);
+    spi_bus_free(STREAM_SPI_HOST);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// Interface interna entre o laço de stream (pulse_stream.c) e o backend.
+// Blocos de CONFIG_PULSE_STREAM_BLOCK_WORDS palavras no formato do
+// renderizador; a conversão para a ordem do periférico é do backend.
+
+esp_err_t stream_hw_open(int gpio, uint32_t sample_mhz);
+
+// Buffer livre para o próximo bloco; espera o DMA liberar um se preciso
+uint32_t *stream_hw_acquire(void);
+
+// Entrega o primeiro bloco e liga o clock
+void stream_hw_start(uint32_t *block);
+
+void stream_hw_submit(uint32_t *block);
+
+// Espera os blocos enfileirados saírem e libera o periférico
+void stream_hw_finish(void);
+
+// Chamado pelo backend quando a saída ficou sem dados (pode ser em ISR)
+void stream_count_underflow(void);
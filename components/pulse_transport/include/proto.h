@@ -0,0 +1,191 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Protocolo binário na mesma UART do console. O byte de início nunca é
+// digitado no terminal, então quadros e comandos de texto convivem.
+//
+// Quadro: PROTO_SOF | tipo | tamanho (u16 LE) | payload | CRC16 (u16 LE)
+// CRC-16/CCITT-FALSE sobre tipo, tamanho e payload.
+
+#define PROTO_SOF           0xA5
+#define PROTO_MAX_PAYLOAD   256
+#define PROTO_OVERHEAD      6
+
+typedef enum {
+    PROTO_CMD_STATUS = 0x01,            // sem payload; resposta PROTO_RSP_STATUS
+    PROTO_CMD_METER_PROFILE = 0x02,     // proto_meter_profile_t; resposta PROTO_RSP_METER_PROFILE
+    PROTO_CMD_SET_FREQUENCY = 0x03,     // proto_set_frequency_t; resposta PROTO_RSP_OK
+    PROTO_CMD_STAGE = 0x04,             // proto_stage_t; resposta PROTO_RSP_OK
+    PROTO_CMD_COMMIT = 0x05,            // proto_commit_t; resposta PROTO_RSP_OK
+    PROTO_CMD_WIDTH_TABLE = 0x06,       // proto_width_table_t; resposta PROTO_RSP_WIDTH_TABLE
+    PROTO_CMD_EDGE_EXPORT = 0x07,       // u8 liga (1) ou desliga (0); resposta PROTO_RSP_OK
+    PROTO_CMD_TIME_SYNC = 0x08,         // u64 marca do host; resposta PROTO_RSP_TIME_SYNC
+    PROTO_CMD_PATTERN_UPLOAD = 0x09,    // proto_pattern_upload_t; resposta PROTO_RSP_PATTERN_UPLOAD
+    PROTO_RSP_OK = 0x80,                // payload: tipo do comando aceito
+    PROTO_RSP_STATUS = 0x81,
+    PROTO_RSP_METER_PROFILE = 0x82,     // payload: u16 pontos recebidos em sequência
+    PROTO_RSP_WIDTH_TABLE = 0x86,       // payload: u16 larguras recebidas em sequência
+    PROTO_RSP_TIME_SYNC = 0x88,         // proto_time_sync_t
+    PROTO_RSP_PATTERN_UPLOAD = 0x89,    // payload: u32 bytes gravados em sequência
+    PROTO_EVT_EDGES = 0x90,             // proto_edges_t, sem pedido, com a exportação ligada
+    PROTO_RSP_ERROR = 0xFF              // payload: tipo do comando rejeitado
+} proto_type_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t state;
+    uint8_t mode;
+    uint16_t fifo_min;          // menor ocupação da fila de prazos (0 sem a fila)
+    uint64_t pulse_count;
+    uint32_t rate_mhz;          // taxa alcançada em mHz
+    uint32_t late_mean_us;      // atraso do pulso em relação ao prazo
+    uint32_t late_max_us;
+    uint32_t width_err_mean_us; // |largura medida - pedida|
+    uint32_t width_err_max_us;
+    uint32_t stack_free;        // marca d'água da pilha da task, em bytes
+    uint64_t missed;            // pulsos além da tolerância de atraso
+    uint64_t skipped;           // dos quais descartados pela política
+    uint64_t last_missed_us;    // tempo de execução do último prazo perdido
+    uint32_t edge_cycles_mean;  // ciclos de CPU para agendar a próxima borda
+    uint32_t edge_cycles_max;
+    uint32_t underruns;         // vezes em que a fila de prazos secou
+} proto_channel_status_t;
+
+typedef struct __attribute__((packed)) {
+    uint64_t uptime_us;
+    uint64_t run_time_us;
+    uint32_t heap_free;
+    uint32_t heap_min;
+    uint32_t log_drops;
+    uint32_t main_stack_free;
+    uint8_t running;
+    uint8_t paused;
+    uint8_t channel_count;
+    uint8_t reserved;
+    proto_channel_status_t channels[2];
+} proto_status_t;
+
+// Perfil de carga do modo S0 em vários quadros: cada um traz os pontos a
+// partir de first, que deve ser 0 (recomeça) ou o total já recebido
+typedef struct __attribute__((packed)) {
+    uint32_t t_ms;              // desde o início do perfil, crescente
+    uint32_t power_mw;
+} proto_meter_point_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t first;             // índice do primeiro ponto deste quadro
+    uint16_t total;             // pontos do perfil inteiro
+    proto_meter_point_t points[];
+} proto_meter_profile_t;
+
+#define PROTO_METER_POINTS_PER_FRAME \
+    ((PROTO_MAX_PAYLOAD - sizeof(proto_meter_profile_t)) / sizeof(proto_meter_point_t))
+
+// Tabela de larguras por pulso em vários quadros, como o perfil S0
+typedef struct __attribute__((packed)) {
+    uint16_t first;             // índice da primeira largura deste quadro
+    uint16_t total;             // larguras da tabela inteira
+    uint32_t widths_us[];
+} proto_width_table_t;
+
+#define PROTO_WIDTHS_PER_FRAME \
+    ((PROTO_MAX_PAYLOAD - sizeof(proto_width_table_t)) / sizeof(uint32_t))
+
+// Imagem da biblioteca de padrões (tools/patlib.py build) em vários quadros:
+// cada um traz os bytes a partir de offset, que deve ser 0 (recomeça) ou o
+// total já gravado. Só aceita com o console esperando a biblioteca.
+typedef struct __attribute__((packed)) {
+    uint32_t offset;            // posição do primeiro byte deste quadro na imagem
+    uint32_t total;             // bytes da imagem inteira
+    uint8_t data[];
+} proto_pattern_upload_t;
+
+#define PROTO_PATTERN_BYTES_PER_FRAME (PROTO_MAX_PAYLOAD - sizeof(proto_pattern_upload_t))
+
+// Frequência nova de uma saída no modo NCO, aplicada durante a geração
+typedef struct __attribute__((packed)) {
+    uint8_t channel;            // 0 = OUT1
+    uint32_t mhz;
+} proto_set_frequency_t;
+
+// Mudança preparada de uma saída (ver pulse_engine_stage()); 0 mantém o campo
+typedef struct __attribute__((packed)) {
+    uint8_t channel;            // 0 = OUT1
+    uint32_t interval_us;
+    uint32_t width_us;
+    uint32_t mhz;
+} proto_stage_t;
+
+// Confirma as mudanças preparadas; together = todas no mesmo limite de período
+typedef struct __attribute__((packed)) {
+    uint8_t mask;               // bit 0 = OUT1
+    uint8_t together;
+} proto_commit_t;
+
+// Instante de cada pulso (borda de início, µs desde o boot) num quadro que
+// se decodifica sozinho: o cabeçalho traz o último pulso de cada saída antes
+// dele e cada registro é um varint LEB128 de (dt << 2 | lacuna << 1 | saída),
+// com dt desde o pulso anterior da mesma saída. Com lacuna, outro varint traz
+// quantos números de pulso faltaram (registros descartados no anel). Com a
+// exportação ligada no meio da execução, o cabeçalho do primeiro quadro com
+// uma saída já traz o pulso anterior ao primeiro dela, então não há lacuna.
+typedef struct __attribute__((packed)) {
+    uint64_t t_us[2];
+    uint64_t seq[2];            // número do pulso; 0 = nenhum ainda
+    uint8_t records[];
+} proto_edges_t;
+
+// Troca de tempo no estilo NTP (tools/clock_sync.py estima deslocamento e
+// deriva do relógio da placa em relação ao host)
+typedef struct __attribute__((packed)) {
+    uint64_t host_mark;         // copiada do pedido
+    uint64_t rx_us;             // leitura que trouxe o fim do pedido, µs desde o boot
+    uint64_t tx_us;             // logo antes de enviar esta resposta
+} proto_time_sync_t;
+
+// Montagem dos quadros de bordas; guarda o último pulso de cada saída
+typedef struct {
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    uint16_t len;
+    uint16_t count;             // registros no quadro em montagem
+    uint64_t t_us[2];
+    uint64_t seq[2];
+    bool seeded[2];             // false: o próximo pulso da saída vira a referência
+} proto_edge_writer_t;
+
+typedef struct {
+    uint8_t type;
+    uint16_t len;
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    uint8_t stage;
+    uint16_t pos;
+    uint16_t crc;
+} proto_parser_t;
+
+uint16_t proto_crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+void proto_parser_reset(proto_parser_t *p);
+
+// true enquanto um quadro está sendo recebido
+bool proto_parser_busy(const proto_parser_t *p);
+
+// Consome um byte; true quando um quadro completo e íntegro está em p
+bool proto_parser_feed(proto_parser_t *p, uint8_t byte);
+
+// Esquece os pulsos anteriores (execução nova) e começa um quadro
+void proto_edges_reset(proto_edge_writer_t *w);
+
+// Como proto_edges_reset() com a execução já em andamento: o primeiro pulso
+// de cada saída entra sem lacuna, porque os anteriores não foram perdidos
+void proto_edges_join(proto_edge_writer_t *w);
+
+// Começa um quadro com o último pulso de cada saída no cabeçalho
+void proto_edges_start(proto_edge_writer_t *w);
+
+// Acrescenta um pulso; false se não coube (envie o quadro e comece outro)
+bool proto_edges_add(proto_edge_writer_t *w, uint8_t channel, uint64_t seq, uint64_t t_us);
+
+// Monta o quadro em out; retorna o tamanho ou 0 se não couber
+size_t proto_encode(uint8_t *out, size_t cap, uint8_t type, const void *payload, uint16_t len);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+// UART do console: texto dos menus (via stdout) e quadros do protocolo
+// binário (proto.h) dividem o mesmo enlace.
+
+void pulse_transport_init(void);
+
+// Espera até timeout pelo primeiro byte e lê até len bytes dos que já
+// chegaram; retorna quantos
+int pulse_transport_read(uint8_t *buf, size_t len, TickType_t timeout);
+
+// Instante (µs desde o boot) em que a última leitura recebeu bytes
+int64_t pulse_transport_rx_time_us(void);
+
+// Bloqueia até chegar um byte
+char pulse_transport_getc(void);
+
+// Monta e envia um quadro; quadros que não cabem são descartados
+void pulse_transport_send(uint8_t type, const void *payload, uint16_t len);
@@ -0,0 +1,163 @@
+#include <stddef.h>
+#include <string.h>
+#include "proto.h"
+
+enum {
+    STAGE_IDLE,
+    STAGE_TYPE,
+    STAGE_LEN_LO,
+    STAGE_LEN_HI,
+    STAGE_PAYLOAD,
+    STAGE_CRC_LO,
+    STAGE_CRC_HI
+};
+
+uint16_t proto_crc16(uint16_t crc, const uint8_t *data, size_t len) {
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+void proto_parser_reset(proto_parser_t *p) {
+    p->stage = STAGE_IDLE;
+    p->pos = 0;
+}
+
+bool proto_parser_busy(const proto_parser_t *p) {
+    return p->stage != STAGE_IDLE;
+}
+
+bool proto_parser_feed(proto_parser_t *p, uint8_t byte) {
+    switch (p->stage) {
+    case STAGE_IDLE:
+        if (byte == PROTO_SOF) {
+            p->crc = 0xFFFFu;
+            p->stage = STAGE_TYPE;
+        }
+        return false;
+    case STAGE_TYPE:
+        p->type = byte;
+        p->stage = STAGE_LEN_LO;
+        break;
+    case STAGE_LEN_LO:
+        p->len = byte;
+        p->stage = STAGE_LEN_HI;
+        break;
+    case STAGE_LEN_HI:
+        p->len |= (uint16_t)byte << 8;
+        p->pos = 0;
+        if (p->len > PROTO_MAX_PAYLOAD) {
+            proto_parser_reset(p);
+            return false;
+        }
+        p->stage = p->len ? STAGE_PAYLOAD : STAGE_CRC_LO;
+        break;
+    case STAGE_PAYLOAD:
+        p->payload[p->pos++] = byte;
+        if (p->pos == p->len) {
+            p->stage = STAGE_CRC_LO;
+        }
+        break;
+    case STAGE_CRC_LO:
+        p->pos = byte;
+        p->stage = STAGE_CRC_HI;
+        return false;
+    case STAGE_CRC_HI: {
+        uint16_t rx = (uint16_t)(p->pos | ((uint16_t)byte << 8));
+        bool ok = (rx == p->crc);
+        proto_parser_reset(p);
+        return ok;
+    }
+    }
+
+    p->crc = proto_crc16(p->crc, &byte, 1);
+    return false;
+}
+
+size_t proto_encode(uint8_t *out, size_t cap, uint8_t type, const void *payload, uint16_t len) {
+    size_t total = (size_t)len + PROTO_OVERHEAD;
+    if (total > cap || len > PROTO_MAX_PAYLOAD) {
+        return 0;
+    }
+
+    out[0] = PROTO_SOF;
+    out[1] = type;
+    out[2] = (uint8_t)len;
+    out[3] = (uint8_t)(len >> 8);
+    if (len) {
+        memcpy(&out[4], payload, len);
+    }
+    uint16_t crc = proto_crc16(0xFFFFu, &out[1], (size_t)len + 3);
+    out[4 + len] = (uint8_t)crc;
+    out[5 + len] = (uint8_t)(crc >> 8);
+    return total;
+}
+
+// ========== BORDAS EXPORTADAS ==========
+
+static size_t varint_put(uint8_t *out, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80u) {
+        out[n++] = (uint8_t)(v | 0x80u);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+void proto_edges_reset(proto_edge_writer_t *w) {
+    memset(w->t_us, 0, sizeof(w->t_us));
+    memset(w->seq, 0, sizeof(w->seq));
+    w->seeded[0] = w->seeded[1] = true;
+    proto_edges_start(w);
+}
+
+void proto_edges_join(proto_edge_writer_t *w) {
+    proto_edges_reset(w);
+    w->seeded[0] = w->seeded[1] = false;
+}
+
+void proto_edges_start(proto_edge_writer_t *w) {
+    proto_edges_t head;
+    memcpy(head.t_us, w->t_us, sizeof(head.t_us));
+    memcpy(head.seq, w->seq, sizeof(head.seq));
+    memcpy(w->payload, &head, sizeof(head));
+    w->len = sizeof(head);
+    w->count = 0;
+}
+
+bool proto_edges_add(proto_edge_writer_t *w, uint8_t channel, uint64_t seq, uint64_t t_us) {
+    uint8_t rec[20];
+
+    // Nenhum registro da saída no quadro ainda: o cabeçalho pode mudar
+    if (!w->seeded[channel]) {
+        w->seeded[channel] = true;
+        w->seq[channel] = seq - 1;
+        w->t_us[channel] = t_us;
+        memcpy(&w->payload[offsetof(proto_edges_t, t_us) + channel * sizeof(uint64_t)], &t_us,
+               sizeof(uint64_t));
+        memcpy(&w->payload[offsetof(proto_edges_t, seq) + channel * sizeof(uint64_t)],
+               &w->seq[channel], sizeof(uint64_t));
+    }
+    uint64_t dt = (t_us > w->t_us[channel]) ? t_us - w->t_us[channel] : 0;
+    bool gap = (seq != w->seq[channel] + 1);
+
+    // dt < 2^62 com folga: o relógio do boot levaria milênios para chegar lá
+    size_t n = varint_put(rec, (dt << 2) | ((uint64_t)gap << 1) | channel);
+    if (gap) {
+        n += varint_put(&rec[n], seq - w->seq[channel] - 1);
+    }
+    if (w->len + n > PROTO_MAX_PAYLOAD) {
+        return false;
+    }
+    memcpy(&w->payload[w->len], rec, n);
+    w->len += (uint16_t)n;
+    w->count++;
+    w->t_us[channel] = t_us;
+    w->seq[channel] = seq;
+    return true;
+}
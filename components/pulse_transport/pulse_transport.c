@@ -0,0 +1,70 @@
+#include "driver/uart.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "proto.h"
+#include "pulse_transport.h"
+
+#define UART_PORT           UART_NUM_0
+#define UART_BAUD_RATE      CONFIG_PULSE_UART_BAUD_RATE
+#define UART_BUFFER_SIZE    CONFIG_PULSE_UART_RX_BUFFER_SIZE
+
+static int64_t rx_at_us = 0;
+
+void pulse_transport_init(void) {
+    uart_config_t uart_config = {
+        .baud_rate = UART_BAUD_RATE,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    ESP_ERROR_CHECK(uart_param_config(UART_PORT, &uart_config));
+    ESP_ERROR_CHECK(uart_set_pin(UART_PORT, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE,
+                                UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+
+    ESP_ERROR_CHECK(uart_driver_install(UART_PORT, UART_BUFFER_SIZE, 0, 0, NULL, 0));
+}
+
+// Espera só o primeiro byte e leva o que já chegou: um quadro curto não
+// fica parado até encher buf ou vencer o timeout
+int pulse_transport_read(uint8_t *buf, size_t len, TickType_t timeout) {
+    int n = uart_read_bytes(UART_PORT, buf, 1, timeout);
+    if (n <= 0) {
+        return n;
+    }
+    rx_at_us = esp_timer_get_time();
+
+    size_t more = 0;
+    uart_get_buffered_data_len(UART_PORT, &more);
+    if (more > len - 1) {
+        more = len - 1;
+    }
+    if (more) {
+        int m = uart_read_bytes(UART_PORT, buf + 1, more, 0);
+        if (m > 0) {
+            n += m;
+        }
+    }
+    return n;
+}
+
+int64_t pulse_transport_rx_time_us(void) {
+    return rx_at_us;
+}
+
+char pulse_transport_getc(void) {
+    uint8_t data;
+    while (uart_read_bytes(UART_PORT, &data, 1, 100 / portTICK_PERIOD_MS) <= 0) {
+    }
+    return (char)data;
+}
+
+void pulse_transport_send(uint8_t type, const void *payload, uint16_t len) {
+    uint8_t frame[PROTO_MAX_PAYLOAD + PROTO_OVERHEAD];
+    size_t n = proto_encode(frame, sizeof(frame), type, payload, len);
+    if (n) {
+        uart_write_bytes(UART_PORT, frame, n);
+    }
+}
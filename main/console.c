@@ -0,0 +1,1546 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "sdkconfig.h"
+#include "proto.h"
+#include "pulse_transport.h"
+#include "pulse_engine.h"
+#if CONFIG_PULSE_MODE_REPLAY
+#include "pattern_storage.h"
+#endif
+#if CONFIG_PULSE_NVS_STRESS
+#include "nvs_stress.h"
+#endif
+#if CONFIG_PULSE_STREAM
+#include "pulse_stream.h"
+#endif
+#if CONFIG_PULSE_CHECKPOINT
+#include "dose_checkpoint.h"
+#endif
+
+// ========== CONFIGURAÇÕES SIMPLIFICADAS ==========
+// Limites e pinos vêm do menu "Gerador de pulsos" (main/Kconfig.projbuild)
+#define GPIO_OUT_1          CONFIG_PULSE_GPIO_OUT_1
+#define GPIO_OUT_2          CONFIG_PULSE_GPIO_OUT_2
+#if CONFIG_PULSE_MODE_QUADRATURE
+#define GPIO_INDEX          CONFIG_PULSE_GPIO_INDEX
+#endif
+#define LOG_TAG             "PULSE_GEN"
+#define MAX_PPS             CONFIG_PULSE_MAX_PPS
+#define MIN_PPS             1
+#define MAX_INTERVAL_MS     CONFIG_PULSE_MAX_INTERVAL_MS
+#define MIN_INTERVAL_MS     ((1000 / MAX_PPS) > 0 ? (1000 / MAX_PPS) : 1)
+#define MIN_PULSE_MS        1
+#define MAX_PULSE_MS        CONFIG_PULSE_MAX_PULSE_MS
+#define MIN_SAFE_INTERVAL_MS CONFIG_PULSE_MIN_SAFE_INTERVAL_MS
+#define MAX_RAMP_MS         600000           // rampa mais longa (10 min)
+
+// ========== VARIÁVEIS GLOBAIS ==========
+static pulse_config_t active_configs[PULSE_CHANNELS];
+static int active_outputs = 0;
+static proto_parser_t proto_rx;
+#if CONFIG_PULSE_STREAM
+static uint32_t stream_mhz = 0;  // 0 = motor de tasks/timers
+#endif
+#if CONFIG_PULSE_MODE_METER
+// Perfil S0 recebido pelo protocolo; vale para as próximas configurações
+static meter_point_t meter_profile[METER_MAX_POINTS];
+static uint16_t meter_profile_loaded = 0;
+static uint16_t meter_profile_total = 0;
+#endif
+#if CONFIG_PULSE_WIDTH_SEQ
+// Tabela de larguras recebida pelo protocolo; vale para as próximas configurações
+static uint32_t width_table[WIDTH_MAX_TABLE];
+static uint16_t width_table_loaded = 0;
+static uint16_t width_table_total = 0;
+#endif
+#if CONFIG_PULSE_MODE_REPLAY
+// Biblioteca nova pelo protocolo, só enquanto o console espera por ela:
+// durante a reprodução o motor lê a partição
+static bool pattern_upload_open = false;
+static uint32_t pattern_upload_received = 0;
+static uint32_t pattern_upload_total = 0;
+static bool pattern_upload_done = false;
+#endif
+#if CONFIG_PULSE_CHECKPOINT
+static dose_t dose_resume;       // dose interrompida, se aceita a retomada
+#endif
+#if CONFIG_PULSE_EDGE_EXPORT
+// Instantes dos pulsos em quadros PROTO_EVT_EDGES no lugar das linhas de log;
+// ligado por PROTO_CMD_EDGE_EXPORT e mantido nas execuções seguintes
+static bool edge_export = false;
+static proto_edge_writer_t edge_writer;
+#endif
+
+// ========== VALIDAÇÃO ==========
+
+// Regras de tempo da configuração pelo console, das mudanças pelo protocolo
+// e da dose retomada: intervalo dentro de MAX_PPS (e de MAX_INTERVAL_MS no
+// intervalo fixo) e, nos modos em que a largura é livre, pulso mais a folga
+// mínima dentro do intervalo. width_us = 0 confere só a folga.
+static bool timing_valid(pulse_mode_t mode, uint64_t interval_us, uint32_t width_us) {
+    if (interval_us < 1000000u / MAX_PPS ||
+        (mode == MODE_DEFINED && interval_us > (uint64_t)MAX_INTERVAL_MS * 1000u)) {
+        return false;
+    }
+    if (mode != MODE_DEFINED && mode != MODE_NCO && mode != MODE_METER) {
+        return true;
+    }
+    return (uint64_t)width_us + MIN_SAFE_INTERVAL_MS * 1000u <= interval_us;
+}
+
+// ========== LOG E STATUS ==========
+
+#if CONFIG_PULSE_EDGE_EXPORT
+static void edge_flush(void) {
+    if (edge_writer.count) {
+        pulse_transport_send(PROTO_EVT_EDGES, edge_writer.payload, edge_writer.len);
+        proto_edges_start(&edge_writer);
+    }
+}
+
+static void edge_add(const log_record_t *rec) {
+    if (!proto_edges_add(&edge_writer, rec->channel, rec->count, rec->at_us)) {
+        edge_flush();
+        proto_edges_add(&edge_writer, rec->channel, rec->count, rec->at_us);
+    }
+}
+#endif
+
+static void log_drain(void) {
+    log_record_t rec;
+    while (pulse_engine_log_pop(&rec)) {
+        if (rec.missed) {
+            ESP_LOGW(LOG_TAG, "%s | PRAZO PERDIDO | pulso %llu | atraso %lu us | t=%llu us",
+                     active_configs[rec.channel].label, (unsigned long long)rec.count,
+                     (unsigned long)rec.late_us, (unsigned long long)rec.at_us);
+        }
+#if CONFIG_PULSE_EDGE_EXPORT
+        else if (edge_export) {
+            edge_add(&rec);
+        }
+#endif
+        else {
+            ESP_LOGI(LOG_TAG, "%s | Pulse %llu", active_configs[rec.channel].label,
+                     (unsigned long long)rec.count);
+        }
+    }
+#if CONFIG_PULSE_EDGE_EXPORT
+    edge_flush();
+#endif
+}
+
+// Fotografia do motor convertida para o formato do protocolo, mais o estado do sistema
+static void status_snapshot(proto_status_t *out) {
+    pulse_engine_status_t eng;
+    pulse_engine_snapshot(&eng);
+
+    memset(out, 0, sizeof(*out));
+    out->uptime_us = (uint64_t)esp_timer_get_time();
+    out->run_time_us = eng.run_time_us;
+    out->heap_free = esp_get_free_heap_size();
+    out->heap_min = esp_get_minimum_free_heap_size();
+    out->main_stack_free = uxTaskGetStackHighWaterMark(NULL) * sizeof(StackType_t);
+    out->log_drops = eng.log_drops;
+    out->running = eng.running;
+    out->paused = eng.paused;
+    out->channel_count = (uint8_t)eng.channel_count;
+
+    for (int i = 0; i < eng.channel_count; i++) {
+        const pulse_channel_status_t *src = &eng.channels[i];
+        const pulse_stats_t *st = &src->stats;
+        proto_channel_status_t *ch = &out->channels[i];
+
+        ch->state = (uint8_t)src->state;
+        ch->mode = (uint8_t)src->mode;
+        ch->pulse_count = src->pulse_count;
+        ch->stack_free = src->stack_free;
+        if (out->run_time_us > 0) {
+            ch->rate_mhz = (uint32_t)((double)ch->pulse_count * 1e9 / (double)out->run_time_us);
+        }
+        if (st->samples) {
+            ch->late_mean_us = (uint32_t)(st->late_sum_us / st->samples);
+            ch->width_err_mean_us = (uint32_t)(st->width_err_sum_us / st->samples);
+            ch->edge_cycles_mean = (uint32_t)(st->edge_cycles_sum / st->samples);
+        }
+        ch->late_max_us = st->late_max_us;
+        ch->width_err_max_us = st->width_err_max_us;
+        ch->missed = st->missed;
+        ch->skipped = st->skipped;
+        ch->last_missed_us = st->last_missed_us;
+        ch->edge_cycles_max = st->edge_cycles_max;
+#if CONFIG_PULSE_LOOKAHEAD
+        ch->fifo_min = (uint16_t)(CONFIG_PULSE_LOOKAHEAD_DEPTH - st->fifo_drain_max);
+        ch->underruns = st->underruns;
+#endif
+    }
+}
+
+#if CONFIG_PULSE_STREAM
+static void print_stream_status(void) {
+    pulse_stream_status_t st;
+    pulse_stream_snapshot(&st);
+    printf("%s: %s | stream " PULSE_STREAM_NAME " %lu MHz | %llu pulsos renderizados | %llu ms na saída | "
+           "faltas de DMA %lu | render %lu/%lu us por bloco\n",
+           active_configs[0].label, st.running ? "RODANDO" : "PARADO", (unsigned long)stream_mhz,
+           (unsigned long long)st.pulses, (unsigned long long)(st.samples / stream_mhz / 1000),
+           (unsigned long)st.underflows, (unsigned long)st.render_us_max,
+           (unsigned long)st.block_us);
+}
+#endif
+
+static void print_status(void) {
+    static const char *state_names[] = {"RODANDO", "PAUSADO", "PARADO"};
+    proto_status_t st;
+    status_snapshot(&st);
+
+    printf("\n--- STATUS ---\n");
+    printf("Uptime: %llu ms | Execução: %llu ms%s\n",
+           (unsigned long long)(st.uptime_us / 1000), (unsigned long long)(st.run_time_us / 1000),
+           st.paused ? " (pausado)" : "");
+    printf("Heap: %lu livre, %lu mínimo | Log descartado: %lu | Pilha main: %lu\n",
+           (unsigned long)st.heap_free, (unsigned long)st.heap_min,
+           (unsigned long)st.log_drops, (unsigned long)st.main_stack_free);
+#if CONFIG_PULSE_NVS_STRESS
+    printf("Estresse NVS: %lu gravações\n", (unsigned long)nvs_stress_writes());
+#endif
+#if CONFIG_PULSE_CHECKPOINT
+    dose_stats_t ds;
+    dose_get_stats(&ds);
+    if (ds.writes) {
+        printf("Checkpoint da dose: %lu gravações | %lu us última, %lu us média, %lu us máxima\n",
+               (unsigned long)ds.writes, (unsigned long)ds.last_us,
+               (unsigned long)(ds.sum_us / ds.writes), (unsigned long)ds.max_us);
+    }
+#endif
+#if CONFIG_PULSE_STREAM
+    if (stream_mhz) {
+        print_stream_status();
+        return;
+    }
+#endif
+    for (int i = 0; i < st.channel_count; i++) {
+        const proto_channel_status_t *ch = &st.channels[i];
+        printf("%s: %s | %llu pulsos | %lu.%03lu Hz | atraso %lu/%lu us | "
+               "largura ±%lu/%lu us | prazos perdidos %llu (%llu pulados, último %llu ms) | "
+               "ciclos/borda %lu/%lu | pilha %lu\n",
+               active_configs[i].label, state_names[ch->state],
+               (unsigned long long)ch->pulse_count,
+               (unsigned long)(ch->rate_mhz / 1000), (unsigned long)(ch->rate_mhz % 1000),
+               (unsigned long)ch->late_mean_us, (unsigned long)ch->late_max_us,
+               (unsigned long)ch->width_err_mean_us, (unsigned long)ch->width_err_max_us,
+               (unsigned long long)ch->missed, (unsigned long long)ch->skipped,
+               (unsigned long long)(ch->last_missed_us / 1000),
+               (unsigned long)ch->edge_cycles_mean, (unsigned long)ch->edge_cycles_max,
+               (unsigned long)ch->stack_free);
+#if CONFIG_PULSE_LOOKAHEAD
+        printf("%s: fila de prazos %d, mínimo %u | faltas %lu\n", active_configs[i].label,
+               CONFIG_PULSE_LOOKAHEAD_DEPTH, ch->fifo_min, (unsigned long)ch->underruns);
+#endif
+    }
+}
+
+#if CONFIG_PULSE_MODE_METER
+// Um quadro do perfil; false se fora de sequência ou maior que a tabela
+static bool meter_profile_frame(const proto_parser_t *p) {
+    const proto_meter_profile_t *hdr = (const proto_meter_profile_t *)p->payload;
+    if (p->len < sizeof(*hdr) || (p->len - sizeof(*hdr)) % sizeof(proto_meter_point_t) != 0) {
+        return false;
+    }
+    uint16_t n = (p->len - sizeof(*hdr)) / sizeof(proto_meter_point_t);
+    if (hdr->total > METER_MAX_POINTS || hdr->first + n > hdr->total ||
+        (hdr->first != 0 &&
+         (hdr->first != meter_profile_loaded || hdr->total != meter_profile_total))) {
+        return false;
+    }
+
+    if (hdr->first == 0) {
+        meter_profile_total = hdr->total;
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        meter_profile[hdr->first + i].t_ms = hdr->points[i].t_ms;
+        meter_profile[hdr->first + i].power_mw = hdr->points[i].power_mw;
+    }
+    meter_profile_loaded = hdr->first + n;
+    return true;
+}
+#endif
+
+#if CONFIG_PULSE_WIDTH_SEQ
+// Um quadro da tabela; false se fora de sequência, maior que a tabela ou
+// com largura nula
+static bool width_table_frame(const proto_parser_t *p) {
+    const proto_width_table_t *hdr = (const proto_width_table_t *)p->payload;
+    if (p->len < sizeof(*hdr) || (p->len - sizeof(*hdr)) % sizeof(uint32_t) != 0) {
+        return false;
+    }
+    uint16_t n = (p->len - sizeof(*hdr)) / sizeof(uint32_t);
+    if (hdr->total > WIDTH_MAX_TABLE || hdr->first + n > hdr->total ||
+        (hdr->first != 0 &&
+         (hdr->first != width_table_loaded || hdr->total != width_table_total))) {
+        return false;
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        if (hdr->widths_us[i] == 0) {
+            return false;
+        }
+    }
+
+    if (hdr->first == 0) {
+        width_table_total = hdr->total;
+    }
+    memcpy(&width_table[hdr->first], hdr->widths_us, n * sizeof(uint32_t));
+    width_table_loaded = hdr->first + n;
+    return true;
+}
+#endif
+
+#if CONFIG_PULSE_MODE_REPLAY
+// Um quadro da imagem; false fora da espera, fora de sequência ou se a
+// imagem completa não abre
+static bool pattern_upload_frame(const proto_parser_t *p) {
+    const proto_pattern_upload_t *hdr = (const proto_pattern_upload_t *)p->payload;
+    if (!pattern_upload_open || p->len < sizeof(*hdr)) {
+        return false;
+    }
+    uint32_t n = p->len - sizeof(*hdr);
+    if (hdr->offset == 0) {
+        pattern_upload_received = 0;
+        pattern_upload_total = 0;
+        pattern_upload_done = false;
+        if (!pattern_storage_begin(hdr->total)) {
+            return false;
+        }
+        pattern_upload_total = hdr->total;
+    } else if (hdr->total != pattern_upload_total) {
+        return false;
+    }
+    if (!pattern_storage_write(hdr->offset, hdr->data, n)) {
+        return false;
+    }
+
+    pattern_upload_received = hdr->offset + n;
+    if (pattern_upload_received == pattern_upload_total) {
+        pattern_upload_done = pattern_storage_finish() != NULL;
+        return pattern_upload_done;
+    }
+    return true;
+}
+#endif
+
+static void proto_dispatch(const proto_parser_t *p) {
+    switch (p->type) {
+    case PROTO_CMD_STATUS: {
+        proto_status_t st;
+        status_snapshot(&st);
+        pulse_transport_send(PROTO_RSP_STATUS, &st, sizeof(st));
+        break;
+    }
+#if CONFIG_PULSE_MODE_METER
+    case PROTO_CMD_METER_PROFILE:
+        if (meter_profile_frame(p)) {
+            pulse_transport_send(PROTO_RSP_METER_PROFILE, &meter_profile_loaded,
+                                 sizeof(meter_profile_loaded));
+        } else {
+            pulse_transport_send(PROTO_RSP_ERROR, &p->type, 1);
+        }
+        break;
+#endif
+#if CONFIG_PULSE_WIDTH_SEQ
+    case PROTO_CMD_WIDTH_TABLE:
+        if (width_table_frame(p)) {
+            pulse_transport_send(PROTO_RSP_WIDTH_TABLE, &width_table_loaded,
+                                 sizeof(width_table_loaded));
+        } else {
+            pulse_transport_send(PROTO_RSP_ERROR, &p->type, 1);
+        }
+        break;
+#endif
+#if CONFIG_PULSE_MODE_REPLAY
+    case PROTO_CMD_PATTERN_UPLOAD:
+        if (pattern_upload_frame(p)) {
+            pulse_transport_send(PROTO_RSP_PATTERN_UPLOAD, &pattern_upload_received,
+                                 sizeof(pattern_upload_received));
+        } else {
+            pulse_transport_send(PROTO_RSP_ERROR, &p->type, 1);
+        }
+        break;
+#endif
+#if CONFIG_PULSE_MODE_NCO
+    case PROTO_CMD_SET_FREQUENCY: {
+        const proto_set_frequency_t *cmd = (const proto_set_frequency_t *)p->payload;
+        if (p->len == sizeof(*cmd) && cmd->mhz >= 1 && cmd->mhz <= MAX_PPS * 1000u &&
+            pulse_engine_set_frequency(cmd->channel, cmd->mhz)) {
+            pulse_transport_send(PROTO_RSP_OK, &p->type, 1);
+        } else {
+            pulse_transport_send(PROTO_RSP_ERROR, &p->type, 1);
+        }
+        break;
+    }
+#endif
+#if CONFIG_PULSE_EDGE_EXPORT
+    case PROTO_CMD_EDGE_EXPORT:
+        if (p->len == 1 && p->payload[0] <= 1) {
+            // Os registros já no anel saem no formato novo; a contagem de
+            // cada saída segue de onde está, sem lacuna no primeiro pulso
+            edge_export = p->payload[0];
+            proto_edges_join(&edge_writer);
+            pulse_transport_send(PROTO_RSP_OK, &p->type, 1);
+        } else {
+            pulse_transport_send(PROTO_RSP_ERROR, &p->type, 1);
+        }
+        break;
+#endif
+    case PROTO_CMD_TIME_SYNC:
+        if (p->len == sizeof(uint64_t)) {
+            proto_time_sync_t ts;
+            memcpy(&ts.host_mark, p->payload, sizeof(ts.host_mark));
+            ts.rx_us = (uint64_t)pulse_transport_rx_time_us();
+            ts.tx_us = (uint64_t)esp_timer_get_time();
+            pulse_transport_send(PROTO_RSP_TIME_SYNC, &ts, sizeof(ts));
+        } else {
+            pulse_transport_send(PROTO_RSP_ERROR, &p->type, 1);
+        }
+        break;
+    case PROTO_CMD_STAGE: {
+        const proto_stage_t *cmd = (const proto_stage_t *)p->payload;
+        pulse_change_t change = {0};
+        bool ok = p->len == sizeof(*cmd) && cmd->channel < active_outputs &&
+                  cmd->mhz <= MAX_PPS * 1000u;
+        if (ok) {
+            // Os campos novos entre si; contra os valores em vigor, no motor
+            uint64_t interval_us = cmd->mhz ? 1000000000ull / cmd->mhz : cmd->interval_us;
+            ok = interval_us == 0 ||
+                 timing_valid(active_configs[cmd->channel].mode, interval_us, cmd->width_us);
+        }
+        if (ok) {
+            change.interval_us = cmd->interval_us;
+            change.width_us = cmd->width_us;
+            change.mhz = cmd->mhz;
+            ok = pulse_engine_stage(cmd->channel, &change);
+        }
+        pulse_transport_send(ok ? PROTO_RSP_OK : PROTO_RSP_ERROR, &p->type, 1);
+        break;
+    }
+    case PROTO_CMD_COMMIT: {
+        const proto_commit_t *cmd = (const proto_commit_t *)p->payload;
+        bool ok = p->len == sizeof(*cmd) && pulse_engine_commit(cmd->mask, cmd->together) > 0;
+        pulse_transport_send(ok ? PROTO_RSP_OK : PROTO_RSP_ERROR, &p->type, 1);
+        break;
+    }
+    default:
+        pulse_transport_send(PROTO_RSP_ERROR, &p->type, 1);
+        break;
+    }
+}
+
+// ========== IMPLEMENTAÇÃO ==========
+
+static int read_int_from_uart(const char *prompt, int min_val, int max_val) {
+    char input[12] = {0};
+    int index = 0;
+    char c;
+    
+    printf("\n%s (%d a %d): ", prompt, min_val, max_val);
+    
+    while (index < 11) {
+        c = pulse_transport_getc();
+        if (c == '\r' || c == '\n') {
+            if (index > 0) break;
+        } else if (c == 8 || c == 127) {
+            if (index > 0) {
+                index--;
+                printf("\b \b");
+            }
+        } else if (c >= '0' && c <= '9') {
+            input[index++] = c;
+            putchar(c);
+        }
+    }
+    printf("\n");
+    
+    if (index == 0) {
+        return -1;
+    }
+    
+    int value = atoi(input);
+    if (value < min_val || value > max_val) {
+        printf("Valor inválido! Use entre %d e %d.\n", min_val, max_val);
+        return -1;
+    }
+    return value;
+}
+
+static void print_header(void) {
+    printf("\n");
+    printf("========================================\n");
+    printf("          GERADOR DE PULSOS\n");
+    printf("             DABSTACK\n");
+    printf("========================================\n");
+}
+
+static int ask_number_of_outputs(void) {
+#if PULSE_CHANNELS == 1
+    return 1;
+#else
+    printf("\n--- CONFIGURAÇÃO DE SAÍDAS ---\n");
+    printf("1. Saída 1 (GPIO%d)\n", GPIO_OUT_1);
+    printf("2. Saída 2 (GPIO%d)\n", GPIO_OUT_2);
+    printf("3. Ambas saídas\n");
+    printf("Escolha (1-3): ");
+
+    char c = pulse_transport_getc();
+    printf("%c\n", c);
+    
+    return (c >= '1' && c <= '3') ? (c - '0') : 1;
+#endif
+}
+
+// Intervalo em µs, ou -1 em erro
+static int64_t ask_pps_config(void) {
+    printf("\n--- TIPO DE CONFIGURAÇÃO ---\n");
+    printf("I. Intervalo entre pulsos (ms)\n");
+    printf("P. Pulsos por segundo (PPS)\n");
+    printf("Escolha (I/P): ");
+
+    char c = pulse_transport_getc();
+    printf("%c\n", c);
+    
+    if (c == 'P' || c == 'p') {
+        int pps = read_int_from_uart("Pulsos por segundo", MIN_PPS, MAX_PPS);
+        if (pps < 0) return -1;
+        
+        int64_t interval_us = 1000000 / pps;
+        printf(">> %d PPS = %lld us entre pulsos\n", pps, (long long)interval_us);
+        return interval_us;
+    } else {
+        int interval_ms = read_int_from_uart("Intervalo entre pulsos (ms)", MIN_INTERVAL_MS, MAX_INTERVAL_MS);
+        return (interval_ms < 0) ? -1 : (int64_t)interval_ms * 1000;
+    }
+}
+
+static pulse_mode_t select_mode(void) {
+    printf("\n--- MODO DE OPERAÇÃO ---\n");
+    printf("D. Intervalo fixo\n");
+#if CONFIG_PULSE_MODE_RANDOM
+    printf("R. Intervalo aleatório\n");
+#endif
+#if CONFIG_PULSE_MODE_BURST
+    printf("B. Aleatório em rajadas (MMPP)\n");
+#endif
+#if CONFIG_PULSE_MODE_REPLAY
+    printf("T. Padrão da biblioteca (partição '%s')\n", PATTERN_PARTITION);
+#endif
+#if CONFIG_PULSE_MODE_MOTION
+    if (active_outputs == 1) {
+        printf("M. Motor de passo (STEP nesta saída, DIR no GPIO%d)\n", GPIO_OUT_2);
+    }
+#endif
+#if CONFIG_PULSE_MODE_NCO
+    printf("F. Frequência exata (NCO, resolução de mHz)\n");
+#endif
+#if CONFIG_PULSE_MODE_METER
+    printf("E. Medidor de energia S0 (perfil de carga)\n");
+#endif
+#if CONFIG_PULSE_MODE_QUADRATURE
+    if (active_outputs == 1) {
+        printf("Q. Encoder em quadratura (A nesta saída, B no GPIO%d)\n", GPIO_OUT_2);
+    }
+#endif
+    printf("Escolha: ");
+
+    char c = pulse_transport_getc();
+    printf("%c\n", c);
+    
+    if (c == 'D' || c == 'd') return MODE_DEFINED;
+#if CONFIG_PULSE_MODE_BURST
+    if (c == 'B' || c == 'b') return MODE_BURST;
+#endif
+#if CONFIG_PULSE_MODE_REPLAY
+    if (c == 'T' || c == 't') return MODE_REPLAY;
+#endif
+#if CONFIG_PULSE_MODE_MOTION
+    if ((c == 'M' || c == 'm') && active_outputs == 1) return MODE_MOTION;
+#endif
+#if CONFIG_PULSE_MODE_NCO
+    if (c == 'F' || c == 'f') return MODE_NCO;
+#endif
+#if CONFIG_PULSE_MODE_METER
+    if (c == 'E' || c == 'e') return MODE_METER;
+#endif
+#if CONFIG_PULSE_MODE_QUADRATURE
+    if ((c == 'Q' || c == 'q') && active_outputs == 1) return MODE_QUADRATURE;
+#endif
+#if CONFIG_PULSE_MODE_RANDOM
+    return MODE_RANDOM;
+#else
+    return MODE_DEFINED;
+#endif
+}
+
+#if CONFIG_PULSE_MODE_REPLAY
+// Atende quadros do protocolo até ENTER; uma imagem completa substitui a
+// biblioteca da partição
+static void wait_pattern_upload(void) {
+    printf("\nEnvie uma biblioteca nova (tools/patlib.py send) ou pressione ENTER: ");
+
+    proto_parser_reset(&proto_rx);
+    pattern_upload_received = 0;
+    pattern_upload_total = 0;
+    pattern_upload_done = false;
+    pattern_upload_open = true;
+    for (;;) {
+        uint8_t rx[64];
+        int n = pulse_transport_read(rx, sizeof(rx), portMAX_DELAY);
+        for (int k = 0; k < n; k++) {
+            if (proto_parser_busy(&proto_rx) || rx[k] == PROTO_SOF) {
+                if (proto_parser_feed(&proto_rx, rx[k])) {
+                    proto_dispatch(&proto_rx);
+                }
+            } else if (rx[k] == '\r' || rx[k] == '\n') {
+                printf("\n");
+                pattern_upload_open = false;
+                if (pattern_upload_done) {
+                    printf("Biblioteca nova: %lu bytes\n", (unsigned long)pattern_upload_total);
+                } else if (pattern_upload_total) {
+                    printf("Biblioteca incompleta ou inválida: %lu de %lu bytes\n",
+                           (unsigned long)pattern_upload_received,
+                           (unsigned long)pattern_upload_total);
+                }
+                return;
+            }
+        }
+    }
+}
+
+static bool ask_replay_config(pulse_config_t *config) {
+    wait_pattern_upload();
+    const pattern_lib_t *lib = pattern_storage_open();
+    if (!lib) return false;
+    if (lib->count == 0) {
+        printf("Biblioteca vazia!\n");
+        return false;
+    }
+
+    printf("\n--- BIBLIOTECA DE PADRÕES ---\n");
+    for (uint32_t i = 0; i < lib->count; i++) {
+        const pattern_entry_t *e = pattern_lib_entry(lib, i);
+        printf("%lu. %.*s (%s, %lu eventos, %llu us)\n", (unsigned long)(i + 1),
+               PATTERN_NAME_LEN, e->name,
+               e->kind == PATTERN_KIND_SEQUENCE ? "sequência" : "captura",
+               (unsigned long)e->event_count, (unsigned long long)e->duration_us);
+    }
+
+    int index = read_int_from_uart("Padrão", 1, (int)lib->count);
+    if (index < 0) return false;
+    const pattern_entry_t *entry = pattern_lib_entry(lib, (uint32_t)index - 1);
+    if (entry->event_count == 0) {
+        printf("Padrão vazio!\n");
+        return false;
+    }
+
+    int scale = read_int_from_uart("Escala de tempo (‰, 1000 = original)", 1, 100000);
+    if (scale < 0) return false;
+
+    pulse_replay_select(config, lib, entry, (uint32_t)scale);
+    return true;
+}
+#endif
+
+#if CONFIG_PULSE_MODE_MOTION
+// Movimento inteiro em uma configuração: perfil, passos, direção e limites
+static bool ask_motion_config(pulse_config_t *config) {
+    printf("\n--- MOTOR DE PASSO (STEP GPIO%d, DIR GPIO%d) ---\n", config->gpio, GPIO_OUT_2);
+    printf("T. Rampa trapezoidal (AVR446)\n");
+    printf("S. Curva S\n");
+    printf("Escolha (T/S): ");
+
+    char c = pulse_transport_getc();
+    printf("%c\n", c);
+    motion_profile_t profile = (c == 'S' || c == 's') ? MOTION_SCURVE : MOTION_TRAPEZOID;
+
+    printf("\nDireção - H: horário (DIR alto), A: anti-horário (DIR baixo): ");
+    char dir = pulse_transport_getc();
+    printf("%c\n", dir);
+
+    int steps = read_int_from_uart("Passos", 1, 10000000);
+    if (steps < 0) return false;
+    int v_max = read_int_from_uart("Velocidade máxima (passos/s)", MIN_PPS, MAX_PPS);
+    if (v_max < 0) return false;
+    int accel = read_int_from_uart("Aceleração (passos/s²)", 1, 1000000);
+    if (accel < 0) return false;
+    int width = read_int_from_uart("Largura do STEP (us)", 1, 1000);
+    if (width < 0) return false;
+
+    if ((uint32_t)width * 2u > 1000000u / (uint32_t)v_max) {
+        printf("STEP largo demais para a velocidade máxima!\n");
+        return false;
+    }
+    if (!pulse_motion_select(config, profile, (uint32_t)steps, (uint32_t)v_max,
+                             (uint32_t)accel, (uint32_t)width)) {
+        printf("Rampa mais longa que %d s!\n", MOTION_MAX_RAMP_S);
+        return false;
+    }
+    pulse_engine_dir_set(GPIO_OUT_2, !(dir == 'A' || dir == 'a'));
+    printf(">> Pico de %lu passos/s, %lu passos em cada rampa\n",
+           (unsigned long)motion_peak_rate(&config->motion), (unsigned long)config->motion.ramp_steps);
+    return true;
+}
+#endif
+
+#if CONFIG_PULSE_MODE_QUADRATURE
+// Programa de trechos com perfil de velocidade; sentidos opostos em trechos
+// seguidos fazem a reversão
+static bool ask_quadrature_config(pulse_config_t *config) {
+    quadrature_t *q = &config->quad;
+
+    printf("\n--- ENCODER EM QUADRATURA (A GPIO%d, B GPIO%d", config->gpio, GPIO_OUT_2);
+    if (GPIO_INDEX >= 0) {
+        printf(", índice GPIO%d", GPIO_INDEX);
+    }
+    printf(") ---\n");
+    printf("T. Rampa trapezoidal\n");
+    printf("S. Curva S\n");
+    printf("Escolha (T/S): ");
+
+    char c = pulse_transport_getc();
+    printf("%c\n", c);
+    motion_profile_t profile = (c == 'S' || c == 's') ? MOTION_SCURVE : MOTION_TRAPEZOID;
+
+    memset(q, 0, sizeof(*q));
+    for (uint8_t i = 0; i < QUAD_MAX_SEGMENTS; i++) {
+        printf("\nTrecho %d - sentido H: A adianta B, A: B adianta A: ", i + 1);
+        char dir = pulse_transport_getc();
+        printf("%c\n", dir);
+
+        int counts = read_int_from_uart("Contagens (4 por ciclo de A)", 1, 100000000);
+        if (counts < 0) return false;
+        int v_max = read_int_from_uart("Velocidade máxima (contagens/s)", MIN_PPS, MAX_PPS);
+        if (v_max < 0) return false;
+        int accel = read_int_from_uart("Aceleração (contagens/s²)", 1, 10000000);
+        if (accel < 0) return false;
+
+        if (!quad_segment_set(q, i, profile, (uint32_t)counts, (uint32_t)v_max,
+                              (uint32_t)accel, dir == 'A' || dir == 'a')) {
+            printf("Rampa mais longa que %d s!\n", MOTION_MAX_RAMP_S);
+            return false;
+        }
+        if (i + 1 == QUAD_MAX_SEGMENTS) {
+            break;
+        }
+        printf("\nOutro trecho? (S/N): ");
+        c = pulse_transport_getc();
+        printf("%c\n", c);
+        if (c != 'S' && c != 's') {
+            break;
+        }
+    }
+
+    int dwell_ms = read_int_from_uart("Parada entre trechos e ciclos (ms)", 0, 60000);
+    if (dwell_ms < 0) return false;
+    q->dwell_us = (uint32_t)dwell_ms * 1000u;
+
+    if (GPIO_INDEX >= 0) {
+        int per_rev = read_int_from_uart("Contagens por volta (índice)", 4, 1000000);
+        if (per_rev < 0) return false;
+        q->counts_per_rev = (uint32_t)per_rev;
+    }
+
+    int cycles = read_int_from_uart("Repetições do programa (0 = contínuo)", 0, 1000000);
+    if (cycles < 0) return false;
+    q->cycles = (uint32_t)cycles;
+
+    pulse_quadrature_select(config, GPIO_OUT_2, GPIO_INDEX);
+    uint32_t peak = quad_peak_rate(q);
+    printf(">> %d trecho(s), pico de %lu contagens/s (%lu Hz em A e B)\n", q->count,
+           (unsigned long)peak, (unsigned long)(peak / 4));
+    return true;
+}
+#endif
+
+#if CONFIG_PULSE_MODE_METER
+// Atende quadros do protocolo até ENTER; true se há um perfil completo.
+// C (ou ENTER sem perfil) fica com potência constante.
+static bool wait_meter_profile(void) {
+    printf("\nEnvie o perfil (tools/meter_profile.py send) e pressione ENTER,\n");
+    printf("ou C para potência constante: ");
+
+    proto_parser_reset(&proto_rx);
+    for (;;) {
+        uint8_t rx[64];
+        int n = pulse_transport_read(rx, sizeof(rx), portMAX_DELAY);
+        for (int k = 0; k < n; k++) {
+            if (proto_parser_busy(&proto_rx) || rx[k] == PROTO_SOF) {
+                if (proto_parser_feed(&proto_rx, rx[k])) {
+                    proto_dispatch(&proto_rx);
+                }
+            } else if (rx[k] == '\r' || rx[k] == '\n') {
+                printf("\n");
+                if (meter_profile_loaded != meter_profile_total) {
+                    printf("Perfil incompleto: %u de %u pontos\n", meter_profile_loaded,
+                           meter_profile_total);
+                    return false;
+                }
+                return meter_profile_total >= 2;
+            } else if (rx[k] == 'C' || rx[k] == 'c') {
+                printf("%c\n", rx[k]);
+                return false;
+            }
+        }
+    }
+}
+
+static bool ask_meter_config(pulse_config_t *config) {
+    meter_t *m = &config->meter;
+    uint16_t count;
+
+    printf("\n--- MEDIDOR DE ENERGIA (S0) ---\n");
+    if (meter_profile_total) {
+        printf("Perfil na memória: %u pontos\n", meter_profile_total);
+    }
+    if (wait_meter_profile()) {
+        memcpy(m->points, meter_profile, meter_profile_total * sizeof(meter_point_t));
+        count = meter_profile_total;
+    } else {
+        int watts = read_int_from_uart("Potência constante (W)", 1, METER_MAX_POWER_MW / 1000);
+        if (watts < 0) return false;
+        int seconds = read_int_from_uart("Duração (s)", 1, 4000000);
+        if (seconds < 0) return false;
+        m->points[0] = (meter_point_t){.t_ms = 0, .power_mw = (uint32_t)watts * 1000u};
+        m->points[1] = (meter_point_t){.t_ms = (uint32_t)seconds * 1000u,
+                                       .power_mw = (uint32_t)watts * 1000u};
+        count = 2;
+    }
+
+    int imp = read_int_from_uart("Constante do medidor (imp/kWh)", 1, 1000000);
+    if (imp < 0) return false;
+
+    printf("\nRepetir o perfil ao fim? (S/N): ");
+    char c = pulse_transport_getc();
+    printf("%c\n", c);
+
+    if (!pulse_meter_select(config, count, (uint32_t)imp, c == 'S' || c == 's')) {
+        printf("Perfil inválido (tempos, potência ou taxa)!\n");
+        return false;
+    }
+    uint32_t peak = meter_peak_rate(m);
+    if (peak > MAX_PPS) {
+        printf("Pico de %lu pulsos/s acima do limite de %d!\n", (unsigned long)peak, MAX_PPS);
+        return false;
+    }
+    double wh = meter_energy_wh(m);
+    printf(">> %u pontos, %lu Wh por passada (~%llu pulsos), pico de %lu pulsos/s\n", count,
+           (unsigned long)wh, (unsigned long long)(wh * imp / 1000.0), (unsigned long)peak);
+    return true;
+}
+#endif
+
+#if CONFIG_PULSE_MODE_BURST
+static bool ask_burst_config(pulse_config_t *config) {
+    printf("\n--- RAJADAS (MMPP) ---\n");
+    printf("A taxa configurada é a média de longo prazo.\n");
+
+    int factor = read_int_from_uart("Fator de rajada (taxa na rajada / taxa base)", 2, 100);
+    if (factor < 0) return false;
+
+    int enter = read_int_from_uart("Prob. de entrar em rajada por pulso (‰)", 1, 1000);
+    if (enter < 0) return false;
+
+    int leave = read_int_from_uart("Prob. de sair da rajada por pulso (‰)", 1, 1000);
+    if (leave < 0) return false;
+
+    mmpp_setup(&config->mmpp, config->interval_us, factor, enter, leave);
+    printf(">> Base: %lu us | Rajada: %lu us\n",
+           (unsigned long)config->mmpp.mean_us[0], (unsigned long)config->mmpp.mean_us[1]);
+    return true;
+}
+#endif
+
+#if CONFIG_PULSE_DEADTIME
+// O tempo morto mínimo cobre a largura do pulso, então um pulso nunca
+// invade o próximo evento
+static bool ask_deadtime_config(pulse_config_t *config) {
+    printf("\n--- TEMPO MORTO ---\n");
+    printf("S. Sem tempo morto\n");
+    printf("N. Não paralisável\n");
+    printf("P. Paralisável\n");
+    printf("Escolha (S/N/P): ");
+
+    char c = pulse_transport_getc();
+    printf("%c\n", c);
+
+    config->dead.model = DEADTIME_NONE;
+    if (c == 'N' || c == 'n') {
+        config->dead.model = DEADTIME_NONPARALYZABLE;
+    } else if (c == 'P' || c == 'p') {
+        config->dead.model = DEADTIME_PARALYZABLE;
+    } else {
+        return true;
+    }
+
+    int min_us = (config->pulse_duration_ms + MIN_SAFE_INTERVAL_MS) * 1000;
+    int tau_us = read_int_from_uart("Tempo morto (us)", min_us, MAX_PULSE_MS * 1000);
+    if (tau_us < 0) return false;
+    config->dead.tau_us = (uint32_t)tau_us;
+    return true;
+}
+#endif
+
+#if CONFIG_PULSE_MODE_RANDOM && PULSE_CHANNELS == 2
+static bool ask_coincidence_config(pulse_config_t *a, pulse_config_t *b) {
+    printf("\n--- COINCIDÊNCIAS ENTRE SAÍDAS ---\n");
+
+    int permille = read_int_from_uart("Coincidências (‰ dos eventos da saída mais lenta)", 0, 1000);
+    if (permille < 0) return false;
+
+    int seed = read_int_from_uart("Semente (0 = aleatória)", 0, 999999999);
+    if (seed < 0) return false;
+
+    pulse_coincidence_setup(a, b, permille, (uint32_t)seed);
+    if (permille > 0) {
+        printf(">> Comum: %lu us | OUT1: %lu us | OUT2: %lu us\n",
+               (unsigned long)a->common.mean_us, (unsigned long)a->indep.mean_us,
+               (unsigned long)b->indep.mean_us);
+    }
+    return true;
+}
+#endif
+
+static bool ask_deadline_config(deadline_t *deadline) {
+    printf("\n--- PRAZOS ---\n");
+
+    int tolerance = read_int_from_uart("Tolerância de atraso (us)", 0, 1000000);
+    if (tolerance < 0) return false;
+
+    printf("F. Dispara atrasado e mantém a grade\n");
+    printf("P. Pula o pulso atrasado\n");
+    printf("R. Refase a partir do atraso\n");
+    printf("Escolha (F/P/R): ");
+
+    char c = pulse_transport_getc();
+    printf("%c\n", c);
+
+    deadline->tolerance_us = (uint32_t)tolerance;
+    deadline->policy = DEADLINE_FIRE_LATE;
+    if (c == 'P' || c == 'p') {
+        deadline->policy = DEADLINE_SKIP;
+    } else if (c == 'R' || c == 'r') {
+        deadline->policy = DEADLINE_REPHASE;
+    }
+    return true;
+}
+
+static int ask_pulse_limit(void) {
+    printf("\n--- LIMITE DE PULSOS ---\n");
+    printf("S. Com limite\n");
+    printf("N. Sem limite (contínuo)\n");
+    printf("Escolha (S/N): ");
+
+    char c = pulse_transport_getc();
+    printf("%c\n", c);
+    
+    if (c == 'S' || c == 's') {
+        return read_int_from_uart("Quantidade de pulsos", 1, 1000000);
+    }
+    return 0;
+}
+
+#if CONFIG_PULSE_WIDTH_SEQ
+// Espera a tabela pelo protocolo; ENTER aceita a que estiver completa
+static bool wait_width_table(void) {
+    printf("\nEnvie a tabela (tools/width_table.py send) e pressione ENTER,\n");
+    printf("ou C para cancelar: ");
+
+    proto_parser_reset(&proto_rx);
+    for (;;) {
+        uint8_t rx[64];
+        int n = pulse_transport_read(rx, sizeof(rx), portMAX_DELAY);
+        for (int k = 0; k < n; k++) {
+            if (proto_parser_busy(&proto_rx) || rx[k] == PROTO_SOF) {
+                if (proto_parser_feed(&proto_rx, rx[k])) {
+                    proto_dispatch(&proto_rx);
+                }
+            } else if (rx[k] == '\r' || rx[k] == '\n') {
+                printf("\n");
+                if (width_table_loaded != width_table_total) {
+                    printf("Tabela incompleta: %u de %u larguras\n", width_table_loaded,
+                           width_table_total);
+                    return false;
+                }
+                return width_table_total > 0;
+            } else if (rx[k] == 'C' || rx[k] == 'c') {
+                printf("%c\n", rx[k]);
+                return false;
+            }
+        }
+    }
+}
+
+// Largura por pulso no intervalo fixo e no NCO; a maior largura possível
+// precisa da mesma folga que a fixa
+static bool ask_width_config(pulse_config_t *config) {
+    width_seq_t *w = &config->wseq;
+    int max_us = MAX_PULSE_MS * 1000;
+
+    printf("\n--- LARGURA DO PULSO ---\n");
+    printf("F. Fixa (%d ms)\n", config->pulse_duration_ms);
+    printf("T. Tabela pelo protocolo");
+    if (width_table_total) {
+        printf(" (%u larguras na memória)", width_table_total);
+    }
+    printf("\nV. Varredura linear\n");
+    printf("A. Aleatória uniforme\n");
+    printf("Escolha: ");
+
+    char c = pulse_transport_getc();
+    printf("%c\n", c);
+
+    if (c == 'T' || c == 't') {
+        if (!wait_width_table()) {
+            return false;
+        }
+        w->source = WIDTH_TABLE;
+        memcpy(w->table, width_table, width_table_total * sizeof(uint32_t));
+        w->count = width_table_total;
+    } else if (c == 'V' || c == 'v' || c == 'A' || c == 'a') {
+        bool sweep = (c == 'V' || c == 'v');
+        int from_us = read_int_from_uart(sweep ? "Largura inicial (us)" : "Largura mínima (us)",
+                                         1, max_us);
+        if (from_us < 0) return false;
+        int to_us = read_int_from_uart(sweep ? "Largura final (us)" : "Largura máxima (us)",
+                                       sweep ? 1 : from_us, max_us);
+        if (to_us < 0) return false;
+        w->source = WIDTH_RANDOM;
+        w->from_us = (uint32_t)from_us;
+        w->to_us = (uint32_t)to_us;
+        w->seed = 0;
+        if (sweep) {
+            int step_us = read_int_from_uart("Passo por pulso (us)", 1, max_us);
+            if (step_us < 0) return false;
+            printf("\nVoltar descendo (triângulo)? (S/N): ");
+            char t = pulse_transport_getc();
+            printf("%c\n", t);
+            w->source = WIDTH_SWEEP;
+            w->step_us = (uint32_t)step_us;
+            w->triangle = (t == 'S' || t == 's');
+        }
+    } else {
+        return true;
+    }
+
+    uint64_t need_us = (uint64_t)width_max_us(w) + MIN_SAFE_INTERVAL_MS * 1000u;
+    if (need_us > config->interval_us || !pulse_width_select(config)) {
+        printf("Largura máxima não cabe no intervalo!\n");
+        return false;
+    }
+    return true;
+}
+#endif
+
+#if CONFIG_PULSE_RAMP
+// Rampas só no intervalo fixo; uma rampa curta demais para o intervalo fica
+// desligada e a saída parte na taxa plena
+static bool ask_ramp_config(pulse_config_t *config) {
+    printf("\n--- RAMPAS (0 = sem) ---\n");
+    int up_ms = read_int_from_uart("Subida na partida e na retomada (ms)", 0, MAX_RAMP_MS);
+    if (up_ms < 0) {
+        return false;
+    }
+    int down_ms = read_int_from_uart("Descida no fim (ms)", 0, MAX_RAMP_MS);
+    if (down_ms < 0) {
+        return false;
+    }
+    if ((up_ms || down_ms) && !pulse_ramp_select(config, (uint32_t)up_ms, (uint32_t)down_ms)) {
+        printf(">> Rampas curtas demais para o intervalo (mínimo de 4 intervalos)\n");
+    } else if ((up_ms && config->ramp.up_steps == 0) || (down_ms && config->ramp.down_steps == 0)) {
+        printf(">> Uma das rampas é curta demais para o intervalo e ficou desligada\n");
+    }
+    return true;
+}
+#endif
+
+#if CONFIG_PULSE_STREAM
+// Só com uma saída: I2S e SPI têm uma linha de dados no C3 (a quadratura
+// precisa de duas)
+static bool ask_stream_config(void) {
+    stream_mhz = 0;
+    if (active_outputs != 1) {
+        return true;
+    }
+#if CONFIG_PULSE_MODE_QUADRATURE
+    if (active_configs[0].mode == MODE_QUADRATURE) {
+        return true;
+    }
+#endif
+    printf("\n--- SAÍDA POR DMA ---\n");
+    printf("S. Stream " PULSE_STREAM_NAME " (bordas na grade de amostras, sem pausa)\n");
+    printf("N. Motor normal\n");
+    printf("Escolha (S/N): ");
+
+    char c = pulse_transport_getc();
+    printf("%c\n", c);
+
+    if (c == 'S' || c == 's') {
+        int mhz = read_int_from_uart("Taxa de amostragem (MHz)", PULSE_STREAM_MIN_MHZ,
+                                     PULSE_STREAM_MAX_MHZ);
+        if (mhz < 0) {
+            return false;
+        }
+        if (!pulse_stream_rate_valid((uint32_t)mhz)) {
+            printf("Taxa sem divisor inteiro do clock do " PULSE_STREAM_NAME "!\n");
+            return false;
+        }
+        stream_mhz = (uint32_t)mhz;
+    }
+    return true;
+}
+#endif
+
+static bool generator_busy(void) {
+#if CONFIG_PULSE_STREAM
+    if (stream_mhz) {
+        return pulse_stream_busy();
+    }
+#endif
+    return pulse_engine_busy();
+}
+
+// SISTEMA DE PAUSA/RETOMADA
+static void handle_pause_system(void) {
+#if CONFIG_PULSE_STREAM
+    if (stream_mhz) {
+        printf("\n>> Stream " PULSE_STREAM_NAME " não pausa\n");
+        return;
+    }
+#endif
+    if (pulse_engine_toggle_pause()) {
+        printf("\n>> SISTEMA PAUSADO - Espaço para retomar\n");
+    } else {
+        printf("\n>> SISTEMA RETOMADO\n");
+    }
+}
+
+#if CONFIG_PULSE_RAMP
+static void handle_finish(void) {
+#if CONFIG_PULSE_STREAM
+    if (stream_mhz) {
+        printf("\n>> Stream " PULSE_STREAM_NAME " não encerra antes do fim\n");
+        return;
+    }
+#endif
+    pulse_engine_finish();
+    printf("\n>> ENCERRANDO...\n");
+}
+#endif
+
+#if CONFIG_PULSE_NVS_STRESS
+// Cada mudança abre uma janela de medição nova
+static void handle_nvs_stress(void) {
+    uint32_t writes = nvs_stress_writes();
+    pulse_engine_reset_stats();
+    if (nvs_stress_toggle()) {
+        printf("\n>> ESTRESSE NVS LIGADO - estatísticas zeradas\n");
+    } else {
+        printf("\n>> ESTRESSE NVS DESLIGADO - %lu gravações; estatísticas zeradas\n",
+               (unsigned long)writes);
+    }
+}
+#endif
+
+static bool configure_output(int output_num, int gpio) {
+    printf("\n--- SAÍDA %d (GPIO%d) ---\n", output_num, gpio);
+    
+    pulse_config_t *config = &active_configs[output_num - 1];
+    
+    // Configuração básica
+    config->gpio = gpio;
+    config->label = (output_num == 1) ? "OUT1" : "OUT2";
+    config->min_gap_us = MIN_SAFE_INTERVAL_MS * 1000u;
+    
+    // Obter parâmetros
+    config->mode = select_mode();
+#if CONFIG_PULSE_MODE_MOTION
+    if (config->mode == MODE_MOTION) {
+        config->pulse_duration_ms = 0;
+        pulse_config_init(config);
+        return ask_motion_config(config);
+    }
+#endif
+#if CONFIG_PULSE_MODE_QUADRATURE
+    if (config->mode == MODE_QUADRATURE) {
+        config->pulse_duration_ms = 0;
+        pulse_config_init(config);
+        return ask_quadrature_config(config);
+    }
+#endif
+#if CONFIG_PULSE_MODE_REPLAY
+    if (config->mode == MODE_REPLAY) {
+        if (!ask_replay_config(config)) {
+            return false;
+        }
+    } else
+#endif
+#if CONFIG_PULSE_MODE_METER
+    if (config->mode == MODE_METER) {
+        if (!ask_meter_config(config)) {
+            return false;
+        }
+    } else
+#endif
+#if CONFIG_PULSE_MODE_NCO
+    if (config->mode == MODE_NCO) {
+        int mhz = read_int_from_uart("Frequência (mHz)", 1, MAX_PPS * 1000);
+        if (mhz < 0) {
+            return false;
+        }
+        pulse_nco_select(config, (uint32_t)mhz);
+    } else
+#endif
+    {
+        int64_t interval_us = ask_pps_config();
+        if (interval_us < 0) {
+            return false;
+        }
+        config->interval_us = (uint32_t)interval_us;
+    }
+    
+    config->pulse_duration_ms = read_int_from_uart("Duração do pulso (ms)", 
+                                                  MIN_PULSE_MS, MAX_PULSE_MS);
+    if (config->pulse_duration_ms < 0) {
+        return false;
+    }
+    if (!timing_valid(config->mode, config->interval_us, (uint32_t)config->pulse_duration_ms * 1000u)) {
+        printf("Pulso mais a folga de %d ms não cabe no intervalo!\n", MIN_SAFE_INTERVAL_MS);
+        return false;
+    }
+    
+    pulse_config_init(config);
+#if CONFIG_PULSE_MODE_BURST
+    if (config->mode == MODE_BURST && !ask_burst_config(config)) {
+        return false;
+    }
+#endif
+#if CONFIG_PULSE_DEADTIME
+    if ((config->mode == MODE_RANDOM || config->mode == MODE_BURST) &&
+        !ask_deadtime_config(config)) {
+        return false;
+    }
+#endif
+    int limit = ask_pulse_limit();
+    if (limit < 0) {
+        return false;
+    }
+    config->max_pulses = (uint64_t)limit;
+#if CONFIG_PULSE_WIDTH_SEQ
+    if ((config->mode == MODE_DEFINED || config->mode == MODE_NCO) && !ask_width_config(config)) {
+        return false;
+    }
+#endif
+#if CONFIG_PULSE_RAMP
+    if (config->mode == MODE_DEFINED && !ask_ramp_config(config)) {
+        return false;
+    }
+#endif
+#if CONFIG_PULSE_MODE_REPLAY
+    if (config->mode == MODE_REPLAY &&
+        (config->max_pulses == 0 || config->max_pulses > config->replay.entry->event_count)) {
+        config->max_pulses = config->replay.entry->event_count;
+    }
+#endif
+    return true;
+}
+
+#if CONFIG_PULSE_CHECKPOINT
+// A configuração gravada passa pelas regras de configure_output() deste
+// firmware, que podem ter mudado desde a gravação
+static bool resume_config_valid(pulse_config_t *config) {
+    if ((config->gpio != GPIO_OUT_1 && config->gpio != GPIO_OUT_2) ||
+        config->pulse_duration_ms < MIN_PULSE_MS || config->pulse_duration_ms > MAX_PULSE_MS ||
+        !timing_valid(config->mode, config->interval_us, (uint32_t)config->pulse_duration_ms * 1000u)) {
+        return false;
+    }
+#if CONFIG_PULSE_WIDTH_SEQ
+    if (config->wseq.source != WIDTH_FIXED &&
+        (!width_setup(&config->wseq) ||
+         !timing_valid(config->mode, config->interval_us, width_max_us(&config->wseq)))) {
+        return false;
+    }
+#endif
+    config->min_gap_us = MIN_SAFE_INTERVAL_MS * 1000u;
+    return true;
+}
+
+// Dose interrompida por reset: oferece retomar só os pulsos que faltam
+static bool ask_dose_resume(void) {
+    if (!dose_pending(&dose_resume, active_configs)) {
+        return false;
+    }
+    bool valid = dose_supported(active_configs, dose_resume.outputs);
+    for (int i = 0; valid && i < dose_resume.outputs; i++) {
+        valid = resume_config_valid(&active_configs[i]);
+    }
+    if (!valid) {
+        printf("\n>> Dose interrompida com configuração fora dos limites atuais; descartada\n");
+        dose_discard();
+        return false;
+    }
+
+    printf("\n--- DOSE INTERROMPIDA ---\n");
+    for (int i = 0; i < dose_resume.outputs; i++) {
+        pulse_config_t *config = &active_configs[i];
+        config->label = (config->gpio == GPIO_OUT_1) ? "OUT1" : "OUT2";
+        printf("%s: %llu de %llu pulsos, faltam %llu\n", config->label,
+               (unsigned long long)dose_resume.done[i], (unsigned long long)dose_resume.target[i],
+               (unsigned long long)config->max_pulses);
+    }
+    if (!dose_resume.exact) {
+        printf(">> Contagem do último checkpoint: os pulsos dados depois dele (até %d, "
+               "ou %d ms) se repetem\n", CONFIG_PULSE_CHECKPOINT_PULSES, CONFIG_PULSE_CHECKPOINT_MS);
+    }
+    printf("Retomar a dose? (S/N): ");
+    char c = pulse_transport_getc();
+    printf("%c\n", c);
+    if (c != 'S' && c != 's') {
+        dose_discard();
+        return false;
+    }
+
+    active_outputs = dose_resume.outputs;
+    for (int i = 0; i < active_outputs; i++) {
+        pulse_engine_gpio_init(active_configs[i].gpio);
+    }
+#if CONFIG_PULSE_STREAM
+    stream_mhz = 0;
+#endif
+    return true;
+}
+#endif
+
+// Pergunta tudo de uma execução nova; false se algo foi recusado
+static bool configure_run(void) {
+    // Configuração
+    int num_outputs = ask_number_of_outputs();
+    active_outputs = (num_outputs == 3) ? 2 : num_outputs;
+    
+    bool config_success = true;
+    
+    // Configurar saídas
+    for (int i = 0; i < active_outputs; i++) {
+        if (!configure_output(i + 1, (i == 0) ? GPIO_OUT_1 : GPIO_OUT_2)) {
+            config_success = false;
+            break;
+        }
+        pulse_engine_gpio_init(active_configs[i].gpio);
+    }
+
+#if CONFIG_PULSE_MODE_RANDOM && PULSE_CHANNELS == 2
+    if (config_success && active_outputs == 2 &&
+        active_configs[0].mode == MODE_RANDOM && active_configs[1].mode == MODE_RANDOM) {
+        config_success = ask_coincidence_config(&active_configs[0], &active_configs[1]);
+    }
+#endif
+
+#if CONFIG_PULSE_STREAM
+    if (config_success && !ask_stream_config()) {
+        config_success = false;
+    }
+#endif
+
+    deadline_t deadline;
+    if (config_success && !ask_deadline_config(&deadline)) {
+        config_success = false;
+    }
+#if CONFIG_PULSE_MODE_QUADRATURE
+    // Pular uma contagem mudaria A e B juntos na próxima
+    if (config_success && deadline.policy == DEADLINE_SKIP &&
+        active_configs[0].mode == MODE_QUADRATURE) {
+        printf(">> Quadratura não pula contagens: dispara atrasado\n");
+        deadline.policy = DEADLINE_FIRE_LATE;
+    }
+#endif
+
+    for (int i = 0; config_success && i < active_outputs; i++) {
+        active_configs[i].deadline = deadline;
+#if CONFIG_PULSE_DEADTIME
+        double true_rate;
+        if (!pulse_deadtime_apply(&active_configs[i], &true_rate)) {
+            printf("Taxa inatingível com esse tempo morto!\n");
+            config_success = false;
+        } else if (active_configs[i].dead.model != DEADTIME_NONE) {
+            deadtime_t *d = &active_configs[i].dead;
+            double expected = deadtime_observed_rate(true_rate, d->tau_us * 1e-6, d->model);
+            printf(">> %s: taxa verdadeira %lu mHz para %lu mHz observados\n",
+                   active_configs[i].label, (unsigned long)(true_rate * 1000.0),
+                   (unsigned long)(expected * 1000.0));
+        }
+#endif
+    }
+    return config_success;
+}
+
+void app_main(void) {
+    // Configuração inicial
+    pulse_transport_init();
+    esp_log_level_set("*", ESP_LOG_WARN);
+    esp_log_level_set(LOG_TAG, ESP_LOG_INFO);
+#if CONFIG_PULSE_NVS_STRESS
+    nvs_stress_init();
+#endif
+#if CONFIG_PULSE_CHECKPOINT
+    dose_init();
+#endif
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    while (1) {
+        print_header();
+        
+#if CONFIG_PULSE_CHECKPOINT
+        bool resumed = ask_dose_resume();
+        bool config_success = resumed || configure_run();
+#else
+        bool config_success = configure_run();
+#endif
+
+        if (!config_success) {
+            printf("Erro na configuração! Reiniciando...\n");
+            vTaskDelay(pdMS_TO_TICKS(2000));
+            continue;
+        }
+
+        // Resumo
+        printf("\n--- RESUMO ---\n");
+        for (int i = 0; i < active_outputs; i++) {
+            uint32_t mpps = (uint32_t)(1000000000ull / active_configs[i].interval_us);
+            printf("%s: %lu.%03lu PPS, %d ms pulse, %s\n", 
+                   active_configs[i].label, (unsigned long)(mpps / 1000), (unsigned long)(mpps % 1000), 
+                   active_configs[i].pulse_duration_ms,
+                   active_configs[i].max_pulses == 0 ? "Contínuo" : "Limitado");
+        }
+
+        // Confirmação
+        printf("\nPressione ENTER para iniciar, C para cancelar: ");
+        char start_cmd = pulse_transport_getc();
+        printf("%c\n", start_cmd);
+        
+        if (start_cmd == 'C' || start_cmd == 'c') {
+            continue;
+        }
+
+        printf("\n>> INICIANDO GERADOR...\n");
+        printf(">> BARRA DE ESPAÇO: Pausar/Retomar | S: Status\n");
+#if CONFIG_PULSE_NVS_STRESS
+        printf(">> N: Liga/desliga estresse da NVS (zera as estatísticas)\n");
+#endif
+#if CONFIG_PULSE_RAMP
+        printf(">> X: Encerrar (com a rampa de descida, se houver)\n");
+#endif
+        printf("========================================\n");
+
+        proto_parser_reset(&proto_rx);
+#if CONFIG_PULSE_EDGE_EXPORT
+        proto_edges_reset(&edge_writer);
+#endif
+        for (int i = 0; i < active_outputs; i++) {
+            ESP_LOGI(LOG_TAG, "%s INICIADO | %lu us | %d ms pulse | Max: %s",
+                     active_configs[i].label, (unsigned long)active_configs[i].interval_us,
+                     active_configs[i].pulse_duration_ms,
+                     active_configs[i].max_pulses == 0 ? "Infinito" : "");
+        }
+#if CONFIG_PULSE_CHECKPOINT
+        // O stream conta os pulsos ao renderizar, adiantado em relação à saída
+        bool checkpoint = dose_supported(active_configs, active_outputs);
+#if CONFIG_PULSE_STREAM
+        checkpoint = checkpoint && !stream_mhz;
+#endif
+        if (checkpoint) {
+            dose_begin(active_configs, active_outputs, resumed ? &dose_resume : NULL);
+        }
+#endif
+#if CONFIG_PULSE_STREAM
+        if (stream_mhz) {
+            esp_err_t err = pulse_stream_start(&active_configs[0], stream_mhz);
+            if (err != ESP_OK) {
+                printf("Falha ao iniciar o stream " PULSE_STREAM_NAME ": %s\n", esp_err_to_name(err));
+                vTaskDelay(pdMS_TO_TICKS(2000));
+                continue;
+            }
+        } else
+#endif
+        pulse_engine_start(active_configs, active_outputs);
+
+        // Loop principal de monitoramento
+        while (generator_busy()) {
+            // Comandos de texto e quadros binários na mesma UART
+            uint8_t rx[64];
+            // A leitura espera até 100 ms: é o ritmo do log e do checkpoint
+            int n = pulse_transport_read(rx, sizeof(rx), 100 / portTICK_PERIOD_MS);
+            for (int k = 0; k < n; k++) {
+                if (proto_parser_busy(&proto_rx) || rx[k] == PROTO_SOF) {
+                    if (proto_parser_feed(&proto_rx, rx[k])) {
+                        proto_dispatch(&proto_rx);
+                    }
+                } else if (rx[k] == ' ') {
+                    handle_pause_system();
+                } else if (rx[k] == 'S' || rx[k] == 's') {
+                    print_status();
+                }
+#if CONFIG_PULSE_NVS_STRESS
+                else if (rx[k] == 'N' || rx[k] == 'n') {
+                    handle_nvs_stress();
+                }
+#endif
+#if CONFIG_PULSE_RAMP
+                else if (rx[k] == 'X' || rx[k] == 'x') {
+                    handle_finish();
+                }
+#endif
+            }
+            log_drain();
+#if CONFIG_PULSE_CHECKPOINT
+            if (checkpoint) {
+                pulse_engine_status_t es;
+                pulse_engine_snapshot(&es);
+                dose_poll(&es);
+            }
+#endif
+        }
+
+        // Finalização - ORDEM CORRIGIDA DOS LOGS
+        pulse_engine_stop();
+#if CONFIG_PULSE_STREAM
+        if (stream_mhz) {
+            // O pino volta da matriz do periférico para GPIO ocioso
+            pulse_engine_gpio_init(active_configs[0].gpio);
+        }
+#endif
+#if CONFIG_PULSE_NVS_STRESS
+        nvs_stress_stop();
+#endif
+#if CONFIG_PULSE_CHECKPOINT
+        // Terminou no aparelho (limite ou tecla X): só um reset deixa dose pendente
+        if (checkpoint) {
+            dose_discard();
+        }
+#endif
+        log_drain();
+        printf("\n>> GERADOR FINALIZADO\n");
+        
+        // Agora mostra o resumo de pulsos gerados
+        for (int i = 0; i < active_outputs; i++) {
+            ESP_LOGI(LOG_TAG, "%s FINALIZADO | %llu pulsos gerados | %llu prazos perdidos", 
+                     active_configs[i].label, (unsigned long long)active_configs[i].pulse_count,
+                     (unsigned long long)active_configs[i].stats.missed);
+        }
+        
+        printf(">> Reiniciando em 2 segundos...\n");
+        vTaskDelay(pdMS_TO_TICKS(2000));
+        
+        // Aguardar tasks finalizarem
+        vTaskDelay(pdMS_TO_TICKS(500));
+    }
+}
\ No newline at end of file
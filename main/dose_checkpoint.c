@@ -0,0 +1,262 @@
+#include <stddef.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "sdkconfig.h"
+#include "dose_checkpoint.h"
+
+#define LOG_TAG             "PULSE_GEN"
+#define DOSE_NAMESPACE      "dose"
+#define DOSE_MAGIC          0x45534F44u  // "DOSE"
+#define DOSE_LAYOUT         1            // muda junto com dose_record_t
+#define CHECKPOINT_PULSES   CONFIG_PULSE_CHECKPOINT_PULSES
+#define CHECKPOINT_US       ((int64_t)CONFIG_PULSE_CHECKPOINT_MS * 1000)
+
+// Checkpoint na NVS ("hdr"); a configuração das saídas fica à parte ("cfg").
+// pulse_config_t muda com o Kconfig e entre versões do motor, então o
+// tamanho dela vai junto e uma dose de outro firmware não é retomada.
+typedef struct {
+    uint16_t layout;                 // DOSE_LAYOUT
+    uint16_t config_size;            // sizeof(pulse_config_t)
+    uint32_t id;                     // sorteado a cada execução; liga NVS e RTC
+    uint8_t outputs;
+    uint64_t target[PULSE_CHANNELS];
+    uint64_t done[PULSE_CHANNELS];
+} dose_record_t;
+
+// Na RTC: início da execução em curso e a contagem espelhada pelo motor
+typedef struct {
+    uint32_t magic;
+    uint32_t id;
+    uint64_t base[PULSE_CHANNELS];   // pulsos dados antes desta execução
+    uint32_t crc;                    // dos campos acima
+    pulse_mirror_t mirror[PULSE_CHANNELS];
+} dose_rtc_t;
+
+static RTC_NOINIT_ATTR dose_rtc_t rtc_dose;
+static pulse_config_t saved_configs[PULSE_CHANNELS];
+static dose_record_t record;
+static bool recording = false;
+static uint64_t saved_total = 0;     // pulsos no último checkpoint
+static int64_t saved_at_us = 0;
+static dose_stats_t stats;
+
+// ========== ARMAZENAMENTO ==========
+
+void dose_init(void) {
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        err = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(err);
+}
+
+static uint32_t rtc_crc(void) {
+    return esp_rom_crc32_le(0, (const uint8_t *)&rtc_dose, offsetof(dose_rtc_t, crc));
+}
+
+// Maior contagem válida das duas vagas
+static bool mirror_count(const pulse_mirror_t *m, uint64_t *count) {
+    bool valid = false;
+    for (int s = 0; s < 2; s++) {
+        if (m->slot[s].check == ~m->slot[s].count && (!valid || m->slot[s].count > *count)) {
+            *count = m->slot[s].count;
+            valid = true;
+        }
+    }
+    return valid;
+}
+
+// Grava o cabeçalho (e a configuração, se dada) e mede a gravação inteira
+static bool record_write(const pulse_config_t *configs) {
+    nvs_handle_t handle;
+    if (nvs_open(DOSE_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Falha ao abrir a NVS!");
+        return false;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = ESP_OK;
+    if (configs) {
+        err = nvs_set_blob(handle, "cfg", configs, record.outputs * sizeof(pulse_config_t));
+    }
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, "hdr", &record, sizeof(record));
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    nvs_close(handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Falha no checkpoint da dose: %s", esp_err_to_name(err));
+        return false;
+    }
+    stats.writes++;
+    stats.last_us = us;
+    if (us > stats.max_us) stats.max_us = us;
+    stats.sum_us += us;
+    return true;
+}
+
+// ========== DOSE ==========
+
+bool dose_supported(const pulse_config_t *configs, int outputs) {
+    for (int i = 0; i < outputs; i++) {
+        if (configs[i].max_pulses == 0) {
+            return false;
+        }
+        // Replay, movimento, quadratura e medidor dependem da posição na
+        // sequência, que não recomeça do meio
+        switch (configs[i].mode) {
+        case MODE_DEFINED:
+#if CONFIG_PULSE_MODE_RANDOM
+        case MODE_RANDOM:
+#endif
+#if CONFIG_PULSE_MODE_BURST
+        case MODE_BURST:
+#endif
+#if CONFIG_PULSE_MODE_NCO
+        case MODE_NCO:
+#endif
+            break;
+        default:
+            return false;
+        }
+    }
+    return outputs > 0;
+}
+
+bool dose_pending(dose_t *dose, pulse_config_t *configs) {
+    nvs_handle_t handle;
+    if (nvs_open(DOSE_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    size_t len = sizeof(record);
+    esp_err_t err = nvs_get_blob(handle, "hdr", &record, &len);
+    bool found = err == ESP_OK && len == sizeof(record) && record.layout == DOSE_LAYOUT &&
+                 record.config_size == sizeof(pulse_config_t) &&
+                 record.outputs >= 1 && record.outputs <= PULSE_CHANNELS;
+    if (found) {
+        len = sizeof(saved_configs);
+        found = nvs_get_blob(handle, "cfg", saved_configs, &len) == ESP_OK &&
+                len == record.outputs * sizeof(pulse_config_t);
+    }
+    nvs_close(handle);
+    if (!found) {
+        // Gravada por outro firmware (ou incompleta): não há como retomar
+        if (err != ESP_ERR_NVS_NOT_FOUND) {
+            ESP_LOGW(LOG_TAG, "Dose gravada em outro formato; descartada");
+            dose_discard();
+        }
+        return false;
+    }
+
+    // Depois de ligar, a RTC tem lixo; nos outros resets ela vale se for
+    // desta execução e o CRC bater
+    esp_reset_reason_t reason = esp_reset_reason();
+    dose->exact = reason != ESP_RST_POWERON && reason != ESP_RST_UNKNOWN &&
+                  rtc_dose.magic == DOSE_MAGIC && rtc_dose.id == record.id &&
+                  rtc_dose.crc == rtc_crc();
+    dose->outputs = 0;
+
+    for (int i = 0; i < record.outputs; i++) {
+        uint64_t done = record.done[i];
+        uint64_t count;
+        if (dose->exact && mirror_count(&rtc_dose.mirror[i], &count)) {
+            if (rtc_dose.base[i] + count > done) done = rtc_dose.base[i] + count;
+        } else {
+            dose->exact = false;
+        }
+        if (done >= record.target[i]) {
+            continue;
+        }
+
+        int n = dose->outputs++;
+        configs[n] = saved_configs[i];
+        configs[n].max_pulses = record.target[i] - done;
+        configs[n].label = NULL;
+        configs[n].task = NULL;
+        configs[n].mirror = NULL;
+        dose->target[n] = record.target[i];
+        dose->done[n] = done;
+    }
+
+    if (dose->outputs == 0) {
+        dose_discard();
+        return false;
+    }
+    return true;
+}
+
+void dose_begin(pulse_config_t *configs, int outputs, const dose_t *resume) {
+    record.layout = DOSE_LAYOUT;
+    record.config_size = sizeof(pulse_config_t);
+    record.id = esp_random();
+    record.outputs = (uint8_t)outputs;
+    saved_total = 0;
+
+    for (int i = 0; i < outputs; i++) {
+        record.target[i] = resume ? resume->target[i] : configs[i].max_pulses;
+        record.done[i] = resume ? resume->done[i] : 0;
+        saved_total += record.done[i];
+
+        rtc_dose.base[i] = record.done[i];
+        memset(&rtc_dose.mirror[i], 0, sizeof(rtc_dose.mirror[i]));
+        rtc_dose.mirror[i].slot[0].check = ~0ull;
+        configs[i].mirror = &rtc_dose.mirror[i];
+    }
+    rtc_dose.magic = DOSE_MAGIC;
+    rtc_dose.id = record.id;
+    rtc_dose.crc = rtc_crc();
+
+    saved_at_us = esp_timer_get_time();
+    recording = record_write(configs);
+}
+
+void dose_poll(const pulse_engine_status_t *st) {
+    if (!recording) {
+        return;
+    }
+
+    uint64_t total = 0;
+    for (int i = 0; i < record.outputs && i < st->channel_count; i++) {
+        record.done[i] = rtc_dose.base[i] + st->channels[i].pulse_count;
+        total += record.done[i];
+    }
+    int64_t now_us = esp_timer_get_time();
+    if (total == saved_total ||
+        (total - saved_total < CHECKPOINT_PULSES && now_us - saved_at_us < CHECKPOINT_US)) {
+        return;
+    }
+
+    // Uma falha fica no log e a próxima tentativa vem no próximo limite
+    record_write(NULL);
+    saved_total = total;
+    saved_at_us = now_us;
+}
+
+void dose_discard(void) {
+    recording = false;
+    rtc_dose.magic = 0;
+
+    nvs_handle_t handle;
+    if (nvs_open(DOSE_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        nvs_erase_key(handle, "hdr");
+        nvs_erase_key(handle, "cfg");
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+}
+
+void dose_get_stats(dose_stats_t *out) {
+    *out = stats;
+}
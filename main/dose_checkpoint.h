@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pulse_engine.h"
+
+// Dose persistente: quantos pulsos cada saída ainda deve dar, para retomar
+// depois de um reset. Cada pulso completo é contado na memória RTC pelo
+// motor (pulse_mirror_t), o que sobrevive a watchdog, pânico e brownout; a
+// NVS recebe checkpoints e cobre a falta de energia, perdendo no máximo os
+// pulsos desde o último.
+
+typedef struct {
+    int outputs;
+    uint64_t target[PULSE_CHANNELS]; // pulsos da dose inteira
+    uint64_t done[PULSE_CHANNELS];   // já emitidos
+    bool exact;                      // contagem da RTC; false = último checkpoint
+} dose_t;
+
+// Custo das gravações na NVS desde o boot
+typedef struct {
+    uint32_t writes;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+} dose_stats_t;
+
+void dose_init(void);
+
+// A dose pode ser retomada: intervalo fixo, aleatório, rajadas ou NCO, todas
+// as saídas com limite de pulsos
+bool dose_supported(const pulse_config_t *configs, int outputs);
+
+// Dose interrompida por reset: preenche configs só com as saídas que ainda
+// devem pulsos, com max_pulses = o que falta. A configuração é a do início
+// da dose, sem as mudanças feitas durante a geração; label fica NULL.
+bool dose_pending(dose_t *dose, pulse_config_t *configs);
+
+// Começa a contar antes de pulse_engine_start(); resume = dose_pending() ao
+// retomar, NULL para uma dose nova
+void dose_begin(pulse_config_t *configs, int outputs, const dose_t *resume);
+
+// Grava o checkpoint quando passaram CONFIG_PULSE_CHECKPOINT_PULSES pulsos
+// ou CONFIG_PULSE_CHECKPOINT_MS ms com progresso
+void dose_poll(const pulse_engine_status_t *st);
+
+// Execução terminada ou recusada: nada a retomar
+void dose_discard(void);
+
+void dose_get_stats(dose_stats_t *out);
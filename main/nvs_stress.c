@@ -0,0 +1,70 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "nvs_stress.h"
+
+#define LOG_TAG             "PULSE_GEN"
+#define STRESS_NAMESPACE    "stress"
+#define STRESS_TASK_STACK   3072
+#define STRESS_TASK_PRIO    1
+
+static volatile bool stress_running = false;
+static volatile uint32_t stress_writes = 0;
+static TaskHandle_t stress_handle = NULL;
+
+void nvs_stress_init(void) {
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        err = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(err);
+}
+
+// Cada commit apaga/grava páginas da flash com o cache desligado
+static void stress_task(void *pvParameter) {
+    nvs_handle_t handle;
+    if (nvs_open(STRESS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Falha ao abrir a NVS!");
+        stress_running = false;
+        stress_handle = NULL;
+        vTaskDelete(NULL);
+        return;
+    }
+
+    uint32_t value = 0;
+    while (stress_running) {
+        if (nvs_set_u32(handle, "counter", value++) == ESP_OK && nvs_commit(handle) == ESP_OK) {
+            stress_writes++;
+        }
+        vTaskDelay(1);
+    }
+
+    nvs_erase_key(handle, "counter");
+    nvs_commit(handle);
+    nvs_close(handle);
+    stress_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+bool nvs_stress_toggle(void) {
+    if (stress_running || stress_handle) {
+        // Desligando, ou a task anterior ainda está fechando a NVS
+        stress_running = false;
+        return false;
+    }
+    stress_writes = 0;
+    stress_running = true;
+    xTaskCreate(stress_task, "nvs_stress", STRESS_TASK_STACK, NULL, STRESS_TASK_PRIO, &stress_handle);
+    return true;
+}
+
+void nvs_stress_stop(void) {
+    stress_running = false;
+}
+
+uint32_t nvs_stress_writes(void) {
+    return stress_writes;
+}
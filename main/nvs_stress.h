@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Diagnóstico: grava na NVS sem parar enquanto os pulsos saem, para medir
+// o efeito das operações de flash no atraso e na largura das bordas.
+
+void nvs_stress_init(void);
+
+// Liga ou desliga a task de gravação; retorna true se ficou ligada
+bool nvs_stress_toggle(void);
+
+void nvs_stress_stop(void);
+
+// Gravações confirmadas desde que o estresse foi ligado
+uint32_t nvs_stress_writes(void);
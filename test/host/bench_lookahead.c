@@ -0,0 +1,282 @@
+#include <stdint.h>
+#include <string.h>
+#include "host_test.h"
+#include "pulse_engine.h"
+
+// Varredura de PULSE_LOOKAHEAD_DEPTH (K) e PULSE_LOOKAHEAD_REFILL nos modos
+// aleatório, MMPP e replay. Os prazos vêm do próprio motor
+// (pulse_sequence_next, o mesmo schedule_next que edge_refill chama); a fila,
+// a ISR e a task seguem edge_refill/edge_advance/pulse_run:
+//   - a ISR retira um prazo no fim de cada pulso e avisa a task quando
+//     restam REFILL ou menos;
+//   - a task acorda WAKE_US depois, calcula um prazo a cada ENTRY_US até
+//     encher a fila e não roda com o cache da flash desligado;
+//   - com a fila vazia a saída para (falta) até a task encher a fila e
+//     rearmar; o atraso é o do pulso que esperou.
+// WAKE_US, ENTRY_US e as paradas de cache são hipóteses, não medidas: os
+// números valem para comparar K e REFILL entre si, não como margem na placa.
+
+#define RUN_US              10000000ull     // 10 s de prazos por cenário
+#define MAX_DEPTH           128
+#define WIDTH_US            10
+#define WAKE_US             50              // aviso da ISR até a task rodar
+#define DEFAULT_DEPTH       32              // padrões do Kconfig
+#define DEFAULT_REFILL      16
+
+typedef struct {
+    const char *name;
+    uint32_t stall_us;       // cache desligado (gravação na NVS), a task parada
+    uint32_t stall_every_us;
+} stall_t;
+
+static const stall_t stalls[] = {
+    { "sem parada", 0, 1 },
+    { "10 ms/s sem cache", 10000, 1000000 },
+};
+
+typedef struct {
+    const char *name;
+    uint32_t entry_us;       // um prazo em edge_refill (RNG, MMPP, leitura da flash)
+    void (*setup)(pulse_config_t *c);
+} bench_mode_t;
+
+typedef struct {
+    uint64_t pulses;
+    uint64_t underruns;
+    uint32_t min_fill;
+    uint64_t late_max_us;    // maior atraso causado por uma falta
+} bench_result_t;
+
+typedef struct {
+    uint64_t due_us;
+    uint32_t width_us;
+} slot_t;
+
+typedef struct {
+    slot_t fifo[MAX_DEPTH];
+    uint32_t depth;
+    uint32_t head;
+    uint32_t tail;
+    bool last_queued;
+    bool busy;               // task acordada, enchendo a fila
+    uint64_t task_us;        // quando a task termina o próximo prazo
+    uint64_t push_us;        // quando entrou o último prazo
+} fifo_sim_t;
+
+// ========== MODOS ==========
+
+static void setup_random(pulse_config_t *c) {
+    c->mode = MODE_RANDOM;
+    c->interval_us = 200;
+    pulse_config_init(c);
+    c->indep.rng = seed_derive(42, 1);
+}
+
+// Rajadas 20 vezes mais rápidas em 1/6 dos pulsos
+static void setup_burst(pulse_config_t *c) {
+    c->mode = MODE_BURST;
+    c->interval_us = 500;
+    pulse_config_init(c);
+    c->rng = seed_derive(42, 2);
+    mmpp_setup(&c->mmpp, c->interval_us, 20, 20, 100);
+}
+
+// Captura com rajadas de 64 pulsos a 40..79 us e 20 ms entre elas, montada
+// direto no layout de pattern_lib.h
+static uint8_t image[64 * 1024];
+static pattern_lib_t lib;
+
+static uint32_t put_varint(uint8_t *p, uint64_t v) {
+    uint32_t n = 0;
+    do {
+        p[n++] = (uint8_t)((v & 0x7Fu) | (v > 0x7Fu ? 0x80u : 0));
+        v >>= 7;
+    } while (v);
+    return n;
+}
+
+static void build_replay(void) {
+    pattern_lib_header_t *hdr = (pattern_lib_header_t *)image;
+    pattern_entry_t *e = (pattern_entry_t *)(image + sizeof(*hdr));
+    uint32_t pos = sizeof(*hdr) + sizeof(*e);
+    uint32_t rng = seed_derive(42, 3);
+    uint64_t duration = 0;
+    uint32_t events = 0;
+
+    memset(e, 0, sizeof(*e));
+    strcpy(e->name, "rajadas");
+    e->kind = PATTERN_KIND_SEQUENCE;
+    e->offset = pos;
+    while (duration < RUN_US) {
+        for (int k = 0; k < 64; k++) {
+            uint32_t delta = (k == 0) ? 20000u : 40u + rng_next(&rng) % 40u;
+            pos += put_varint(image + pos, delta);
+            pos += put_varint(image + pos, WIDTH_US);
+            duration += delta;
+            events++;
+        }
+    }
+    e->length = pos - e->offset;
+    e->event_count = events;
+    e->duration_us = duration;
+    *hdr = (pattern_lib_header_t){
+        .magic = PATTERN_LIB_MAGIC,
+        .version = PATTERN_LIB_VERSION,
+        .entry_size = sizeof(pattern_entry_t),
+        .entry_count = 1,
+        .image_size = pos,
+    };
+    CHECK(pattern_lib_open(&lib, image, sizeof(image)), "imagem de replay inválida");
+}
+
+static void setup_replay(pulse_config_t *c) {
+    c->mode = MODE_REPLAY;
+    pulse_config_init(c);
+    pulse_replay_select(c, &lib, pattern_lib_entry(&lib, 0), 1000);
+}
+
+static const bench_mode_t modes[] = {
+    { "aleatório 200 us", 4, setup_random },
+    { "MMPP 500 us, rajadas x20", 5, setup_burst },
+    { "replay, rajadas de 64", 8, setup_replay },
+};
+
+// ========== FILA E TASK ==========
+
+// A task não roda durante a parada de cache, no fim de cada período
+static uint64_t task_runs_at(const stall_t *st, uint64_t t) {
+    uint64_t phase = t % st->stall_every_us;
+    uint64_t stall_from = st->stall_every_us - st->stall_us;
+    return (st->stall_us && phase >= stall_from) ? t + (st->stall_every_us - phase) : t;
+}
+
+static uint64_t task_step(const stall_t *st, const bench_mode_t *m, uint64_t t) {
+    return task_runs_at(st, task_runs_at(st, t) + m->entry_us);
+}
+
+static bool push(fifo_sim_t *s, pulse_config_t *c) {
+    uint64_t due;
+    uint32_t width;
+    if (!pulse_sequence_next(c, &due, &width)) {
+        s->last_queued = true;
+        return false;
+    }
+    s->fifo[s->head % s->depth] = (slot_t){ due, width };
+    s->head++;
+    return true;
+}
+
+static void wake(fifo_sim_t *s, const stall_t *st, const bench_mode_t *m, uint64_t now) {
+    s->busy = true;
+    s->task_us = task_step(st, m, now + WAKE_US);
+}
+
+// edge_refill() até 'now': um prazo por vez, até encher a fila
+static void task_until(fifo_sim_t *s, pulse_config_t *c, const stall_t *st, const bench_mode_t *m,
+                       uint64_t now) {
+    while (s->busy && s->task_us <= now) {
+        if (!push(s, c)) {
+            s->busy = false;
+            break;
+        }
+        s->push_us = s->task_us;
+        if (s->head - s->tail == s->depth) {
+            s->busy = false;
+            break;
+        }
+        s->task_us = task_step(st, m, s->task_us);
+    }
+}
+
+static bench_result_t simulate(const bench_mode_t *m, const stall_t *st, uint32_t depth,
+                               uint32_t refill) {
+    static pulse_config_t c;
+    static fifo_sim_t s;
+    memset(&c, 0, sizeof(c));
+    memset(&s, 0, sizeof(s));
+    c.gpio = 5;
+    c.width_us = WIDTH_US;
+    m->setup(&c);
+    pulse_sequence_start(&c);
+
+    // pulse_run enche a fila antes de partir o timer
+    s.depth = depth;
+    while (s.head < depth && push(&s, &c)) {
+    }
+
+    bench_result_t r = { .min_fill = depth };
+    uint64_t pop_us = 0;     // fim do pulso: a ISR pede o próximo prazo
+    for (;;) {
+        task_until(&s, &c, st, m, pop_us);
+        uint64_t arm_us = pop_us;
+        bool starved = (s.head == s.tail);
+        if (starved) {
+            if (s.last_queued) break;
+            r.underruns++;
+            r.min_fill = 0;
+            if (!s.busy) wake(&s, st, m, pop_us);
+            task_until(&s, &c, st, m, UINT64_MAX);
+            if (s.head == s.tail) break;
+            arm_us = s.push_us;
+        }
+        slot_t slot = s.fifo[s.tail % depth];
+        s.tail++;
+        uint32_t left = s.head - s.tail;
+        if (!starved && left < r.min_fill) r.min_fill = left;
+        if (left <= refill && !s.busy) wake(&s, st, m, arm_us);
+
+        uint64_t fall_us = (slot.due_us > arm_us) ? slot.due_us : arm_us;
+        if (starved && fall_us - slot.due_us > r.late_max_us) r.late_max_us = fall_us - slot.due_us;
+        if (fall_us >= RUN_US) break;
+        r.pulses++;
+        pop_us = fall_us + slot.width_us;
+    }
+    return r;
+}
+
+// ========== VARREDURA ==========
+
+static const uint32_t depths[] = { 8, 16, 32, 64, 128 };
+static const uint32_t refill_quarters[] = { 1, 2, 3 };
+#define N_STALLS (sizeof(stalls) / sizeof(stalls[0]))
+
+static void sweep(const bench_mode_t *m) {
+    printf("\n%s, %u us por prazo\n", m->name, m->entry_us);
+    printf("    K  reab |");
+    for (size_t k = 0; k < N_STALLS; k++) printf(" %-26s|", stalls[k].name);
+    printf("\n");
+
+    bench_result_t shallow[N_STALLS], deep[N_STALLS];
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+        for (size_t q = 0; q < sizeof(refill_quarters) / sizeof(refill_quarters[0]); q++) {
+            uint32_t depth = depths[d];
+            uint32_t refill = depth * refill_quarters[q] / 4;
+            printf("  %3u  %4u |", depth, refill);
+            for (size_t k = 0; k < N_STALLS; k++) {
+                bench_result_t r = simulate(m, &stalls[k], depth, refill);
+                printf(" %6llu faltas, mín %3u, %5llu us|", (unsigned long long)r.underruns,
+                       r.min_fill, (unsigned long long)r.late_max_us);
+                CHECK(r.pulses > 1000, "%s: só %llu pulsos", m->name, (unsigned long long)r.pulses);
+                if (d == 0 && q == 0) shallow[k] = r;
+                if (d == sizeof(depths) / sizeof(depths[0]) - 1 && q == 2) deep[k] = r;
+                if (k == 0 && depth == DEFAULT_DEPTH && refill == DEFAULT_REFILL) {
+                    CHECK(r.underruns == 0, "%s: %llu faltas com os padrões do Kconfig",
+                          m->name, (unsigned long long)r.underruns);
+                }
+            }
+            printf("\n");
+        }
+    }
+    // A varredura enxerga a parada de cache: a fila rasa seca e a funda segura mais
+    CHECK(shallow[1].underruns > 0, "%s: K = 8 atravessou a parada de cache sem faltas", m->name);
+    CHECK(deep[1].underruns <= shallow[1].underruns, "%s: K = 128 com mais faltas (%llu) que K = 8",
+          m->name, (unsigned long long)deep[1].underruns);
+}
+
+int main(void) {
+    build_replay();
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        sweep(&modes[i]);
+    }
+    return HOST_TEST_RESULT();
+}
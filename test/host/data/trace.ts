@@ -0,0 +1,6 @@
+# Captura: instantes em µs, fora de ordem e com um repetido
+1250
+1000
+1250
+5000
+4294972296      # 2^32 + 5000: delta de 2^32 µs, varint de 5 bytes
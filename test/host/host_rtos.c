@@ -0,0 +1,171 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "host_rtos.h"
+
+#define MAX_TASKS   4
+#define MAX_GPIO    32
+#define TASK_STACK  (256 * 1024)
+
+struct host_task {
+    TaskFunction_t fn;
+    void *arg;
+    ucontext_t ctx;
+    void *stack;
+    int64_t wake_us;         // dorme até aqui (vTaskDelay)
+    bool done;
+};
+
+int64_t host_clock_us = 0;
+int host_critical_nesting = 0;
+void (*host_gpio_hook)(int gpio, uint32_t level) = NULL;
+static struct host_task tasks[MAX_TASKS];
+static int task_count = 0;
+static int current = -1;     // task em execução; -1 = fora de host_rtos_run()
+static int live = 0;
+static ucontext_t scheduler;
+static uint32_t gpio_level[MAX_GPIO];
+static uint64_t gpio_falls[MAX_GPIO];
+
+// Devolve a vez ao escalonador; com uma task só não há para quem passar
+static void yield(void) {
+    if (current >= 0 && live > 1) {
+        swapcontext(&tasks[current].ctx, &scheduler);
+    }
+}
+
+int64_t esp_timer_get_time(void) {
+    int64_t now = host_clock_us++;
+    // Dentro de seção crítica a task não perde a CPU
+    if (host_critical_nesting == 0) {
+        yield();
+    }
+    return now;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t prio, TaskHandle_t *handle) {
+    (void)name; (void)stack; (void)prio;
+    if (task_count == MAX_TASKS) {
+        return pdFALSE;
+    }
+    tasks[task_count] = (struct host_task){ .fn = fn, .arg = arg };
+    if (handle) {
+        *handle = &tasks[task_count];
+    }
+    task_count++;
+    return pdPASS;
+}
+
+static void task_entry(int index) {
+    tasks[index].fn(tasks[index].arg);
+    tasks[index].done = true;
+    live--;
+}
+
+// Rodízio entre as tasks acordadas; com todas dormindo, o relógio salta
+// para o primeiro despertar
+void host_rtos_run(void) {
+    live = task_count;
+    for (int i = 0; i < task_count; i++) {
+        struct host_task *t = &tasks[i];
+        t->stack = malloc(TASK_STACK);
+        t->wake_us = host_clock_us;
+        getcontext(&t->ctx);
+        t->ctx.uc_stack.ss_sp = t->stack;
+        t->ctx.uc_stack.ss_size = TASK_STACK;
+        t->ctx.uc_link = &scheduler;
+        makecontext(&t->ctx, (void (*)(void))task_entry, 1, i);
+    }
+
+    int next = 0;
+    while (live > 0) {
+        int pick = -1;
+        int64_t first_wake = INT64_MAX;
+        for (int k = 0; k < task_count && pick < 0; k++) {
+            int i = (next + k) % task_count;
+            if (tasks[i].done) continue;
+            if (tasks[i].wake_us <= host_clock_us) pick = i;
+            else if (tasks[i].wake_us < first_wake) first_wake = tasks[i].wake_us;
+        }
+        if (pick < 0) {
+            host_clock_us = first_wake;
+            continue;
+        }
+        current = pick;
+        next = (pick + 1) % task_count;
+        swapcontext(&scheduler, &tasks[pick].ctx);
+        current = -1;
+    }
+
+    for (int i = 0; i < task_count; i++) {
+        free(tasks[i].stack);
+    }
+    task_count = 0;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    (void)task;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    int64_t wake_us = host_clock_us + (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+    if (current < 0) {
+        host_clock_us = wake_us;
+        return;
+    }
+    tasks[current].wake_us = wake_us;
+    yield();
+    // Sozinha, a task não passa pelo escalonador: o relógio salta aqui
+    if (host_clock_us < wake_us) {
+        host_clock_us = wake_us;
+    }
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    (void)task;
+    return 0;
+}
+
+void vTaskSuspendAll(void) {
+}
+
+BaseType_t xTaskResumeAll(void) {
+    return pdFALSE;
+}
+
+int gpio_reset_pin(gpio_num_t gpio) {
+    (void)gpio;
+    return 0;
+}
+
+int gpio_set_direction(gpio_num_t gpio, gpio_mode_t mode) {
+    (void)gpio; (void)mode;
+    return 0;
+}
+
+int gpio_set_level(gpio_num_t gpio, uint32_t level) {
+    if (gpio >= 0 && gpio < MAX_GPIO) {
+        if (gpio_level[gpio] && !level) {
+            gpio_falls[gpio]++;
+        }
+        gpio_level[gpio] = level;
+    }
+    if (host_gpio_hook) {
+        host_gpio_hook(gpio, level);
+    }
+    return 0;
+}
+
+uint32_t host_gpio_level(int gpio) {
+    return gpio_level[gpio];
+}
+
+uint64_t host_gpio_falls(int gpio) {
+    return gpio_falls[gpio];
+}
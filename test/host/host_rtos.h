@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+// Relógio e tasks virtuais para rodar o motor no Linux. Cada leitura do
+// relógio anda 1 µs (as esperas ativas terminam) e vTaskDelay anda os ticks
+// pedidos, então uma execução de horas leva milissegundos. Com mais de uma
+// task, cada leitura passa a vez à próxima acordada e vTaskDelay dorme até o
+// tick pedido, como as tasks de pulso das duas saídas no C3.
+extern int64_t host_clock_us;
+
+// Executa as tasks criadas desde a última chamada, intercaladas, até o fim de todas
+void host_rtos_run(void);
+
+// Nível atual de um pino e quantas descidas (início de pulso) ele teve
+uint32_t host_gpio_level(int gpio);
+uint64_t host_gpio_falls(int gpio);
+
+// Chamada depois de cada gpio_set_level, para o teste agir no meio da execução
+extern void (*host_gpio_hook)(int gpio, uint32_t level);
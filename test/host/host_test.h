@@ -0,0 +1,26 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+// Uma falha não para o teste: todas aparecem de uma vez e o código de saída
+// de main() (HOST_TEST_RESULT) diz ao ctest se houve alguma.
+static int host_test_failures = 0;
+
+#define CHECK(cond, ...) do {                                               \
+        if (!(cond)) {                                                      \
+            host_test_failures++;                                           \
+            printf("FALHA %s:%d: ", __FILE__, __LINE__);                    \
+            printf(__VA_ARGS__);                                            \
+            printf("\n");                                                   \
+        }                                                                   \
+    } while (0)
+
+// |got - want| <= tol * |want|
+#define CHECK_REL(got, want, tol, what)                                     \
+    CHECK(fabs((double)(got) - (double)(want)) <= (tol) * fabs((double)(want)), \
+          "%s = %.6g, esperado %.6g (±%.2g%%)", what, (double)(got), (double)(want), \
+          100.0 * (tol))
+
+#define HOST_TEST_RESULT() (host_test_failures ? (printf("%d falha(s)\n", host_test_failures), 1) \
+                                               : (printf("ok\n"), 0))
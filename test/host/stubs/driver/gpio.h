@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef int gpio_num_t;
+typedef enum { GPIO_MODE_OUTPUT = 2 } gpio_mode_t;
+
+int gpio_reset_pin(gpio_num_t gpio);
+int gpio_set_direction(gpio_num_t gpio, gpio_mode_t mode);
+int gpio_set_level(gpio_num_t gpio, uint32_t level);
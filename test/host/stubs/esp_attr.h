@@ -0,0 +1,6 @@
+#pragma once
+
+// No Linux não há IRAM nem memória RTC
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_NOINIT_ATTR
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdint.h>
+
+static inline uint32_t esp_cpu_get_cycle_count(void) {
+    return 0;
+}
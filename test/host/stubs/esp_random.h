@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+// Sequência fixa no lugar do RNG de hardware: os testes se repetem iguais
+static inline uint32_t esp_random(void) {
+    static uint32_t x = 0x2545F491u;
+    x = x * 1664525u + 1013904223u;
+    return x;
+}
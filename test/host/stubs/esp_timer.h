@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Relógio virtual de host_rtos.c
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+// FreeRTOS de um núcleo só, sem preempção: as tasks só trocam ao ler o
+// relógio virtual (host_rtos.h), e nunca dentro de uma seção crítica
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint8_t StackType_t;
+typedef int portMUX_TYPE;
+
+extern int host_critical_nesting;
+
+#define pdTRUE                          1
+#define pdFALSE                         0
+#define pdPASS                          1
+#define portMAX_DELAY                   UINT32_MAX
+#define portTICK_PERIOD_MS              1
+#define pdMS_TO_TICKS(ms)               ((TickType_t)(ms))
+#define portMUX_INITIALIZER_UNLOCKED    0
+#define portENTER_CRITICAL(mux)         ((void)(mux), host_critical_nesting++)
+#define portEXIT_CRITICAL(mux)          ((void)(mux), host_critical_nesting--)
+#define portENTER_CRITICAL_SAFE(mux)    portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_SAFE(mux)     portEXIT_CRITICAL(mux)
+#define portYIELD_FROM_ISR(x)           ((void)(x))
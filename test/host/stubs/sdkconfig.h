@@ -0,0 +1,16 @@
+#pragma once
+
+// Configuração dos testes no Linux: bordas pela task (sem ISR), então as
+// marcas de IRAM de pulse_attr.h ficam vazias.
+#define CONFIG_PULSE_CHANNELS               2
+#define CONFIG_PULSE_MODE_RANDOM            1
+#define CONFIG_PULSE_MODE_BURST             1
+#define CONFIG_PULSE_DEADTIME               1
+#define CONFIG_PULSE_MODE_REPLAY            1
+#define CONFIG_PULSE_LOG_RING_SIZE          256
+#define CONFIG_PULSE_TASK_STACK_SIZE        4096
+#define CONFIG_PULSE_TASK_PRIORITY          5
+#define CONFIG_PULSE_METER_MAX_POINTS       64
+#define CONFIG_PULSE_METER_SLICE_MS         100
+#define CONFIG_PULSE_RAMP                   1
+#define CONFIG_PULSE_WIDTH_TABLE_SIZE       256
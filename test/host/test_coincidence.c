@@ -0,0 +1,129 @@
+#include <math.h>
+#include <string.h>
+#include "host_test.h"
+#include "pulse_engine.h"
+
+#define RUN_US              200000000ull    // 200 s de prazos por saída
+#define MAX_EVENTS          300000
+
+static pulse_config_t out[2];
+static uint64_t due[2][MAX_EVENTS];
+static int due_count[2];
+
+static void config_random(pulse_config_t *c, int gpio, uint32_t interval_us) {
+    memset(c, 0, sizeof(*c));
+    c->gpio = gpio;
+    c->mode = MODE_RANDOM;
+    c->interval_us = interval_us;
+    pulse_config_init(c);
+}
+
+static void setup_pair(uint32_t interval_a, uint32_t interval_b, int permille, uint32_t seed) {
+    config_random(&out[0], 5, interval_a);
+    config_random(&out[1], 6, interval_b);
+    pulse_coincidence_setup(&out[0], &out[1], permille, seed);
+}
+
+// Prazos de cada saída até RUN_US, pela mesma sequência que as tasks usam
+static void run_pair(void) {
+    for (int i = 0; i < 2; i++) {
+        pulse_sequence_start(&out[i]);
+        uint64_t t;
+        uint32_t width;
+        due_count[i] = 0;
+        while (due_count[i] < MAX_EVENTS && pulse_sequence_next(&out[i], &t, &width) && t < RUN_US) {
+            due[i][due_count[i]++] = t;
+        }
+        CHECK(due_count[i] < MAX_EVENTS, "saída %d passou de %d prazos", i, MAX_EVENTS);
+    }
+}
+
+static bool contains(const uint64_t *list, int n, uint64_t t) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (list[mid] < t) lo = mid + 1; else hi = mid;
+    }
+    return lo < n && list[lo] == t;
+}
+
+// Prazos presentes nas duas saídas
+static int coincidences(void) {
+    int n = 0;
+    for (int i = 0, j = 0; i < due_count[0] && j < due_count[1];) {
+        if (due[0][i] < due[1][j]) i++;
+        else if (due[0][i] > due[1][j]) j++;
+        else { n++; i++; j++; }
+    }
+    return n;
+}
+
+// Taxas de 1000/s e 400/s com p = 30 % da mais lenta: 120 coincidências/s.
+// Cada evento do fluxo comum tem de sair nas duas saídas no mesmo µs.
+static void test_fraction(uint32_t interval_a, uint32_t interval_b, int permille) {
+    setup_pair(interval_a, interval_b, permille, 12345);
+    CHECK(out[0].common.mean_us == out[1].common.mean_us && out[0].common.rng == out[1].common.rng,
+          "fluxos comuns diferentes: %u/%u us", out[0].common.mean_us, out[1].common.mean_us);
+    random_stream_t common = out[0].common;
+    run_pair();
+
+    int shared = 0, lost = 0;
+    random_stream_start(&common);
+    for (uint64_t t = common.next_us; t < RUN_US; t = common.next_us) {
+        common.next_us += random_exp_us(&common.rng, common.mean_us);
+        shared++;
+        if (!contains(due[0], due_count[0], t) || !contains(due[1], due_count[1], t)) {
+            lost++;
+        }
+    }
+    CHECK(lost == 0, "%d de %d eventos comuns fora de uma das saídas", lost, shared);
+
+    double seconds = RUN_US / 1e6;
+    uint32_t slow_us = (interval_a > interval_b) ? interval_a : interval_b;
+    double want = permille / 1000.0 * 1e6 / slow_us;
+    int both = coincidences();
+    printf("%u/%u us, %d ‰: %.1f coincidências/s (%d do fluxo comum), esperado %.1f\n",
+           interval_a, interval_b, permille, both / seconds, shared, want);
+    // Contagem de Poisson: tolerância de 4 σ
+    CHECK_REL(shared / seconds, want, 4.0 / sqrt(want * seconds), "taxa de coincidências");
+    // Os fluxos próprios só coincidem por acaso, r1 r2 × 1 µs por segundo
+    double chance = seconds * 1e-6 * (1e6 / interval_a - want) * (1e6 / interval_b - want);
+    CHECK(both >= shared && both - shared <= 2 * chance + 20,
+          "%d coincidências para %d eventos comuns (%.0f por acaso)", both, shared, chance);
+    CHECK_REL(due_count[0] / seconds, 1e6 / interval_a, 0.02, "taxa da saída 1");
+    CHECK_REL(due_count[1] / seconds, 1e6 / interval_b, 0.02, "taxa da saída 2");
+}
+
+// A mesma semente repete as duas sequências inteiras; outra semente não
+static void test_reproducible(void) {
+    static uint64_t first[2][MAX_EVENTS];
+    int first_count[2];
+
+    setup_pair(1000, 2500, 300, 777);
+    run_pair();
+    memcpy(first, due, sizeof(first));
+    memcpy(first_count, due_count, sizeof(first_count));
+
+    setup_pair(1000, 2500, 300, 777);
+    run_pair();
+    for (int i = 0; i < 2; i++) {
+        CHECK(due_count[i] == first_count[i] &&
+              memcmp(due[i], first[i], sizeof(uint64_t) * due_count[i]) == 0,
+              "saída %d mudou com a mesma semente", i);
+    }
+
+    setup_pair(1000, 2500, 300, 778);
+    run_pair();
+    CHECK(due_count[0] != first_count[0] || memcmp(due[0], first[0], sizeof(uint64_t) * 16) != 0,
+          "semente diferente repetiu a sequência");
+}
+
+int main(void) {
+    test_fraction(1000, 2500, 300);
+    test_fraction(2500, 1000, 300);
+    // Todos os eventos da mais lenta são comuns: ela não tem fluxo próprio
+    test_fraction(1000, 2000, 1000);
+    test_fraction(1000, 1000, 50);
+    test_reproducible();
+    return HOST_TEST_RESULT();
+}
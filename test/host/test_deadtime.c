@@ -0,0 +1,125 @@
+#include <math.h>
+#include <string.h>
+#include "host_test.h"
+#include "pulse_engine.h"
+
+#define RUN_US              100000000ull    // 100 s de prazos por saída
+#define MAX_EVENTS          200000
+
+static pulse_config_t out[2];
+static uint64_t due[2][MAX_EVENTS];
+static int due_count[2];
+
+static void config_random(pulse_config_t *c, int gpio, uint32_t interval_us,
+                          deadtime_model_t model, uint32_t tau_us) {
+    memset(c, 0, sizeof(*c));
+    c->gpio = gpio;
+    c->mode = MODE_RANDOM;
+    c->interval_us = interval_us;
+    pulse_config_init(c);
+    c->dead.model = model;
+    c->dead.tau_us = tau_us;
+}
+
+// Prazos observados da saída até RUN_US, pela mesma sequência que as tasks usam
+static void run(int i) {
+    uint64_t t;
+    uint32_t width;
+    pulse_sequence_start(&out[i]);
+    due_count[i] = 0;
+    while (due_count[i] < MAX_EVENTS && pulse_sequence_next(&out[i], &t, &width) && t < RUN_US) {
+        due[i][due_count[i]++] = t;
+    }
+}
+
+// A taxa observada é a pedida e nenhum pulso sai dentro do tempo morto do anterior
+static void check_output(int i) {
+    double rate = due_count[i] / (RUN_US / 1e6);
+    CHECK_REL(rate, 1e6 / out[i].interval_us, 0.02, "taxa observada");
+    int close = 0;
+    for (int k = 1; k < due_count[i]; k++) {
+        if (due[i][k] - due[i][k - 1] < out[i].dead.tau_us) close++;
+    }
+    CHECK(close == 0, "saída %d: %d pulsos dentro do tempo morto", i, close);
+}
+
+static void test_single(uint32_t interval_us, deadtime_model_t model, uint32_t tau_us) {
+    double n;
+    config_random(&out[0], 5, interval_us, model, tau_us);
+    CHECK(pulse_deadtime_apply(&out[0], &n), "%u us com tau %u us recusado", interval_us, tau_us);
+    run(0);
+    printf("modelo %d, tau %u us: verdadeira %.1f/s, observada %.1f/s, pedida %.1f/s\n", model,
+           tau_us, n, due_count[0] / (RUN_US / 1e6), 1e6 / interval_us);
+    CHECK_REL(1e6 / out[0].indep.mean_us, n, 0.001, "taxa verdadeira do fluxo");
+    check_output(0);
+}
+
+// Duas saídas com taxas e tempos mortos diferentes: o fluxo comum segue o
+// mesmo nas duas, e um evento comum só falta numa saída se caiu no tempo
+// morto dela (não paralisável: menos de tau depois do último pulso)
+static void test_pair(uint32_t interval_a, uint32_t tau_a, uint32_t interval_b, uint32_t tau_b,
+                      deadtime_model_t model) {
+    config_random(&out[0], 5, interval_a, model, tau_a);
+    config_random(&out[1], 6, interval_b, model, tau_b);
+    pulse_coincidence_setup(&out[0], &out[1], 300, 99);
+    random_stream_t common = out[0].common;
+    for (int i = 0; i < 2; i++) {
+        double n;
+        CHECK(pulse_deadtime_apply(&out[i], &n), "saída %d recusada", i);
+        run(i);
+        check_output(i);
+    }
+    CHECK(out[0].common.mean_us == out[1].common.mean_us && out[0].common.rng == out[1].common.rng &&
+          out[0].common.mean_us == common.mean_us,
+          "fluxos comuns diferentes: %u/%u us (era %u)", out[0].common.mean_us,
+          out[1].common.mean_us, common.mean_us);
+
+    int shared = 0, both = 0, masked = 0, lost = 0;
+    int k[2] = {0, 0};
+    random_stream_start(&common);
+    for (uint64_t t = common.next_us; t < RUN_US; t = common.next_us) {
+        common.next_us += random_exp_us(&common.rng, common.mean_us);
+        shared++;
+        int present = 0;
+        for (int i = 0; i < 2; i++) {
+            while (k[i] < due_count[i] && due[i][k[i]] < t) k[i]++;
+            if (k[i] < due_count[i] && due[i][k[i]] == t) {
+                present++;
+            } else if (k[i] > 0 && t - due[i][k[i] - 1] < out[i].dead.tau_us) {
+                masked++;
+            } else if (model == DEADTIME_NONPARALYZABLE) {
+                lost++;
+            }
+        }
+        both += (present == 2);
+    }
+    printf("%u/%u us, tau %u/%u us: %d eventos comuns, %d nas duas saídas, %d no tempo morto\n",
+           interval_a, interval_b, tau_a, tau_b, shared, both, masked);
+    CHECK(lost == 0, "%d eventos comuns fora de uma saída sem tempo morto", lost);
+    // Cada saída perde a fração 1 - m/n dos eventos verdadeiros
+    double keep = 1.0;
+    for (int i = 0; i < 2; i++) {
+        keep *= (1e6 / out[i].interval_us) / (1e6 / out[i].indep.mean_us + 1e6 / common.mean_us);
+    }
+    CHECK(both >= 0.8 * keep * shared, "%d coincidências de %d eventos comuns (%.0f%% esperado)",
+          both, shared, 100.0 * keep);
+}
+
+int main(void) {
+    test_single(1000, DEADTIME_NONPARALYZABLE, 200);
+    test_single(1000, DEADTIME_NONPARALYZABLE, 800);
+    test_single(1000, DEADTIME_PARALYZABLE, 200);
+    test_single(1000, DEADTIME_PARALYZABLE, 350);
+
+    test_pair(1000, 100, 2500, 400, DEADTIME_NONPARALYZABLE);
+    test_pair(2000, 500, 700, 50, DEADTIME_NONPARALYZABLE);
+    test_pair(1000, 100, 2500, 400, DEADTIME_PARALYZABLE);
+
+    // Inatingível: pedir acima de 1/tau (não paralisável) ou de 1/(e tau)
+    double n;
+    config_random(&out[0], 5, 1000, DEADTIME_NONPARALYZABLE, 1000);
+    CHECK(!pulse_deadtime_apply(&out[0], &n), "1000/s com tau de 1 ms aceito");
+    config_random(&out[0], 5, 1000, DEADTIME_PARALYZABLE, 400);
+    CHECK(!pulse_deadtime_apply(&out[0], &n), "1000/s com tau de 400 us paralisável aceito");
+    return HOST_TEST_RESULT();
+}
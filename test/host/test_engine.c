@@ -0,0 +1,340 @@
+#include <stdlib.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "host_rtos.h"
+#include "host_test.h"
+#include "pulse_engine.h"
+
+#define GPIO_OUT            5
+#define TICK_WRAP_US        (4294967296ull * 1000)  // 2^32 ms: tick * ms de 32 bits volta a 0
+
+static void config_defined(pulse_config_t *c, uint32_t interval_us, uint64_t max_pulses) {
+    memset(c, 0, sizeof(*c));
+    c->gpio = GPIO_OUT;
+    c->mode = MODE_DEFINED;
+    c->interval_us = interval_us;
+    c->pulse_duration_ms = 1;
+    c->max_pulses = max_pulses;
+    c->deadline.tolerance_us = 1000;
+    c->deadline.policy = DEADLINE_FIRE_LATE;
+    pulse_config_init(c);
+}
+
+// Adianta contagem e prazo até pouco antes de 'wrap' e confere que os dois
+// passam dele sem voltar e que o limite de 64 bits para no pulso certo
+static void sequence_across(uint64_t count_wrap, uint64_t time_wrap) {
+    pulse_config_t c;
+    config_defined(&c, 3000, count_wrap + 2);
+    pulse_sequence_start(&c);
+    c.pulse_count = count_wrap - 2;
+    c.next_due_us = time_wrap - 4500;
+
+    uint64_t due;
+    uint32_t width;
+    for (int i = 0; i < 4; i++) {
+        CHECK(pulse_sequence_next(&c, &due, &width), "fim antes do limite em %d", i);
+        CHECK(due == time_wrap - 4500 + 3000ull * i, "prazo %llu no pulso %d",
+              (unsigned long long)due, i);
+        CHECK(c.pulse_count == count_wrap - 1 + i, "contagem %llu no pulso %d",
+              (unsigned long long)c.pulse_count, i);
+    }
+    CHECK(!pulse_sequence_next(&c, &due, &width), "pulso além do limite");
+}
+
+// Execução pela task com o relógio do boot passando de 2^32 ms e o de
+// execução passando de 2^32 µs
+static void task_across(void) {
+    const uint32_t interval_us = 1500000000u;  // 25 min; o 4º pulso sai em 75 min
+    pulse_config_t c;
+    config_defined(&c, interval_us, 4);
+    host_clock_us = (int64_t)TICK_WRAP_US - 2000000;
+    uint64_t falls = host_gpio_falls(GPIO_OUT);
+
+    pulse_engine_start(&c, 1);
+    host_rtos_run();
+
+    log_record_t rec[5];
+    int n = 0;
+    while (n < 5 && pulse_engine_log_pop(&rec[n])) {
+        n++;
+    }
+    CHECK(n == 4, "%d registros no log", n);
+    for (int i = 0; i < n; i++) {
+        uint64_t want = rec[0].at_us + (uint64_t)interval_us * i;
+        CHECK(!rec[i].missed && rec[i].count == (uint64_t)i + 1, "registro %d: pulso %llu%s", i,
+              (unsigned long long)rec[i].count, rec[i].missed ? " perdido" : "");
+        CHECK(llabs((long long)(rec[i].at_us - want)) <= 2, "pulso %d em %llu, esperado %llu",
+              i, (unsigned long long)rec[i].at_us, (unsigned long long)want);
+    }
+    CHECK(rec[0].at_us < TICK_WRAP_US && rec[n - 1].at_us > TICK_WRAP_US,
+          "a execução não cruzou 2^32 ms");
+
+    pulse_engine_status_t st;
+    pulse_engine_snapshot(&st);
+    CHECK(st.run_time_us > 4294967296ull, "tempo de execução %llu us",
+          (unsigned long long)st.run_time_us);
+    CHECK(st.channels[0].pulse_count == 4 && st.channels[0].stats.missed == 0,
+          "%llu pulsos, %llu perdidos", (unsigned long long)st.channels[0].pulse_count,
+          (unsigned long long)st.channels[0].stats.missed);
+    CHECK(st.channels[0].state == STATE_STOPPED, "saída não parou");
+    // Os 4 pulsos e as 3 piscadas do fim
+    CHECK(host_gpio_falls(GPIO_OUT) - falls == 4 + 3, "%llu descidas no pino",
+          (unsigned long long)(host_gpio_falls(GPIO_OUT) - falls));
+    pulse_engine_stop();
+}
+
+// Mudanças preparadas e confirmadas no meio da execução por uma task de
+// "console" que roda intercalada com as de pulso, em instantes sorteados:
+// qualquer ponto, no meio do pulso, logo depois dele ou poucos µs antes do
+// próximo prazo. A largura mais a folga tem de caber no intervalo, e cada
+// pulso sai inteiro com a largura e o intervalo de antes ou de depois de
+// uma troca.
+#define STAGE_PULSES        400
+#define STAGE_GAP_US        1500
+#define STAGE_TOL_US        12       // atraso das tasks intercaladas, que leem o relógio em turnos
+
+// Valores sorteados de conjuntos espaçados: um pulso cortado ou emendado
+// quase nunca cai perto de um deles
+static const uint32_t stage_intervals[] = { 1500, 2600, 4100, 6300, 8700, 12000 };
+static const uint32_t stage_widths[] = { 200, 650, 1350, 2900, 4700 };
+#define COUNT(a)            (sizeof(a) / sizeof((a)[0]))
+#define MAX_VALUES          16
+
+typedef struct {
+    int gpio;
+    int falls;
+    int64_t fall_us[STAGE_PULSES];
+    int64_t rise_us[STAGE_PULSES];
+} edge_trace_t;
+
+static pulse_config_t stage_configs[2];
+static edge_trace_t traces[2];
+static int stage_outputs;
+static int64_t stage_start_us;
+static uint32_t stage_rng;
+// Larguras e intervalos que estiveram em vigor (aceitos por pulse_engine_stage)
+static uint32_t widths[MAX_VALUES], intervals[MAX_VALUES];
+static int width_count, interval_count;
+static int commits;
+
+static void stage_edges(int gpio, uint32_t level) {
+    for (int i = 0; i < stage_outputs; i++) {
+        edge_trace_t *tr = &traces[i];
+        if (gpio != tr->gpio || tr->falls >= STAGE_PULSES) {
+            continue;
+        }
+        if (level) {
+            if (tr->falls > 0) tr->rise_us[tr->falls - 1] = host_clock_us;
+        } else {
+            tr->fall_us[tr->falls++] = host_clock_us;
+        }
+    }
+}
+
+static bool stage_done(void) {
+    return traces[0].falls >= STAGE_PULSES;
+}
+
+// Ticks inteiros dormindo e o resto em espera ativa, como a task de pulso
+static void wait_until(int64_t at_us) {
+    int64_t ahead_us = at_us - host_clock_us;
+    if (ahead_us > 2000) {
+        vTaskDelay(pdMS_TO_TICKS(ahead_us / 1000 - 1));
+    }
+    while (!stage_done() && esp_timer_get_time() < at_us) {
+    }
+}
+
+static uint32_t draw(uint32_t from, uint32_t to) {
+    return from + rng_next(&stage_rng) % (to - from + 1);
+}
+
+// Instante sorteado perto do próximo pulso da saída 0
+static void wait_random_instant(void) {
+    pulse_config_t *c = &stage_configs[0];
+    int64_t due_us = stage_start_us + (int64_t)c->next_due_us;
+    switch (draw(0, 3)) {
+    case 0:
+        wait_until(host_clock_us + draw(0, 2 * c->interval_us));
+        break;
+    case 1: // no meio do pulso
+        wait_until(due_us + draw(0, c->width_us));
+        break;
+    case 2: // logo depois do fim do pulso; com duas saídas, antes do fim do da outra
+        wait_until(due_us + c->width_us + draw(0, 8));
+        break;
+    default: // até 8 µs antes do prazo
+        wait_until(due_us - draw(0, 8));
+        break;
+    }
+}
+
+static void remember(uint32_t *values, int *count, uint32_t v) {
+    for (int i = 0; i < *count; i++) {
+        if (values[i] == v) return;
+    }
+    if (*count < MAX_VALUES) values[(*count)++] = v;
+}
+
+static bool known(const uint32_t *values, int count, int64_t v) {
+    for (int i = 0; i < count; i++) {
+        if (llabs(v - (int64_t)values[i]) <= STAGE_TOL_US) return true;
+    }
+    return false;
+}
+
+// Prepara uma mudança sorteada e confere a recusa contra a regra de
+// pulse_engine_stage. A saída 2 tem pulsos 1 ms mais largos; com together as
+// duas recebem o mesmo intervalo (ou nenhuma) e trocam no mesmo prazo.
+static void stage_random(bool together) {
+    uint32_t interval_us = draw(0, 3) ? stage_intervals[draw(0, COUNT(stage_intervals) - 1)] : 0;
+    uint32_t width_us = draw(0, 3) ? stage_widths[draw(0, COUNT(stage_widths) - 1)] : 0;
+    pulse_change_t change[2];
+    bool fits[2];
+    int fitting = 0;
+
+    for (int i = 0; i < stage_outputs; i++) {
+        pulse_config_t *c = &stage_configs[i];
+        change[i] = (pulse_change_t){ .interval_us = interval_us,
+                                      .width_us = width_us ? width_us + 1000u * i : 0 };
+        uint32_t interval = interval_us ? interval_us : c->interval_us;
+        uint32_t width = change[i].width_us ? change[i].width_us : c->width_us;
+        fits[i] = width < interval && interval - width >= STAGE_GAP_US;
+        fitting += fits[i];
+    }
+    if (together && fitting == 1) {
+        return;
+    }
+
+    int staged = 0;
+    for (int i = 0; i < stage_outputs; i++) {
+        bool ok = pulse_engine_stage(i, &change[i]);
+        if (stage_done()) {
+            return;
+        }
+        CHECK(ok == fits[i], "saída %d: %u us com %u us de pulso %s", i,
+              interval_us ? interval_us : stage_configs[i].interval_us,
+              change[i].width_us ? change[i].width_us : stage_configs[i].width_us,
+              ok ? "aceito" : "recusado");
+        if (ok) {
+            remember(intervals, &interval_count, interval_us ? interval_us : stage_configs[i].interval_us);
+            remember(widths, &width_count, change[i].width_us ? change[i].width_us : stage_configs[i].width_us);
+            staged |= 1 << i;
+        }
+    }
+    if (staged) {
+        CHECK(pulse_engine_commit((uint32_t)staged, together) == __builtin_popcount(staged),
+              "mudança não armada");
+        commits++;
+    }
+}
+
+static void console_task(void *arg) {
+    bool together = arg != NULL;
+    // Recusas fixas na configuração inicial (10 ms com 1 ms de pulso)
+    wait_until(stage_start_us + 100);
+    pulse_change_t bad[] = { { .width_us = 9000 }, { .interval_us = 2400 }, { .width_us = 10000 } };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        CHECK(!pulse_engine_stage(0, &bad[i]), "mudança %zu aceita sem caber", i);
+    }
+    CHECK(!pulse_engine_stage(stage_outputs, &bad[0]), "saída inexistente aceita");
+
+    while (!stage_done()) {
+        // Preparar de novo substitui a mudança que ainda não entrou; com
+        // together a seguinte espera a anterior entrar nas duas saídas
+        while (together && !stage_done() &&
+               (stage_configs[0].staged_armed || stage_configs[1].staged_armed)) {
+            esp_timer_get_time();
+        }
+        wait_random_instant();
+        stage_random(together);
+    }
+}
+
+static void stage_run(int outputs, bool together, uint32_t seed) {
+    stage_outputs = outputs;
+    stage_rng = seed;
+    width_count = interval_count = commits = 0;
+    remember(intervals, &interval_count, 10000);
+    for (int i = 0; i < outputs; i++) {
+        config_defined(&stage_configs[i], 10000, STAGE_PULSES);
+        stage_configs[i].pulse_duration_ms = 1 + i;
+        remember(widths, &width_count, 1000u * (1 + i));
+        stage_configs[i].gpio = GPIO_OUT + i;
+        stage_configs[i].min_gap_us = STAGE_GAP_US;
+        memset(&traces[i], 0, sizeof(traces[i]));
+        traces[i].gpio = GPIO_OUT + i;
+    }
+
+    host_gpio_hook = stage_edges;
+    stage_start_us = host_clock_us;
+    pulse_engine_start(stage_configs, outputs);
+    xTaskCreate(console_task, "console", 4096, together ? &stage_outputs : NULL, 1, NULL);
+    host_rtos_run();
+    host_gpio_hook = NULL;
+    pulse_engine_stop();
+}
+
+// Nenhum pulso cortado nem emendado: toda largura e todo intervalo são
+// valores que estiveram em vigor, e a folga mínima vale em toda borda
+static void check_trace(const edge_trace_t *tr, int out) {
+    CHECK(tr->falls == STAGE_PULSES, "saída %d: %d pulsos", out, tr->falls);
+    int bad = 0;
+    int64_t min_width = INT64_MAX, min_gap = INT64_MAX;
+    for (int i = 0; i + 1 < tr->falls; i++) {
+        int64_t width = tr->rise_us[i] - tr->fall_us[i];
+        int64_t interval = tr->fall_us[i + 1] - tr->fall_us[i];
+        int64_t gap = tr->fall_us[i + 1] - tr->rise_us[i];
+        if (width < min_width) min_width = width;
+        if (gap < min_gap) min_gap = gap;
+        if (!known(widths, width_count, width) || !known(intervals, interval_count, interval) ||
+            gap < STAGE_GAP_US - STAGE_TOL_US) {
+            if (bad++ < 5) {
+                printf("saída %d, pulso %d: largura %lld, intervalo %lld, folga %lld us\n", out, i,
+                       (long long)width, (long long)interval, (long long)gap);
+            }
+        }
+    }
+    CHECK(bad == 0, "saída %d: %d pulsos cortados ou emendados", out, bad);
+    CHECK(min_width >= 200 - STAGE_TOL_US, "saída %d: pulso de %lld us", out, (long long)min_width);
+    printf("saída %d: %d pulsos, %d confirmações, largura mínima %lld us, folga mínima %lld us\n",
+           out, tr->falls, commits, (long long)min_width, (long long)min_gap);
+}
+
+static void stage_without_runts(void) {
+    for (uint32_t seed = 1; seed <= 3; seed++) {
+        stage_run(1, false, seed_derive(seed, 70));
+        check_trace(&traces[0], 0);
+        CHECK(commits > 50, "%d confirmações", commits);
+    }
+}
+
+// Confirmação conjunta: as duas saídas começam na mesma fase e recebem os
+// mesmos intervalos, então só seguem descendo juntas se cada mudança entra
+// no mesmo prazo nas duas, mesmo confirmada entre o fim do pulso de uma e o
+// da outra (quando uma já calculou o próximo prazo e a outra não)
+static void stage_together(void) {
+    for (uint32_t seed = 1; seed <= 3; seed++) {
+        stage_run(2, true, seed_derive(seed, 71));
+        check_trace(&traces[0], 0);
+        check_trace(&traces[1], 1);
+        int apart = 0;
+        for (int i = 0; i < traces[0].falls && i < traces[1].falls; i++) {
+            if (llabs(traces[0].fall_us[i] - traces[1].fall_us[i]) > STAGE_TOL_US && apart++ < 5) {
+                printf("pulso %d: saídas em %lld e %lld us\n", i, (long long)traces[0].fall_us[i],
+                       (long long)traces[1].fall_us[i]);
+            }
+        }
+        CHECK(apart == 0, "%d pulsos em que as saídas trocaram em prazos diferentes", apart);
+    }
+}
+
+int main(void) {
+    sequence_across(1ull << 31, 1ull << 31);
+    sequence_across(1ull << 32, 1ull << 32);
+    sequence_across(1ull << 32, TICK_WRAP_US);
+    task_across();
+    stage_without_runts();
+    stage_together();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,110 @@
+#include <math.h>
+#include <stdint.h>
+#include "host_test.h"
+#include "pulse_meter.h"
+
+#define IMP_PER_KWH 100000u
+
+// Sobe de 0 a 3 kW em 10 s, fica 10 s e desce a 500 W em 10 s: 62,5 kJ,
+// 1736,1 pulsos a 100000 imp/kWh. As inclinações dão mW inteiros nas pontas
+// das fatias, então a energia das fatias é exata.
+static const meter_point_t profile[] = {
+    { 0, 0 }, { 10000, 3000000 }, { 20000, 3000000 }, { 30000, 500000 },
+};
+#define POINTS      (sizeof(profile) / sizeof(profile[0]))
+#define PASS_US     30000000ull
+
+static meter_t m;
+
+// Energia exata até t, em pulsos
+static double reference_pulses(uint64_t t_us) {
+    uint64_t passes = t_us / PASS_US;
+    double t_ms = (t_us % PASS_US) / 1000.0;
+    double mw_ms = passes * 62500000000.0;
+    for (size_t i = 1; i < POINTS; i++) {
+        const meter_point_t *a = &profile[i - 1], *b = &profile[i];
+        if (t_ms <= a->t_ms) break;
+        double end = fmin(t_ms, b->t_ms);
+        double slope = ((double)b->power_mw - a->power_mw) / (b->t_ms - a->t_ms);
+        double p_end = a->power_mw + slope * (end - a->t_ms);
+        mw_ms += (a->power_mw + p_end) / 2 * (end - a->t_ms);
+    }
+    return mw_ms / 3.6e12 * IMP_PER_KWH;
+}
+
+static void setup(bool repeat) {
+    for (size_t i = 0; i < POINTS; i++) {
+        m.points[i] = profile[i];
+    }
+    CHECK(meter_setup(&m, POINTS, IMP_PER_KWH, repeat), "perfil recusado");
+    meter_start(&m);
+}
+
+// Cada pulso no instante em que a energia integrada passa de k pulsos (a
+// menos da fatia com potência média), e o total exato
+static void test_single_pass(void) {
+    setup(false);
+    CHECK(meter_peak_rate(&m) == 84, "pico de %u pulsos/s", meter_peak_rate(&m));
+    CHECK_REL(meter_energy_wh(&m), 62500.0 / 3600.0, 1e-9, "energia da passada");
+
+    uint64_t t, prev = 0;
+    uint32_t count = 0;
+    double worst = 0;
+    while ((t = meter_next_us(&m)) != UINT64_MAX) {
+        count++;
+        worst = fmax(worst, fabs(reference_pulses(t) - count));
+        // Patamar de 3 kW: 83,3 pulsos/s
+        if (t > 10100000 && t < 20000000 && prev > 10000000) {
+            CHECK(t - prev >= 11999 && t - prev <= 12001, "intervalo de %llu us no patamar",
+                  (unsigned long long)(t - prev));
+        }
+        CHECK(t > prev, "pulso %u em %llu us", count, (unsigned long long)t);
+        prev = t;
+    }
+    printf("passada única: %u pulsos, último em %.6f s, desvio de até %.4f pulso\n", count,
+           prev / 1e6, worst);
+    CHECK(count == 1736, "%u pulsos, esperado 1736", count);
+    CHECK(worst < 0.02, "desvio de %.4f pulso da energia integrada", worst);
+}
+
+// Com repetição o resto de energia passa de uma passada à outra
+static void test_repeat(void) {
+    setup(true);
+    uint64_t t;
+    uint32_t count = 0;
+    while ((t = meter_next_us(&m)) <= 10 * PASS_US) {
+        count++;
+    }
+    printf("10 passadas: %u pulsos\n", count);
+    CHECK(count == 17361, "%u pulsos em 10 passadas, esperado 17361", count);
+}
+
+static void test_reject(void) {
+    for (size_t i = 0; i < POINTS; i++) {
+        m.points[i] = profile[i];
+    }
+    CHECK(!meter_setup(&m, 1, IMP_PER_KWH, false), "um ponto aceito");
+    CHECK(!meter_setup(&m, POINTS, 0, false), "N = 0 aceito");
+    m.points[2].t_ms = m.points[1].t_ms;
+    CHECK(!meter_setup(&m, POINTS, IMP_PER_KWH, false), "tempos repetidos aceitos");
+    m.points[2].t_ms = 20000;
+    m.points[0].t_ms = 1;
+    CHECK(!meter_setup(&m, POINTS, IMP_PER_KWH, false), "perfil fora de t = 0 aceito");
+    m.points[0].t_ms = 0;
+    m.points[1].power_mw = METER_MAX_POWER_MW + 1;
+    CHECK(!meter_setup(&m, POINTS, IMP_PER_KWH, false), "potência acima do limite aceita");
+    // 1e6 pulsos/s: 1 GW a 3,6e6 imp/kWh
+    m.points[1].power_mw = METER_MAX_POWER_MW;
+    CHECK(!meter_setup(&m, POINTS, 3600000, false), "1e6 pulsos/s aceito");
+    for (size_t i = 0; i < POINTS; i++) {
+        m.points[i].power_mw = 0;
+    }
+    CHECK(!meter_setup(&m, POINTS, IMP_PER_KWH, true), "perfil repetido sem energia aceito");
+}
+
+int main(void) {
+    test_single_pass();
+    test_repeat();
+    test_reject();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,147 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "host_test.h"
+#include "pulse_motion.h"
+
+// Referência em ponto flutuante: posição contínua p(t) do perfil e o passo
+// k no instante em que p(t) = k
+typedef struct {
+    motion_profile_t profile;
+    double v, a, length;
+    double t_ramp, d_ramp, t_total;
+} reference_t;
+
+static void reference_plan(reference_t *r, motion_profile_t profile, uint32_t steps,
+                           uint32_t v_max, uint32_t accel) {
+    double k = (profile == MOTION_TRAPEZOID) ? 0.5 : 0.75;
+    r->profile = profile;
+    r->a = accel;
+    r->length = steps - 1;
+    r->v = v_max;
+    if (k * r->v * r->v / r->a > r->length / 2) {
+        r->v = sqrt(r->length / 2 * r->a / k);
+    }
+    r->t_ramp = (profile == MOTION_TRAPEZOID) ? r->v / r->a : 1.5 * r->v / r->a;
+    r->d_ramp = k * r->v * r->v / r->a;
+    r->t_total = 2 * r->t_ramp + (r->length - 2 * r->d_ramp) / r->v;
+}
+
+// Distância percorrida em t dentro de uma rampa que parte do repouso
+static double ramp_position(const reference_t *r, double t) {
+    if (r->profile == MOTION_TRAPEZOID) {
+        return r->a * t * t / 2;
+    }
+    double u = t / r->t_ramp;
+    return r->v * r->t_ramp * (u * u * u - u * u * u * u / 2);
+}
+
+static double reference_position(const reference_t *r, double t) {
+    if (t <= 0) return 0;
+    if (t >= r->t_total) return r->length;
+    if (t < r->t_ramp) return ramp_position(r, t);
+    if (t < r->t_total - r->t_ramp) return r->d_ramp + r->v * (t - r->t_ramp);
+    return r->length - ramp_position(r, r->t_total - t);
+}
+
+static double reference_step_us(const reference_t *r, uint32_t k) {
+    double lo = 0, hi = r->t_total;
+    for (int i = 0; i < 100; i++) {
+        double mid = (lo + hi) / 2;
+        if (reference_position(r, mid) < k) lo = mid; else hi = mid;
+    }
+    return (lo + hi) / 2 * 1e6;
+}
+
+// Passos crescentes, um por posição, com cada intervalo perto do exato
+// (erro relativo 'tol') e o instante acumulado a até 1% do exato
+static void check_profile(motion_t *m, motion_profile_t profile, uint32_t steps,
+                          uint32_t v_max, uint32_t accel, double tol) {
+    const char *name = (profile == MOTION_TRAPEZOID) ? "trapézio" : "curva S";
+    reference_t r;
+    reference_plan(&r, profile, steps, v_max, accel);
+    CHECK(motion_plan(m, profile, steps, v_max, accel), "%s %u/%u/%u recusado", name,
+          steps, v_max, accel);
+    motion_start(m);
+
+    uint64_t prev = 0;
+    double prev_ref = 0, worst = 0, drift = 0;
+    uint32_t k = 0, worst_k = 0;
+    uint64_t t;
+    while ((t = motion_next_us(m)) != UINT64_MAX) {
+        double ref = reference_step_us(&r, k);
+        if (k == 0) {
+            CHECK(t == 0, "%s: primeiro passo em %llu us", name, (unsigned long long)t);
+        } else {
+            CHECK(t > prev, "%s %u/%u/%u: passo %u em %llu us, antes do anterior (%llu)", name,
+                  steps, v_max, accel, k, (unsigned long long)t, (unsigned long long)prev);
+            // 1 µs de folga pelo arredondamento dos instantes
+            double err = (fabs((double)(t - prev) - (ref - prev_ref)) - 1) / (ref - prev_ref);
+            if (err > worst) {
+                worst = err;
+                worst_k = k;
+            }
+            drift = fmax(drift, fabs((double)t - ref) / ref);
+        }
+        prev = t;
+        prev_ref = ref;
+        k++;
+    }
+    printf("%s %u passos, %u/s, %u/s²: rampa de %u passos, intervalo com erro de até %.4f "
+           "(passo %u), instante %.4f\n", name, steps, v_max, accel, m->ramp_steps, worst,
+           worst_k, drift);
+    CHECK(k == steps, "%s: %u passos de %u", name, k, steps);
+    CHECK(worst <= tol, "%s %u/%u/%u: intervalo com erro de %.4f no passo %u", name, steps,
+          v_max, accel, worst, worst_k);
+    CHECK(drift <= 0.01, "%s %u/%u/%u: instante com erro de %.4f", name, steps, v_max, accel,
+          drift);
+}
+
+// Instantes exatos em µs de um trapézio curto
+static void check_times(motion_t *m, uint32_t v_max, uint32_t accel, const uint64_t *want,
+                        uint32_t steps) {
+    CHECK(motion_plan(m, MOTION_TRAPEZOID, steps, v_max, accel), "plano recusado");
+    motion_start(m);
+    for (uint32_t k = 0; k < steps; k++) {
+        uint64_t t = motion_next_us(m);
+        CHECK(t + 1 >= want[k] && t <= want[k] + 1, "v %u, a %u: passo %u em %llu us, esperado %llu",
+              v_max, accel, k, (unsigned long long)t, (unsigned long long)want[k]);
+    }
+    CHECK(motion_next_us(m) == UINT64_MAX, "passo além do último");
+}
+
+int main(void) {
+    motion_t m;
+
+    // Rampa de 0 passos: v/2a = 25 ms de atraso na partida e na parada
+    memset(&m, 0xA5, sizeof(m));
+    static const uint64_t ramp0[] = { 0, 125000, 225000, 325000, 425000, 525000, 625000,
+                                      725000, 825000, 950000 };
+    check_times(&m, 10, 200, ramp0, 10);
+    // Rampa de 1 passo: o primeiro em c_0 = 200 ms, o último 200 ms depois do penúltimo
+    memset(&m, 0xA5, sizeof(m));
+    static const uint64_t ramp1[] = { 0, 200000, 300000, 400000, 500000, 600000, 700000,
+                                      800000, 900000, 1100000 };
+    check_times(&m, 10, 50, ramp1, 10);
+
+    // Trapézio contra a cinemática exata: a aproximação do AVR446 erra uns
+    // 2% nos primeiros intervalos da rampa
+    static const uint32_t cases[][3] = {
+        {10, 10, 200}, {10, 10, 50}, {2, 10, 50}, {3, 1000, 100}, {50, 100, 10},
+        {500, 5000, 20000}, {2000, 1000, 500}, {20000, 40000, 200000},
+        {200000, 30000, 100000},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        check_profile(&m, MOTION_TRAPEZOID, cases[i][0], cases[i][1], cases[i][2], 0.03);
+    }
+    for (size_t i = 3; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        check_profile(&m, MOTION_SCURVE, cases[i][0], cases[i][1], cases[i][2], 0.005);
+    }
+
+    // Trapézio no mesmo motion_t depois de uma curva S e de um trapézio longo
+    check_profile(&m, MOTION_SCURVE, 2000, 1000, 500, 0.005);
+    check_times(&m, 10, 200, ramp0, 10);
+    check_profile(&m, MOTION_TRAPEZOID, 2000, 1000, 500, 0.03);
+    check_times(&m, 10, 50, ramp1, 10);
+    return HOST_TEST_RESULT();
+}
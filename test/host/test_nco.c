@@ -0,0 +1,89 @@
+#include <stdint.h>
+#include "host_test.h"
+#include "pulse_nco.h"
+
+typedef unsigned __int128 u128;
+
+// Pulsos em [0, t]: o de t = 0 mais um por estouro da fase
+static uint64_t expected_count(uint64_t word, uint64_t t_us) {
+    return (uint64_t)(((u128)word * t_us) >> 64) + 1;
+}
+
+// O pulso k cai no primeiro µs em que k × 2^64 <= word × t, e a contagem
+// em duration_us fica a menos de um pulso de f × t
+static void test_rate(uint32_t mhz, uint64_t duration_us) {
+    nco_tuning_t tune;
+    nco_t n;
+    nco_tuning(&tune, mhz);
+    nco_start(&n, &tune);
+
+    uint64_t count = 1, t;
+    while ((t = nco_next_us(&n)) <= duration_us) {
+        u128 target = (u128)count << 64;
+        uint64_t want = (uint64_t)((target + tune.word - 1) / tune.word);
+        if (t != want) {
+            CHECK(false, "%u mHz: pulso %llu em %llu us, esperado %llu", mhz,
+                  (unsigned long long)count, (unsigned long long)t, (unsigned long long)want);
+            return;
+        }
+        count++;
+    }
+    double ideal = (double)mhz * 1e-3 * duration_us * 1e-6;
+    printf("%u mHz por %.0f s: %llu pulsos (f·t = %.3f)\n", mhz, duration_us / 1e6,
+           (unsigned long long)count, ideal);
+    CHECK(count == expected_count(tune.word, duration_us), "%u mHz: %llu pulsos", mhz,
+          (unsigned long long)count);
+    CHECK(count >= ideal && count <= ideal + 1.0 + 1e-6, "%u mHz: %llu pulsos, f·t = %.3f",
+          mhz, (unsigned long long)count, ideal);
+}
+
+// Trocas de frequência contra a fase somada µs a µs: cada troca vale a
+// partir do último pulso, sem salto de fase
+static void test_retune(void) {
+    static const uint32_t mhz[] = { 1000000, 33333333, 7777777, 250000000, 1234567, 99999999 };
+    nco_tuning_t tune[6];
+    for (int i = 0; i < 6; i++) {
+        nco_tuning(&tune[i], mhz[i]);
+    }
+    nco_t n;
+    nco_start(&n, &tune[0]);
+
+    uint64_t phase = 0, word = tune[0].word, tick = 0;
+    int pulses = 0;
+    for (int change = 1; change <= 60; change++) {
+        for (int k = 0; k < 50; k++) {
+            uint64_t t = nco_next_us(&n);
+            // Soma até o estouro
+            uint64_t before;
+            do {
+                before = phase;
+                phase += word;
+                tick++;
+            } while (phase >= before);
+            if (t != tick) {
+                CHECK(false, "troca %d, pulso %d: %llu us, esperado %llu", change, k,
+                      (unsigned long long)t, (unsigned long long)tick);
+                return;
+            }
+            pulses++;
+        }
+        nco_retune(&n, &tune[change % 6]);
+        word = tune[change % 6].word;
+    }
+    printf("%d pulsos em 60 trocas, até %.3f s\n", pulses, tick / 1e6);
+}
+
+int main(void) {
+    test_rate(1234567, 100000000);
+    test_rate(100000000, 10000000);
+    test_rate(333333, 600000000);
+    test_rate(1, 4000000000ull);
+    test_rate(499999999, 10000000);
+    nco_tuning_t zero;
+    nco_t n;
+    nco_tuning(&zero, 0);
+    nco_start(&n, &zero);
+    CHECK(nco_next_us(&n) == UINT64_MAX, "pulso com frequência 0");
+    test_retune();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,105 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "pattern_lib.h"
+
+// Imagem de data/trace.ts e data/burst.seq montada por tools/patlib.py
+// (teste pattern_image); o caminho vem em PATTERN_IMAGE
+static uint8_t image[4096];
+
+typedef struct {
+    const char *name;
+    uint8_t kind;
+    uint32_t events;
+    uint64_t duration_us;
+    uint64_t delta_us[5];
+    uint32_t width_us[5];
+} expected_t;
+
+static const expected_t expected[] = {
+    { "trace", PATTERN_KIND_TRACE, 5, 4294971296ull,
+      { 0, 250, 0, 3750, 4294967296ull }, { 0 } },
+    { "burst", PATTERN_KIND_SEQUENCE, 3, 300,
+      { 0, 100, 200 }, { 10, 20, 150 } },
+};
+
+static void check_pattern(const pattern_lib_t *lib, const expected_t *want) {
+    const pattern_entry_t *e = pattern_lib_find(lib, want->name);
+    CHECK(e != NULL, "padrão %s não encontrado", want->name);
+    if (!e) return;
+    CHECK(e->kind == want->kind, "%s: tipo %u", want->name, e->kind);
+    CHECK(e->event_count == want->events, "%s: %u eventos", want->name, e->event_count);
+    CHECK(e->duration_us == want->duration_us, "%s: duração %llu us", want->name,
+          (unsigned long long)e->duration_us);
+
+    pattern_cursor_t cur;
+    pattern_cursor_init(&cur, lib, e);
+    uint64_t delta;
+    uint32_t width;
+    uint32_t n = 0;
+    while (pattern_cursor_next(&cur, &delta, &width)) {
+        if (n < want->events) {
+            CHECK(delta == want->delta_us[n] && width == want->width_us[n],
+                  "%s[%u]: (%llu, %u), esperado (%llu, %u)", want->name, n,
+                  (unsigned long long)delta, width,
+                  (unsigned long long)want->delta_us[n], want->width_us[n]);
+        }
+        n++;
+    }
+    CHECK(n == want->events, "%s: cursor deu %u eventos", want->name, n);
+}
+
+// Imagens estragadas não abrem
+static void check_rejects(size_t size) {
+    static uint8_t bad[sizeof(image)];
+    pattern_lib_t lib;
+    pattern_lib_header_t *hdr = (pattern_lib_header_t *)bad;
+    pattern_entry_t *entries = (pattern_entry_t *)(bad + sizeof(*hdr));
+
+    CHECK(!pattern_lib_open(&lib, image, size - 1), "imagem truncada abriu");
+    CHECK(!pattern_lib_open(&lib, image, sizeof(*hdr) - 1), "cabeçalho truncado abriu");
+
+    memcpy(bad, image, size);
+    hdr->magic = 0xFFFFFFFFu;
+    CHECK(!pattern_lib_open(&lib, bad, size), "marca apagada abriu");
+
+    memcpy(bad, image, size);
+    hdr->version++;
+    CHECK(!pattern_lib_open(&lib, bad, size), "outra versão abriu");
+
+    memcpy(bad, image, size);
+    entries[1].length += 1;
+    CHECK(!pattern_lib_open(&lib, bad, size), "padrão além da imagem abriu");
+
+    memcpy(bad, image, size);
+    entries[0].offset = sizeof(*hdr);
+    CHECK(!pattern_lib_open(&lib, bad, size), "padrão sobre o índice abriu");
+
+    memcpy(bad, image, size);
+    entries[0].kind = 0;
+    CHECK(!pattern_lib_open(&lib, bad, size), "tipo desconhecido abriu");
+}
+
+int main(void) {
+    const char *path = getenv("PATTERN_IMAGE");
+    FILE *f = path ? fopen(path, "rb") : NULL;
+    if (!f) {
+        printf("sem a imagem (PATTERN_IMAGE)\n");
+        return 1;
+    }
+    size_t size = fread(image, 1, sizeof(image), f);
+    fclose(f);
+
+    pattern_lib_t lib;
+    CHECK(pattern_lib_open(&lib, image, size), "imagem de %zu bytes não abriu", size);
+    CHECK(lib.count == 2, "%u padrões", lib.count);
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        check_pattern(&lib, &expected[i]);
+    }
+    CHECK(pattern_lib_find(&lib, "nada") == NULL, "achou um padrão inexistente");
+    CHECK(pattern_lib_entry(&lib, lib.count) == NULL, "entrada além do índice");
+
+    check_rejects(size);
+    return HOST_TEST_RESULT();
+}
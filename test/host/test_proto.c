@@ -0,0 +1,151 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "proto.h"
+
+// Pulsos como edge_log.py os lê dos quadros PROTO_EVT_EDGES
+typedef struct {
+    uint64_t t_us[2];
+    uint64_t seq[2];
+    uint64_t skipped;
+    int pulses;
+} edge_reader_t;
+
+static FILE *capture;
+static edge_reader_t reader;
+static proto_edge_writer_t writer;
+
+static uint64_t varint(const uint8_t *data, uint16_t *pos) {
+    uint64_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t byte = data[(*pos)++];
+        value |= (uint64_t)(byte & 0x7Fu) << shift;
+        if (!(byte & 0x80u)) return value;
+    }
+}
+
+// Confere cada pulso do quadro com o esperado (número e instante)
+static void read_frame(const uint8_t *payload, uint16_t len, uint64_t (*want_t)(int, uint64_t)) {
+    proto_edges_t head;
+    memcpy(&head, payload, sizeof(head));
+    memcpy(reader.t_us, head.t_us, sizeof(reader.t_us));
+    memcpy(reader.seq, head.seq, sizeof(reader.seq));
+    for (uint16_t pos = sizeof(head); pos < len;) {
+        uint64_t value = varint(payload, &pos);
+        int channel = value & 1u;
+        uint64_t skipped = (value & 2u) ? varint(payload, &pos) : 0;
+        reader.seq[channel] += 1 + skipped;
+        reader.t_us[channel] += value >> 2;
+        reader.skipped += skipped;
+        reader.pulses++;
+        uint64_t t = want_t(channel, reader.seq[channel]);
+        CHECK(reader.t_us[channel] == t, "saída %d, pulso %llu em %llu us, esperado %llu", channel,
+              (unsigned long long)reader.seq[channel], (unsigned long long)reader.t_us[channel],
+              (unsigned long long)t);
+    }
+}
+
+static void flush(uint64_t (*want_t)(int, uint64_t)) {
+    if (!writer.count) return;
+    read_frame(writer.payload, writer.len, want_t);
+    if (capture) {
+        uint8_t frame[PROTO_MAX_PAYLOAD + PROTO_OVERHEAD];
+        size_t n = proto_encode(frame, sizeof(frame), PROTO_EVT_EDGES, writer.payload, writer.len);
+        fwrite(frame, 1, n, capture);
+        // Texto do console entre os quadros, como na serial
+        fputs("I (123) PULSE_GEN: status\n", capture);
+    }
+    proto_edges_start(&writer);
+}
+
+// Mesmo caminho de edge_add() no console
+static void add(int channel, uint64_t seq, uint64_t t_us, uint64_t (*want_t)(int, uint64_t)) {
+    if (!proto_edges_add(&writer, (uint8_t)channel, seq, t_us)) {
+        flush(want_t);
+        CHECK(proto_edges_add(&writer, (uint8_t)channel, seq, t_us), "registro não coube");
+    }
+}
+
+// Saída 1 a 1 kHz, com variação, e saída 2 a 400 Hz, juntas perto de 5 s
+static uint64_t pulse_t(int channel, uint64_t seq) {
+    return channel ? 4250000ull + seq * 2500u : seq * 1000u + seq % 7;
+}
+
+// Exportação ligada no meio da execução: a contagem já passou de 1 nas duas
+// saídas e nenhum pulso conta como perdido
+static void test_join(void) {
+    memset(&reader, 0, sizeof(reader));
+    proto_edges_join(&writer);
+    uint64_t seq0 = 5000, seq1 = 301;
+    for (int i = 0; i < 700; i++) {
+        if (pulse_t(0, seq0) <= pulse_t(1, seq1)) {
+            add(0, seq0, pulse_t(0, seq0), pulse_t);
+            seq0++;
+        } else {
+            add(1, seq1, pulse_t(1, seq1), pulse_t);
+            seq1++;
+        }
+    }
+    flush(pulse_t);
+    printf("ligada no pulso 5000/301: %d pulsos, %llu sem registro\n", reader.pulses,
+           (unsigned long long)reader.skipped);
+    CHECK(reader.pulses == 700, "%d pulsos lidos", reader.pulses);
+    CHECK(reader.skipped == 0, "%llu pulsos sem registro", (unsigned long long)reader.skipped);
+    CHECK(reader.seq[0] == seq0 - 1 && reader.seq[1] == seq1 - 1, "últimos pulsos %llu/%llu",
+          (unsigned long long)reader.seq[0], (unsigned long long)reader.seq[1]);
+}
+
+// Uma saída só aparece depois de vários quadros da outra
+static void test_join_late_channel(void) {
+    memset(&reader, 0, sizeof(reader));
+    proto_edges_join(&writer);
+    for (uint64_t seq = 40; seq < 400; seq++) {
+        add(0, seq, pulse_t(0, seq), pulse_t);
+    }
+    for (uint64_t seq = 90000; seq < 90010; seq++) {
+        add(1, seq, pulse_t(1, seq), pulse_t);
+    }
+    flush(pulse_t);
+    CHECK(reader.pulses == 370 && reader.skipped == 0, "%d pulsos, %llu sem registro",
+          reader.pulses, (unsigned long long)reader.skipped);
+}
+
+// Registros descartados no anel continuam contados, também no começo da
+// execução (proto_edges_reset, contagem desde 0)
+static void test_real_gaps(void) {
+    memset(&reader, 0, sizeof(reader));
+    proto_edges_reset(&writer);
+    add(0, 3, pulse_t(0, 3), pulse_t);
+    add(0, 4, pulse_t(0, 4), pulse_t);
+    add(0, 10, pulse_t(0, 10), pulse_t);
+    add(1, 1, pulse_t(1, 1), pulse_t);
+    flush(pulse_t);
+    CHECK(reader.skipped == 2 + 5, "%llu pulsos sem registro, esperado 7",
+          (unsigned long long)reader.skipped);
+
+    memset(&reader, 0, sizeof(reader));
+    proto_edges_join(&writer);
+    add(1, 50, pulse_t(1, 50), pulse_t);
+    add(1, 53, pulse_t(1, 53), pulse_t);
+    flush(pulse_t);
+    CHECK(reader.skipped == 2, "%llu pulsos sem registro depois de ligar, esperado 2",
+          (unsigned long long)reader.skipped);
+}
+
+int main(void) {
+    // Captura bruta para o teste de tools/edge_log.py (só a exportação ligada
+    // no meio da execução, sem lacunas)
+    const char *path = getenv("EDGE_CAPTURE");
+    capture = path ? fopen(path, "wb") : NULL;
+    CHECK(!path || capture, "sem %s", path);
+    test_join();
+    test_join_late_channel();
+    if (capture) {
+        fclose(capture);
+        capture = NULL;
+    }
+    test_real_gaps();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,83 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "host_test.h"
+#include "pulse_quadrature.h"
+
+#define COUNTS      400
+#define V_MAX       2000
+#define ACCEL       20000
+#define DWELL_US    5000
+#define CYCLES      2
+#define PER_REV     100
+
+// Contagens e instantes de um trecho pelo perfil sozinho, para comparar
+static uint64_t segment_times[COUNTS];
+
+static void expected_segment(motion_profile_t profile) {
+    motion_t m;
+    motion_plan(&m, profile, COUNTS + 1, V_MAX, ACCEL);
+    motion_start(&m);
+    motion_next_us(&m);
+    for (int i = 0; i < COUNTS; i++) {
+        segment_times[i] = motion_next_us(&m);
+    }
+}
+
+int main(void) {
+    quadrature_t q = { 0 };
+    CHECK(quad_segment_set(&q, 0, MOTION_TRAPEZOID, COUNTS, V_MAX, ACCEL, false), "trecho 0");
+    CHECK(quad_segment_set(&q, 1, MOTION_SCURVE, COUNTS, V_MAX, ACCEL, true), "trecho 1");
+    CHECK(!quad_segment_set(&q, QUAD_MAX_SEGMENTS, MOTION_TRAPEZOID, COUNTS, V_MAX, ACCEL, false),
+          "trecho além do último aceito");
+    CHECK(!quad_segment_set(&q, 2, MOTION_TRAPEZOID, 0, V_MAX, ACCEL, false),
+          "trecho sem contagens aceito");
+    CHECK(q.count == 2, "%u trechos", q.count);
+    CHECK(quad_peak_rate(&q) == V_MAX, "pico de %u contagens/s", quad_peak_rate(&q));
+    q.dwell_us = DWELL_US;
+    q.cycles = CYCLES;
+    q.counts_per_rev = PER_REV;
+    quad_start(&q);
+
+    uint8_t prev = quad_levels(&q);
+    CHECK(prev == QUAD_LEVEL_Z, "estado inicial %#x", prev);
+    uint64_t at_us, last_us = 0, seg_t0_us = 0;
+    uint8_t levels;
+    int64_t position = 0;
+    int count = 0, index_marks = 0;
+    while (quad_next(&q, &at_us, &levels)) {
+        int seg = (count / COUNTS) % 2;
+        int i = count % COUNTS;
+        if (i == 0) {
+            expected_segment(seg ? MOTION_SCURVE : MOTION_TRAPEZOID);
+            seg_t0_us = count ? last_us + DWELL_US : 0;
+        }
+        position += seg ? -1 : 1;
+
+        // Uma linha por contagem, e B atrás de A no sentido positivo
+        uint8_t ab = levels & (QUAD_LEVEL_A | QUAD_LEVEL_B);
+        uint8_t prev_ab = prev & (QUAD_LEVEL_A | QUAD_LEVEL_B);
+        CHECK(__builtin_popcount(ab ^ prev_ab) == 1, "contagem %d: %#x -> %#x", count, prev_ab, ab);
+        static const uint8_t gray[4] = { 0, 1, 3, 2 };
+        CHECK(ab == gray[position & 3], "contagem %d na posição %lld: A/B %#x", count,
+              (long long)position, ab);
+        bool z = (levels & QUAD_LEVEL_Z) != 0;
+        CHECK(z == (llabs(position) % PER_REV == 0), "contagem %d na posição %lld: índice %d",
+              count, (long long)position, z);
+        index_marks += z;
+
+        CHECK(at_us == seg_t0_us + segment_times[i], "contagem %d em %llu us, esperado %llu",
+              count, (unsigned long long)at_us, (unsigned long long)(seg_t0_us + segment_times[i]));
+        CHECK(count == 0 || at_us > last_us, "contagem %d antes da anterior", count);
+        CHECK(q.position == position, "posição %lld, esperado %lld", (long long)q.position,
+              (long long)position);
+        prev = levels;
+        last_us = at_us;
+        count++;
+    }
+    printf("%d contagens em %.3f s, %d índices\n", count, last_us / 1e6, index_marks);
+    CHECK(count == CYCLES * 2 * COUNTS, "%d contagens", count);
+    CHECK(position == 0, "termina na posição %lld", (long long)position);
+    // Ida passa pelos índices 100..400 e volta por 300..0, em cada ciclo
+    CHECK(index_marks == CYCLES * 2 * COUNTS / PER_REV, "%d índices", index_marks);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include <string.h>
+#include "host_rtos.h"
+#include "host_test.h"
+#include "pulse_engine.h"
+#include "pulse_ramp.h"
+
+#define GPIO_OUT            5
+#define MAX_FALLS           1024
+
+// Rampas de 500 ms e 300 ms para 1 ms pleno: razão fixa, da taxa de
+// 1/RAMP_START_RATIO até a plena e de volta, com a duração pedida
+static void test_plan(void) {
+    ramp_t r;
+    CHECK(!ramp_plan(&r, 1000, 3, 3), "rampas de 3 ms aceitas para 1 ms pleno");
+    CHECK(ramp_plan(&r, 1000, 500, 300), "rampas recusadas");
+
+    ramp_up(&r);
+    uint64_t sum = 0;
+    uint32_t prev = UINT32_MAX, steps = 0, first = 0;
+    while (r.phase == RAMP_UP) {
+        uint32_t us = ramp_next_us(&r, 1000);
+        if (steps == 0) first = us;
+        CHECK(us <= prev && us >= 1000, "subida: intervalo %u de %u us", steps, us);
+        prev = us;
+        sum += us;
+        steps++;
+    }
+    printf("subida: %u intervalos de %u a %u us, %.1f ms\n", steps, first, prev, sum / 1e3);
+    CHECK(steps == r.up_steps, "%u intervalos na subida, planejados %u", steps, r.up_steps);
+    CHECK(first == 1000 * RAMP_START_RATIO, "subida começa em %u us", first);
+    CHECK_REL((double)sum, 500000.0, 0.05, "duração da subida");
+
+    CHECK(ramp_down(&r, 1000), "sem descida");
+    sum = 0;
+    prev = 0;
+    steps = 0;
+    uint32_t us;
+    while ((us = ramp_next_us(&r, 1000)) != 0) {
+        CHECK(us >= prev, "descida: intervalo %u de %u us", steps, us);
+        prev = us;
+        sum += us;
+        steps++;
+    }
+    printf("descida: %u intervalos até %u us, %.1f ms\n", steps, prev, sum / 1e3);
+    CHECK(steps == r.down_steps, "%u intervalos na descida, planejados %u", steps, r.down_steps);
+    CHECK(prev == 1000 * RAMP_START_RATIO, "descida termina em %u us", prev);
+    CHECK_REL((double)sum, 300000.0, 0.05, "duração da descida");
+}
+
+// Execução pela task com DEADLINE_SKIP: a cada vTaskDelay da task o relógio
+// anda 1 ms, e com 1,5 ms de intervalo e 1 ms de pulso metade dos prazos da
+// taxa plena passa da tolerância. Os pulados não contam no limite.
+static pulse_config_t config;
+static int64_t fall_us[MAX_FALLS];
+static int falls;
+static int finish_at;
+
+static void hook(int gpio, uint32_t level) {
+    if (gpio != GPIO_OUT || level || falls >= MAX_FALLS) {
+        return;
+    }
+    fall_us[falls++] = host_clock_us;
+    if (falls == finish_at) {
+        pulse_engine_finish();
+    }
+}
+
+static void run(uint64_t max_pulses, int finish_after) {
+    memset(&config, 0, sizeof(config));
+    config.gpio = GPIO_OUT;
+    config.mode = MODE_DEFINED;
+    config.interval_us = 1500;
+    config.pulse_duration_ms = 1;
+    config.max_pulses = max_pulses;
+    config.deadline.tolerance_us = 50;
+    config.deadline.policy = DEADLINE_SKIP;
+    pulse_config_init(&config);
+    CHECK(pulse_ramp_select(&config, 200, 200), "rampas recusadas");
+    falls = 0;
+    finish_at = finish_after;
+
+    host_gpio_hook = hook;
+    pulse_engine_start(&config, 1);
+    host_rtos_run();
+    host_gpio_hook = NULL;
+    pulse_engine_stop();
+}
+
+static void test_exact_count(void) {
+    const uint64_t max_pulses = 300;
+    run(max_pulses, 0);
+
+    pulse_engine_status_t st;
+    pulse_engine_snapshot(&st);
+    uint64_t count = st.channels[0].pulse_count;
+    printf("limite de %llu: %llu pulsos, %llu pulados\n", (unsigned long long)max_pulses,
+           (unsigned long long)count, (unsigned long long)st.channels[0].stats.skipped);
+    CHECK(st.channels[0].stats.skipped > 0, "nenhum prazo pulado");
+    CHECK(count == max_pulses, "%llu pulsos, limite %llu", (unsigned long long)count,
+          (unsigned long long)max_pulses);
+    // Os pulsos e as 3 piscadas do fim
+    CHECK(falls == (int)max_pulses + 3, "%d descidas no pino", falls);
+    // Termina na taxa mais lenta da descida
+    int64_t last = fall_us[max_pulses - 1] - fall_us[max_pulses - 2];
+    CHECK(llabs(last - 1500 * RAMP_START_RATIO) <= 2, "último intervalo de %lld us",
+          (long long)last);
+}
+
+// O fim pedido desce e termina antes do limite, sem repor os pulados
+static void test_finish(void) {
+    run(100000, 200);
+    pulse_engine_status_t st;
+    pulse_engine_snapshot(&st);
+    uint64_t count = st.channels[0].pulse_count;
+    printf("fim pedido no pulso 200: %llu pulsos\n", (unsigned long long)count);
+    CHECK(count > 200 && count < 400, "%llu pulsos depois do fim pedido",
+          (unsigned long long)count);
+    int64_t last = fall_us[count - 1] - fall_us[count - 2];
+    CHECK(llabs(last - 1500 * RAMP_START_RATIO) <= 2, "último intervalo de %lld us",
+          (long long)last);
+}
+
+int main(void) {
+    test_plan();
+    test_exact_count();
+    test_finish();
+    return HOST_TEST_RESULT();
+}
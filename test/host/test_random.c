@@ -0,0 +1,116 @@
+#include <math.h>
+#include <stdint.h>
+#include "host_test.h"
+#include "pulse_random.h"
+
+#define EVENTS 2000000
+
+// Média e índice de rajada B = (σ - μ) / (σ + μ) dos intervalos: 0 para
+// Poisson, > 0 quando os eventos se agrupam
+typedef struct {
+    double mean_us;
+    double burstiness;
+} interval_stats_t;
+
+static interval_stats_t mmpp_run(mmpp_t *m, uint32_t seed) {
+    uint32_t rng = seed;
+    double sum = 0, sum2 = 0;
+    for (int i = 0; i < EVENTS; i++) {
+        double dt = mmpp_next_us(m, &rng);
+        sum += dt;
+        sum2 += dt * dt;
+    }
+    double mean = sum / EVENTS;
+    double sigma = sqrt(sum2 / EVENTS - mean * mean);
+    return (interval_stats_t){ mean, (sigma - mean) / (sigma + mean) };
+}
+
+// B esperado: com a troca sorteada a cada pulso, o intervalo é exponencial
+// com a média do estado 0 ou 1 nas proporções 1 - π1 e π1
+static double mmpp_burstiness(const mmpp_t *m, int enter_permille, int leave_permille) {
+    double pi1 = (double)enter_permille / (enter_permille + leave_permille);
+    double m0 = m->mean_us[0], m1 = m->mean_us[1];
+    double mean = (1 - pi1) * m0 + pi1 * m1;
+    double second = 2 * ((1 - pi1) * m0 * m0 + pi1 * m1 * m1);
+    double sigma = sqrt(second - mean * mean);
+    return (sigma - mean) / (sigma + mean);
+}
+
+static void test_exp_sampler(void) {
+    uint32_t rng = 0x1234567u;
+    double sum = 0, sum2 = 0;
+    for (int i = 0; i < EVENTS; i++) {
+        double x = rng_exp_q16(&rng) / 65536.0;
+        sum += x;
+        sum2 += x * x;
+    }
+    double mean = sum / EVENTS;
+    CHECK_REL(mean, 1.0, 0.005, "média de -ln(U)");
+    CHECK_REL(sum2 / EVENTS - mean * mean, 1.0, 0.01, "variância de -ln(U)");
+}
+
+static double test_mmpp(uint32_t mean_us, int factor, int enter, int leave) {
+    mmpp_t m;
+    mmpp_setup(&m, mean_us, factor, enter, leave);
+    interval_stats_t s = mmpp_run(&m, seed_derive(42, (uint32_t)factor));
+    printf("MMPP %u us, x%d, %d/%d ‰: média %.1f us, B %.4f\n",
+           mean_us, factor, enter, leave, s.mean_us, s.burstiness);
+
+    // Taxa de longo prazo = a pedida, com o arredondamento das médias por estado
+    CHECK_REL(s.mean_us, mean_us, 0.01, "intervalo médio");
+    double want = mmpp_burstiness(&m, enter, leave);
+    CHECK(fabs(s.burstiness - want) <= 0.01, "B = %.4f, esperado %.4f", s.burstiness, want);
+    return s.burstiness;
+}
+
+// m = f(n) e n = f^-1(m) nos dois modelos, até a borda de cada um: m tau -> 1
+// no não paralisável e m tau = 1/e (n tau = 1) no paralisável
+static void check_round_trip(deadtime_model_t model, double x) {
+    const double tau = 250e-6;
+    double m = x / tau;
+    double n = deadtime_true_rate(m, tau, model);
+    CHECK(isfinite(n) && n >= m && (model != DEADTIME_PARALYZABLE || n * tau <= 1.0),
+          "modelo %d, m tau = %.15g: n = %g", model, x, n);
+    CHECK_REL(deadtime_observed_rate(n, tau, model), m, 1e-9, "taxa observada de volta");
+}
+
+static void test_deadtime_rates(void) {
+    static const double nonpar[] = { 1e-6, 0.01, 0.3, 0.5, 0.9, 0.999, 1.0 - 1e-9 };
+    for (size_t i = 0; i < sizeof(nonpar) / sizeof(nonpar[0]); i++) {
+        check_round_trip(DEADTIME_NONPARALYZABLE, nonpar[i]);
+    }
+    CHECK(deadtime_true_rate(1.0 / 250e-6, 250e-6, DEADTIME_NONPARALYZABLE) < 0, "m tau = 1 aceito");
+    CHECK(deadtime_true_rate(2.0 / 250e-6, 250e-6, DEADTIME_NONPARALYZABLE) < 0, "m tau = 2 aceito");
+
+    const double edge = exp(-1.0);
+    const double par[] = { 1e-6, 0.01, 0.2, 0.3, 0.36, edge * (1 - 1e-6), edge * (1 - 1e-12) };
+    for (size_t i = 0; i < sizeof(par) / sizeof(par[0]); i++) {
+        check_round_trip(DEADTIME_PARALYZABLE, par[i]);
+    }
+    // n -> m -> n no ramo n tau < 1
+    static const double ntau[] = { 0.001, 0.1, 0.5, 0.9, 0.99 };
+    for (size_t i = 0; i < sizeof(ntau) / sizeof(ntau[0]); i++) {
+        double m = deadtime_observed_rate(ntau[i], 1.0, DEADTIME_PARALYZABLE);
+        CHECK_REL(deadtime_true_rate(m, 1.0, DEADTIME_PARALYZABLE), ntau[i], 1e-6, "n tau de volta");
+    }
+    // Exatamente na borda: o máximo 1/(e tau) vem de n tau = 1, sem dividir por zero
+    double n = deadtime_true_rate(edge, 1.0, DEADTIME_PARALYZABLE);
+    CHECK(isfinite(n) && fabs(n - 1.0) < 1e-6, "m tau = 1/e: n tau = %g", n);
+    n = deadtime_true_rate(edge / 1e-3, 1e-3, DEADTIME_PARALYZABLE);
+    CHECK(isfinite(n) && fabs(n * 1e-3 - 1.0) < 1e-6, "m tau = 1/e com tau = 1 ms: n tau = %g", n * 1e-3);
+    CHECK(deadtime_true_rate(edge * (1 + 1e-9), 1.0, DEADTIME_PARALYZABLE) < 0, "m tau > 1/e aceito");
+}
+
+int main(void) {
+    test_exp_sampler();
+
+    // Sem troca de estado é Poisson
+    double poisson = test_mmpp(1000, 10, 0, 100);
+    CHECK(fabs(poisson) < 0.005, "Poisson com B = %.4f", poisson);
+    // Rajadas dez vezes mais rápidas em 1/6 dos pulsos
+    CHECK(test_mmpp(1000, 10, 20, 100) > 0.05, "rajadas sem agrupamento");
+    // Rajadas raras e longas
+    CHECK(test_mmpp(50000, 50, 2, 20) > 0.03, "rajadas sem agrupamento");
+    test_deadtime_rates();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,175 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host_test.h"
+#include "pulse_render.h"
+
+#define MAX_PAIRS           512
+#define MAX_SAMPLES         (1u << 20)
+
+typedef struct {
+    uint64_t gap[MAX_PAIRS];
+    uint32_t width[MAX_PAIRS];
+    int count;
+    int next;
+} pairs_t;
+
+static bool pairs_source(void *ctx, uint64_t *gap, uint32_t *width) {
+    pairs_t *p = (pairs_t *)ctx;
+    if (p->next == p->count) {
+        return false;
+    }
+    *gap = p->gap[p->next];
+    *width = p->width[p->next];
+    p->next++;
+    return true;
+}
+
+static uint32_t lcg(uint32_t *s) {
+    *s = *s * 1664525u + 1013904223u;
+    return *s >> 8;
+}
+
+// Referência amostra a amostra; retorna o fim do último pulso
+static size_t reference(const pairs_t *p, uint8_t *samples) {
+    size_t pos = 0;
+    memset(samples, 0, MAX_SAMPLES);
+    for (int i = 0; i < p->count; i++) {
+        pos += p->gap[i];
+        for (uint32_t k = 0; k < p->width[i]; k++) {
+            samples[pos++] = 1;
+        }
+    }
+    return pos;
+}
+
+// Renderiza em blocos de 'words' palavras e compara com a referência
+static void check_render(pairs_t *p, size_t words, const char *what) {
+    static uint8_t want[MAX_SAMPLES];
+    static uint32_t block[MAX_SAMPLES / 32];
+    size_t end = reference(p, want);
+    uint64_t pulses = 0;
+    for (int i = 0; i < p->count; i++) {
+        pulses += p->width[i] > 0;
+    }
+
+    render_channel_t ch;
+    p->next = 0;
+    render_channel_init(&ch, pairs_source, p);
+    size_t pos = 0;
+    int errors = 0;
+    bool more = true;
+    while (more && pos + words * 32 <= MAX_SAMPLES) {
+        more = render_plane(&ch, block, words);
+        for (size_t s = 0; s < words * 32; s++, pos++) {
+            uint8_t bit = (block[s / 32] >> (31 - s % 32)) & 1u;
+            if (bit != want[pos] && errors++ < 3) {
+                CHECK(0, "%s, blocos de %zu: amostra %zu = %u", what, words, pos, bit);
+            }
+        }
+        // O bloco em que o último pulso termina é o último, ou o seguinte
+        // quando ele termina bem no fim do bloco
+        CHECK(pos < end ? more : (!more || pos == end), "%s, blocos de %zu: render_plane = %d na amostra %zu (fim %zu)",
+              what, words, more, pos, end);
+    }
+    CHECK(!more, "%s, blocos de %zu: não terminou", what, words);
+    CHECK(ch.pulses == pulses, "%s: %llu pulsos, esperado %llu", what,
+          (unsigned long long)ch.pulses, (unsigned long long)pulses);
+}
+
+static void test_edges(void) {
+    pairs_t p = {0};
+    // Bordas nos limites de palavra, pulso de 1 amostra, gap nulo (pulsos
+    // colados), largura nula (sem pulso) e um gap maior que vários blocos
+    static const uint32_t cases[][2] = {
+        {0, 1}, {31, 1}, {0, 32}, {32, 32}, {1, 62}, {0, 0}, {5, 0},
+        {0, 7}, {0, 25}, {100000, 3}, {0, 64}, {33, 95},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        p.gap[p.count] = cases[i][0];
+        p.width[p.count++] = cases[i][1];
+    }
+    for (size_t words = 1; words <= 64; words *= 4) {
+        check_render(&p, words, "bordas");
+    }
+}
+
+static void test_random_pairs(void) {
+    uint32_t seed = 7;
+    for (int round = 0; round < 20; round++) {
+        pairs_t p = {0};
+        uint32_t scale = 1u << (lcg(&seed) % 10);
+        p.count = 1 + (int)(lcg(&seed) % MAX_PAIRS);
+        for (int i = 0; i < p.count; i++) {
+            p.gap[i] = lcg(&seed) % (scale + 1);
+            p.width[i] = lcg(&seed) % (scale + 1);
+        }
+        check_render(&p, 1 + lcg(&seed) % 40, "sorteio");
+    }
+}
+
+// Ordem do SPI: a amostra s sai no bit 7 - s % 8 do byte s / 8 da memória
+static void test_msb_bytes(void) {
+    enum { WORDS = 64 };
+    uint32_t words[WORDS], packed[WORDS];
+    uint32_t seed = 11;
+    for (int i = 0; i < WORDS; i++) {
+        words[i] = lcg(&seed) ^ (lcg(&seed) << 24);
+    }
+    words[3] = 0;
+    words[4] = 0xFFFFFFFFu;
+    words[5] = 0x80000001u;
+    memcpy(packed, words, sizeof(words));
+    render_to_msb_bytes(packed, WORDS);
+
+    const uint8_t *bytes = (const uint8_t *)packed;
+    int errors = 0;
+    for (size_t s = 0; s < WORDS * 32; s++) {
+        uint8_t want = (words[s / 32] >> (31 - s % 32)) & 1u;
+        uint8_t got = (bytes[s / 8] >> (7 - s % 8)) & 1u;
+        if (got != want && errors++ < 3) {
+            CHECK(0, "amostra %zu no byte %zu: %u, esperado %u", s, s / 8, got, want);
+        }
+    }
+}
+
+// Custo por palavra com bordas raras (trechos inteiros) e densas
+static double bench(uint64_t gap, uint32_t width) {
+    enum { WORDS = 1024, BLOCKS = 2000 };
+    static uint32_t block[WORDS];
+    pairs_t p = {0};
+    p.count = MAX_PAIRS;
+    for (int i = 0; i < p.count; i++) {
+        p.gap[i] = gap;
+        p.width[i] = width;
+    }
+    render_channel_t ch;
+    render_channel_init(&ch, pairs_source, &p);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int b = 0; b < BLOCKS; b++) {
+        if (!render_plane(&ch, block, WORDS)) {
+            p.next = 0;
+            render_channel_init(&ch, pairs_source, &p);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    return ns / ((double)WORDS * BLOCKS);
+}
+
+int main(void) {
+    test_edges();
+    test_random_pairs();
+    test_msb_bytes();
+
+    double idle = bench(1000000, 100);
+    double dense = bench(3, 5);
+    printf("render_plane: %.2f ns/palavra com bordas raras, %.2f ns/palavra com uma borda a cada 4 amostras\n",
+           idle, dense);
+    // Sem bordas o trecho sai palavra a palavra: bem mais barato que o denso
+    CHECK(idle < dense, "trecho ocioso não é mais barato que bordas densas");
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,107 @@
+#include <stdint.h>
+#include <string.h>
+#include "host_test.h"
+#include "pulse_random.h"
+#include "pulse_width.h"
+
+static width_seq_t w;
+
+static void expect_sequence(const char *what, const uint32_t *want, int n) {
+    width_start(&w);
+    for (int i = 0; i < n; i++) {
+        uint32_t got = width_next_us(&w);
+        CHECK(got == want[i], "%s: largura %d de %u us, esperado %u", what, i, got, want[i]);
+    }
+}
+
+static void test_table(void) {
+    memset(&w, 0, sizeof(w));
+    w.source = WIDTH_TABLE;
+    static const uint32_t table[] = { 500, 1500, 500, 500, 1500 };
+    memcpy(w.table, table, sizeof(table));
+    w.count = 5;
+    CHECK(width_setup(&w), "tabela recusada");
+    CHECK(width_max_us(&w) == 1500, "máximo da tabela %u", width_max_us(&w));
+    static const uint32_t want[] = { 500, 1500, 500, 500, 1500, 500, 1500, 500 };
+    expect_sequence("tabela", want, 8);
+
+    w.table[3] = 0;
+    CHECK(!width_setup(&w), "tabela com largura nula aceita");
+    w.count = 0;
+    CHECK(!width_setup(&w), "tabela vazia aceita");
+    w.count = WIDTH_MAX_TABLE + 1;
+    CHECK(!width_setup(&w), "tabela além de WIDTH_MAX_TABLE aceita");
+}
+
+// As duas pontas entram; o último passo encurta para cair nelas
+static void test_sweep(void) {
+    memset(&w, 0, sizeof(w));
+    w.source = WIDTH_SWEEP;
+    w.from_us = 100;
+    w.to_us = 350;
+    w.step_us = 100;
+    CHECK(width_setup(&w), "varredura recusada");
+    CHECK(width_max_us(&w) == 350, "máximo da varredura %u", width_max_us(&w));
+    static const uint32_t saw[] = { 100, 200, 300, 350, 100, 200, 300, 350, 100 };
+    expect_sequence("dente de serra", saw, 9);
+
+    w.triangle = true;
+    static const uint32_t tri[] = { 100, 200, 300, 350, 250, 150, 100, 200, 300, 350, 250 };
+    expect_sequence("triângulo", tri, 11);
+
+    // Descendo: from_us maior que to_us
+    w.from_us = 400;
+    w.to_us = 100;
+    w.triangle = false;
+    CHECK(width_max_us(&w) == 400, "máximo da varredura descendo %u", width_max_us(&w));
+    static const uint32_t down[] = { 400, 300, 200, 100, 400, 300 };
+    expect_sequence("descendo", down, 6);
+
+    w.step_us = 0;
+    CHECK(!width_setup(&w), "varredura sem passo aceita");
+}
+
+// Uniforme em [from_us, to_us], com as pontas, e a mesma sequência da
+// mesma semente (o xorshift32 de pulse_random.h)
+static void test_random(void) {
+    memset(&w, 0, sizeof(w));
+    w.source = WIDTH_RANDOM;
+    w.from_us = 1000;
+    w.to_us = 1009;
+    w.seed = 12345;
+    CHECK(width_setup(&w), "sorteio recusado");
+    CHECK(width_max_us(&w) == 1009, "máximo do sorteio %u", width_max_us(&w));
+
+    enum { DRAWS = 1000000 };
+    uint32_t hits[10] = { 0 };
+    width_start(&w);
+    uint32_t rng = w.seed;
+    for (int i = 0; i < DRAWS; i++) {
+        uint32_t us = width_next_us(&w);
+        if (us < 1000 || us > 1009) {
+            CHECK(false, "largura %u fora de [1000, 1009]", us);
+            return;
+        }
+        if (i < 1000) {
+            uint32_t want = 1000 + (uint32_t)(((uint64_t)rng_next(&rng) * 10) >> 32);
+            CHECK(us == want, "sorteio %d: %u us, esperado %u", i, us, want);
+        }
+        hits[us - 1000]++;
+    }
+    for (int i = 0; i < 10; i++) {
+        CHECK_REL((double)hits[i], DRAWS / 10.0, 0.02, "frequência de uma largura");
+    }
+
+    w.seed = 0;
+    CHECK(!width_setup(&w), "semente nula aceita");
+    w.seed = 1;
+    w.from_us = 1010;
+    CHECK(!width_setup(&w), "mínimo acima do máximo aceito");
+}
+
+int main(void) {
+    test_table();
+    test_sweep();
+    test_random();
+    return HOST_TEST_RESULT();
+}
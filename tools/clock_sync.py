@@ -0,0 +1,247 @@
+#!/usr/bin/env python3
+"""Relógio da placa (µs desde o boot) para o relógio do host.
+
+Cada troca (PROTO_CMD_TIME_SYNC) dá quatro instantes, como no NTP: envio do
+pedido (t1, host), chegada na placa (t2), envio da resposta (t3, placa) e
+chegada no host (t4). O tempo de serialização de cada perna sai pelo
+tamanho dos quadros e o baud; o que sobra do atraso de ida e volta é espera
+(task da placa ocupada, FIFO da UART cheia, latência do USB) e só aumenta o
+atraso. O atraso não depende da deriva, então ficam as trocas até
+--margin-us acima do menor atraso, e uma reta pelos deslocamentos delas dá o
+deslocamento e a deriva.
+
+    sync      troca com a placa (que deve estar gerando) e mostra a estimativa
+    simulate  placa simulada, com deriva e latência conhecidas, para testar
+              o estimador; falha se o erro passar de --tolerance-us
+
+Uso:
+    clock_sync.py sync --port /dev/ttyUSB0 [--count 60] [--period 1]
+    clock_sync.py simulate --ppm 40 --busy 0.5 [--tolerance-us 200]
+"""
+import argparse
+import random
+import struct
+import sys
+import time
+
+CMD_TIME_SYNC = 0x08
+RSP_TIME_SYNC = 0x88
+SYNC_REPLY = struct.Struct("<QQQ")
+REQUEST_BYTES = 6 + 8
+REPLY_BYTES = 6 + SYNC_REPLY.size
+RX_TOUT_SYMBOLS = 10  # a UART só entrega os bytes depois de 10 símbolos parada
+
+
+def host_now_us():
+    return time.time_ns() // 1000
+
+
+class Mapping:
+    """host_us = dev_us - (offset_us + drift * (dev_us - ref_us))."""
+
+    def __init__(self, offset_us, drift, ref_us, rms_us, points, min_delay_us):
+        self.offset_us = offset_us
+        self.drift = drift
+        self.ref_us = ref_us
+        self.rms_us = rms_us
+        self.points = points
+        self.min_delay_us = min_delay_us
+
+    def host_us(self, dev_us):
+        return dev_us - (self.offset_us + self.drift * (dev_us - self.ref_us))
+
+    def describe(self):
+        return (f"deslocamento {self.offset_us / 1e6:.6f} s em t_placa = {self.ref_us:.0f} us, "
+                f"deriva {self.drift * 1e6:+.3f} ppm, resíduo {self.rms_us:.0f} us rms "
+                f"({self.points} pontos, menor atraso {self.min_delay_us:.0f} us)")
+
+
+class Estimator:
+    def __init__(self, baud=115200, margin_us=500.0):
+        self.fwd_us = (REQUEST_BYTES + RX_TOUT_SYMBOLS) * 10e6 / baud
+        self.back_us = REPLY_BYTES * 10e6 / baud
+        self.margin_us = margin_us
+        self.samples = []
+
+    def add(self, t1, t2, t3, t4):
+        self.samples.append((t1, t2, t3, t4))
+
+    def point(self, sample):
+        """(instante na placa, deslocamento placa - host, atraso em espera)."""
+        t1, t2, t3, t4 = sample
+        offset = ((t2 - self.fwd_us - t1) + (t3 + self.back_us - t4)) / 2
+        delay = (t4 - t1) - (t3 - t2) - self.fwd_us - self.back_us
+        return (t2 + t3) / 2, offset, delay
+
+    def fit(self):
+        """Mapping, ou None com menos de 4 trocas."""
+        if len(self.samples) < 4:
+            return None
+        points = sorted((self.point(s) for s in self.samples), key=lambda p: p[2])
+        best = [p for p in points if p[2] <= points[0][2] + self.margin_us]
+        if len(best) < 3:
+            best = points[:3]
+        if max(p[0] for p in best) == min(p[0] for p in best):
+            return None
+
+        line = fit_line(best)
+        # Uma troca com espera entre as escolhidas sai da reta; refaz sem ela
+        residuals = sorted(abs(o - line_at(line, d)) for d, o, _ in best)
+        limit = max(3 * residuals[len(residuals) // 2], 50.0)
+        kept = [p for p in best if abs(p[1] - line_at(line, p[0])) <= limit]
+        if len(kept) >= 2 and len(kept) < len(best):
+            line = fit_line(kept)
+        else:
+            kept = best
+
+        ref, offset, drift = line
+        rms = (sum((o - line_at(line, d)) ** 2 for d, o, _ in kept) / len(kept)) ** 0.5
+        return Mapping(offset, drift, ref, rms, len(kept), min(p[2] for p in kept))
+
+
+def fit_line(points):
+    """Mínimos quadrados do deslocamento contra o instante na placa."""
+    ref = sum(p[0] for p in points) / len(points)
+    mean = sum(p[1] for p in points) / len(points)
+    sxx = sum((p[0] - ref) ** 2 for p in points)
+    sxy = sum((p[0] - ref) * (p[1] - mean) for p in points)
+    return ref, mean, (sxy / sxx if sxx else 0.0)
+
+
+def line_at(line, dev_us):
+    ref, offset, drift = line
+    return offset + drift * (dev_us - ref)
+
+
+# ========== PLACA SIMULADA ==========
+
+class SimulatedBoard:
+    """Relógio com deriva e as esperas do firmware: task do console ocupada
+    (log, status, checkpoint na NVS), FIFO de TX ocupada pelos quadros de
+    bordas e latência do USB."""
+
+    def __init__(self, args, rng):
+        self.args = args
+        self.rng = rng
+        self.boot_host_us = host_now_us() - args.uptime_s * 1e6
+        self.fwd_us = (REQUEST_BYTES + RX_TOUT_SYMBOLS) * 10e6 / args.baud
+        self.back_us = REPLY_BYTES * 10e6 / args.baud
+
+    def dev_us(self, host_us):
+        return int((host_us - self.boot_host_us) * (1 + self.args.ppm * 1e-6))
+
+    def host_of(self, dev_us):
+        return dev_us / (1 + self.args.ppm * 1e-6) + self.boot_host_us
+
+    def usb_us(self):
+        return self.args.usb_us + self.rng.expovariate(1 / self.args.jitter_us)
+
+    def exchange(self, t1):
+        a, rng = self.args, self.rng
+        arrival = t1 + self.fwd_us + self.usb_us() + a.asym_us
+        wait = rng.uniform(0, 100000) if rng.random() < a.busy else rng.uniform(0, 50)
+        h2 = arrival + wait
+        h3 = h2 + rng.uniform(20, 200)
+        fifo = rng.uniform(0, 128 * 10e6 / a.baud) if rng.random() < a.fifo else 0
+        t4 = h3 + fifo + self.back_us + self.usb_us()
+        return t1, self.dev_us(h2), self.dev_us(h3), int(t4)
+
+
+def simulate(args):
+    rng = random.Random(args.seed)
+    board = SimulatedBoard(args, rng)
+    est = Estimator(args.baud, args.margin_us)
+
+    t = host_now_us()
+    for _ in range(args.count):
+        est.add(*board.exchange(int(t)))
+        t += args.period * 1e6 * rng.uniform(0.9, 1.1)
+
+    mapping = est.fit()
+    if mapping is None:
+        sys.exit("trocas de menos")
+    print(mapping.describe())
+
+    first = board.dev_us(est.samples[0][0])
+    last = board.dev_us(t)
+    worst = max(abs(mapping.host_us(d) - board.host_of(d))
+                for d in range(first, last, max(1, (last - first) // 1000)))
+    print(f"deriva real {args.ppm:+.3f} ppm; pior erro do mapeamento {worst:.0f} us "
+          f"em {(last - first) / 1e6:.0f} s")
+    if worst > args.tolerance_us:
+        sys.exit(f"erro acima de {args.tolerance_us} us")
+
+
+# ========== PLACA REAL ==========
+
+def request(port, t1):
+    from meter_profile import frame
+    port.write(frame(CMD_TIME_SYNC, struct.pack("<Q", t1)))
+
+
+def reply(payload):
+    """(marca do host, t2, t3) de uma resposta PROTO_RSP_TIME_SYNC."""
+    return SYNC_REPLY.unpack(payload)
+
+
+def sync(args):
+    import serial
+    from edge_log import FrameScanner
+
+    est = Estimator(args.baud, args.margin_us)
+    scanner = FrameScanner()
+    with serial.Serial(args.port, args.baud, timeout=0.01) as port:
+        for _ in range(args.count):
+            t1 = host_now_us()
+            request(port, t1)
+            deadline = time.monotonic() + 1.0
+            done = False
+            while not done and time.monotonic() < deadline:
+                data = port.read(max(1, port.in_waiting))
+                t4 = host_now_us()
+                for kind, payload in scanner.feed(data):
+                    if kind == RSP_TIME_SYNC:
+                        mark, t2, t3 = reply(payload)
+                        if mark == t1:
+                            est.add(t1, t2, t3, t4)
+                            done = True
+            time.sleep(max(0.0, args.period - (host_now_us() - t1) / 1e6))
+
+    mapping = est.fit()
+    if mapping is None:
+        sys.exit(f"{len(est.samples)} respostas; a placa está gerando?")
+    print(mapping.describe())
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    s = sub.add_parser("sync", help="estima com a placa")
+    s.add_argument("--port", required=True)
+    m = sub.add_parser("simulate", help="testa o estimador numa placa simulada")
+    m.add_argument("--ppm", type=float, default=40.0, help="deriva da placa")
+    m.add_argument("--uptime-s", type=float, default=3600.0, help="placa ligada há")
+    m.add_argument("--usb-us", type=float, default=1000.0, help="latência fixa do USB por perna")
+    m.add_argument("--jitter-us", type=float, default=300.0, help="média da latência extra")
+    m.add_argument("--asym-us", type=float, default=0.0, help="atraso a mais só na ida")
+    m.add_argument("--busy", type=float, default=0.5, help="chance da task do console estar ocupada")
+    m.add_argument("--fifo", type=float, default=0.3, help="chance da FIFO de TX estar ocupada")
+    m.add_argument("--seed", type=int, default=1)
+    m.add_argument("--tolerance-us", type=float, default=200.0)
+    for p in (s, m):
+        p.add_argument("--baud", type=int, default=115200)
+        p.add_argument("--count", type=int, default=120, help="trocas")
+        p.add_argument("--period", type=float, default=1.0, help="segundos entre trocas")
+        p.add_argument("--margin-us", type=float, default=500.0,
+                       help="atraso acima do menor com que a troca ainda conta")
+    args = ap.parse_args()
+
+    if args.cmd == "sync":
+        sync(args)
+    else:
+        simulate(args)
+
+
+if __name__ == "__main__":
+    main()
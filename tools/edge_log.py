@@ -0,0 +1,265 @@
+#!/usr/bin/env python3
+"""Instantes dos pulsos exportados pela placa (PROTO_EVT_EDGES, ver proto.h).
+
+A placa precisa de PULSE_EDGE_EXPORT e estar gerando: capture liga a
+exportação (PROTO_CMD_EDGE_EXPORT), grava até Ctrl-C e desliga. Cada pulso
+sai com saída, número e início em µs desde o boot, o mesmo relógio das
+linhas de log e do uptime do status. Durante a captura uma troca de tempo
+(PROTO_CMD_TIME_SYNC) a cada --sync-s segundos estima deslocamento e deriva
+desse relógio em relação ao do host (ver clock_sync.py).
+
+    capture  grava da serial; com --raw guarda também os bytes recebidos e,
+             em <raw>.sync, as trocas de tempo
+    decode   decodifica uma captura bruta da serial (texto e quadros juntos)
+
+Saída pela extensão (ou --format): .csv com "saida,pulso,t_us", mais t_host
+(segundos Unix, corrigido pela deriva) quando há trocas de tempo, ou .vcd
+com o nível de cada pino (repouso alto, baixo por --width µs a cada pulso).
+
+Uso:
+    edge_log.py capture --port /dev/ttyUSB0 bordas.csv [--raw serial.bin]
+    edge_log.py decode serial.bin bordas.vcd --width 5
+"""
+import argparse
+import os
+import struct
+import sys
+import time
+
+from clock_sync import RSP_TIME_SYNC, Estimator, host_now_us, reply, request
+from meter_profile import PROTO_SOF, frame
+
+CMD_EDGE_EXPORT = 0x07
+RSP_OK = 0x80
+EVT_EDGES = 0x90
+HEADER = struct.Struct("<2Q2Q")
+SEQ_MASK = (1 << 64) - 1
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+class FrameScanner:
+    """Separa quadros íntegros do texto do console no mesmo fluxo de bytes."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.bad = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(PROTO_SOF)
+            if start < 0:
+                self.buf.clear()
+                return
+            del self.buf[:start]
+            if len(self.buf) < 4:
+                return
+            kind, length = struct.unpack_from("<BH", self.buf, 1)
+            if length > 256:
+                del self.buf[:1]
+                continue
+            end = 4 + length + 2
+            if len(self.buf) < end:
+                return
+            body = bytes(self.buf[1:4 + length])
+            if struct.unpack_from("<H", self.buf, 4 + length)[0] != crc16(body):
+                # 0xA5 no meio do texto: procura o próximo início
+                self.bad += 1
+                del self.buf[:1]
+                continue
+            del self.buf[:end]
+            yield kind, body[3:]
+
+
+def varint(data, pos):
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def edges(payload):
+    """(saída, número, t_us) de cada registro de um quadro PROTO_EVT_EDGES."""
+    fields = HEADER.unpack_from(payload)
+    t = list(fields[:2])
+    seq = list(fields[2:])
+    pos = HEADER.size
+    while pos < len(payload):
+        value, pos = varint(payload, pos)
+        channel = value & 1
+        skipped = 0
+        if value & 2:
+            skipped, pos = varint(payload, pos)
+        seq[channel] = (seq[channel] + 1 + skipped) & SEQ_MASK
+        t[channel] += value >> 2
+        yield channel, seq[channel], t[channel], skipped
+
+
+class Collector:
+    def __init__(self, baud):
+        self.scanner = FrameScanner()
+        self.clock = Estimator(baud)
+        self.marks = set()
+        self.pulses = []
+        self.skipped = 0
+        self.edge_bytes = 0
+
+    def feed(self, data, rx_us=None):
+        for kind, payload in self.scanner.feed(data):
+            if kind == RSP_TIME_SYNC and rx_us is not None:
+                mark, t2, t3 = reply(payload)
+                if mark in self.marks:
+                    self.marks.discard(mark)
+                    self.clock.add(mark, t2, t3, rx_us)
+            if kind != EVT_EDGES or len(payload) < HEADER.size:
+                continue
+            self.edge_bytes += len(payload) + 6
+            for channel, seq, t_us, skipped in edges(payload):
+                self.pulses.append((channel, seq, t_us))
+                self.skipped += skipped
+
+
+def write_csv(pulses, path, mapping):
+    with open(path, "w") as f:
+        if mapping is None:
+            f.write("saida,pulso,t_us\n")
+            for channel, seq, t_us in pulses:
+                f.write(f"{channel + 1},{seq},{t_us}\n")
+            return
+        f.write("saida,pulso,t_us,t_host\n")
+        for channel, seq, t_us in pulses:
+            f.write(f"{channel + 1},{seq},{t_us},{mapping.host_us(t_us) / 1e6:.6f}\n")
+
+
+def write_vcd(pulses, path, width_us, mapping):
+    events = []
+    for channel, _, t_us in pulses:
+        events.append((t_us, 0, channel))
+        events.append((t_us + width_us, 1, channel))
+    # No mesmo instante a subida vem antes da próxima descida
+    events.sort(key=lambda e: (e[0], -e[1]))
+    ids = "!\""
+    with open(path, "w") as f:
+        if mapping is not None:
+            f.write(f"$comment tempo em us desde o boot da placa; {mapping.describe()} $end\n")
+        f.write("$timescale 1us $end\n$scope module placa $end\n")
+        for channel in range(2):
+            f.write(f"$var wire 1 {ids[channel]} OUT{channel + 1} $end\n")
+        f.write("$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n1!\n1\"\n$end\n")
+        last = None
+        for t_us, level, channel in events:
+            if t_us != last:
+                f.write(f"#{t_us}\n")
+                last = t_us
+            f.write(f"{level}{ids[channel]}\n")
+
+
+def output(collector, args):
+    pulses = sorted(collector.pulses, key=lambda p: (p[2], p[0]))
+    mapping = collector.clock.fit()
+    fmt = args.format or ("vcd" if args.out.endswith(".vcd") else "csv")
+    if fmt == "vcd":
+        write_vcd(pulses, args.out, args.width, mapping)
+    else:
+        write_csv(pulses, args.out, mapping)
+
+    print(f"{len(pulses)} pulsos em {args.out}", file=sys.stderr)
+    if mapping is not None:
+        print(f"relógio: {mapping.describe()}", file=sys.stderr)
+    elif collector.clock.samples:
+        print(f"{len(collector.clock.samples)} trocas de tempo: poucas para o mapeamento",
+              file=sys.stderr)
+    if pulses:
+        print(f"{collector.edge_bytes / len(pulses):.2f} bytes por pulso com os quadros",
+              file=sys.stderr)
+    if collector.skipped:
+        print(f"{collector.skipped} pulsos sem registro (anel cheio; aumente "
+              f"PULSE_LOG_RING_SIZE)", file=sys.stderr)
+    if collector.scanner.bad:
+        print(f"{collector.scanner.bad} quadros com CRC errado", file=sys.stderr)
+
+
+def decode(args):
+    collector = Collector(args.baud)
+    with open(args.raw_in, "rb") as f:
+        collector.feed(f.read())
+    sync_path = args.raw_in + ".sync"
+    if os.path.exists(sync_path):
+        with open(sync_path) as f:
+            for line in f:
+                collector.clock.add(*(int(v) for v in line.split()))
+    output(collector, args)
+
+
+def capture(args):
+    import serial
+
+    collector = Collector(args.baud)
+    raw = open(args.raw, "wb") if args.raw else None
+    with serial.Serial(args.port, args.baud, timeout=0.01) as port:
+        port.write(frame(CMD_EDGE_EXPORT, b"\x01"))
+        print("gravando; Ctrl-C para parar", file=sys.stderr)
+        next_sync = time.monotonic()
+        try:
+            while True:
+                if args.sync_s and time.monotonic() >= next_sync:
+                    mark = host_now_us()
+                    collector.marks.add(mark)
+                    request(port, mark)
+                    next_sync += args.sync_s
+                # Leitura curta: o instante de chegada da resposta entra na estimativa
+                data = port.read(max(1, port.in_waiting))
+                rx_us = host_now_us()
+                if raw:
+                    raw.write(data)
+                collector.feed(data, rx_us)
+        except KeyboardInterrupt:
+            pass
+        port.write(frame(CMD_EDGE_EXPORT, b"\x00"))
+    if raw:
+        raw.close()
+        with open(args.raw + ".sync", "w") as f:
+            for sample in collector.clock.samples:
+                f.write(" ".join(str(int(v)) for v in sample) + "\n")
+    output(collector, args)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    c = sub.add_parser("capture", help="grava da placa")
+    c.add_argument("out")
+    c.add_argument("--port", required=True)
+    c.add_argument("--raw", help="guarda os bytes recebidos")
+    c.add_argument("--sync-s", type=float, default=1.0,
+                   help="segundos entre trocas de tempo (0 = sem)")
+    d = sub.add_parser("decode", help="decodifica uma captura bruta")
+    d.add_argument("raw_in")
+    d.add_argument("out")
+    for p in (c, d):
+        p.add_argument("--baud", type=int, default=115200)
+        p.add_argument("--format", choices=("csv", "vcd"))
+        p.add_argument("--width", type=int, default=1, help="largura desenhada no VCD (µs)")
+    args = ap.parse_args()
+
+    if args.cmd == "capture":
+        capture(args)
+    else:
+        decode(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""Perfis de carga do modo S0 (ver components/pulse_engine/include/pulse_meter.h).
+
+Arquivo de perfil: "tempo_s potencia_kW" por linha, tempos crescentes e o
+primeiro em 0; a potência é interpolada linearmente entre os pontos. Linhas
+vazias e texto após '#' são ignorados.
+
+    check  reproduz a aritmética inteira do firmware e dá o total exato de
+           pulsos de uma ou mais passadas pelo perfil
+    send   carrega o perfil na placa pelo protocolo (PROTO_CMD_METER_PROFILE);
+           a placa deve estar no menu do modo S0 ou gerando (precisa de pyserial)
+
+Uso:
+    meter_profile.py check perfil.txt --imp 1000 [--passes 3] [--slice-ms 100]
+    meter_profile.py send perfil.txt --port /dev/ttyUSB0
+"""
+import argparse
+import struct
+import sys
+
+MAX_POWER_MW = 1000000000
+PULSE_ENERGY = 7200000000000000  # 2 x 1 kWh em mW.us, como no firmware
+
+PROTO_SOF = 0xA5
+PROTO_MAX_PAYLOAD = 256
+CMD_METER_PROFILE = 0x02
+RSP_METER_PROFILE = 0x82
+RSP_ERROR = 0xFF
+HEADER = struct.Struct("<HH")
+POINT = struct.Struct("<II")
+POINTS_PER_FRAME = (PROTO_MAX_PAYLOAD - HEADER.size) // POINT.size
+
+
+def load(path):
+    points = []
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            fields = line.split("#", 1)[0].split()
+            if not fields:
+                continue
+            if len(fields) != 2:
+                sys.exit(f"{path}:{number}: esperado 'tempo_s potencia_kW'")
+            t_ms = round(float(fields[0]) * 1000)
+            power_mw = round(float(fields[1]) * 1e6)
+            if not 0 <= power_mw <= MAX_POWER_MW:
+                sys.exit(f"{path}:{number}: potência fora de 0 a {MAX_POWER_MW // 10**6} kW")
+            if points and t_ms <= points[-1][0]:
+                sys.exit(f"{path}:{number}: tempo não crescente")
+            points.append((t_ms, power_mw))
+    if len(points) < 2 or points[0][0] != 0:
+        sys.exit(f"{path}: o perfil precisa de 2 pontos ou mais, o primeiro em t = 0")
+    return points
+
+
+def power(a, b, t_ms):
+    # Divisão inteira truncada para zero, como em C
+    dp = b[1] - a[1]
+    num = dp * (t_ms - a[0])
+    den = b[0] - a[0]
+    q = abs(num) // den
+    return a[1] + (q if num >= 0 else -q)
+
+
+def slices(points, slice_ms):
+    """Fatias (duração em us, taxa por us) na ordem do firmware, sem N."""
+    for a, b in zip(points, points[1:]):
+        t = a[0]
+        while t < b[0]:
+            end = min(b[0], t + slice_ms)
+            yield (end - t) * 1000, power(a, b, t) + power(a, b, end)
+            t = end
+
+
+def expected_pulses(points, imp, slice_ms, passes):
+    """Total exato de pulsos e a energia que sobra no acumulador."""
+    phase = total = 0
+    for _ in range(passes):
+        for dt_us, rate in slices(points, slice_ms):
+            phase += rate * imp * dt_us
+            total += phase // PULSE_ENERGY
+            phase %= PULSE_ENERGY
+    return total, phase
+
+
+def check(args):
+    points = load(args.profile)
+    peak = max(p for _, p in points)
+    if 2 * peak * args.imp >= PULSE_ENERGY:
+        sys.exit("pico acima de 1e6 pulsos/s")
+    wh = sum((a[1] + b[1]) / 2 * (b[0] - a[0]) for a, b in zip(points, points[1:])) / 3.6e9
+    total, phase = expected_pulses(points, args.imp, args.slice_ms, args.passes)
+    print(f"{len(points)} pontos, {points[-1][0] / 1000:.3f} s por passada, {wh:.6f} Wh por passada")
+    print(f"pico de {peak * args.imp / 3.6e9:.3f} pulsos/s a {args.imp} imp/kWh")
+    print(f"{total} pulsos em {args.passes} passada(s); resto {phase / PULSE_ENERGY:.6f} pulso")
+
+
+def frame(kind, payload):
+    body = bytes([kind]) + struct.pack("<H", len(payload)) + payload
+    crc = 0xFFFF
+    for byte in body:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return bytes([PROTO_SOF]) + body + struct.pack("<H", crc)
+
+
+def read_frame(port):
+    while True:
+        byte = port.read(1)
+        if not byte:
+            sys.exit("sem resposta da placa")
+        if byte[0] == PROTO_SOF:
+            break
+    kind, length = struct.unpack("<BH", port.read(3))
+    payload = port.read(length)
+    port.read(2)
+    return kind, payload
+
+
+def send(args):
+    import serial
+
+    points = load(args.profile)
+    with serial.Serial(args.port, args.baud, timeout=2) as port:
+        for first in range(0, len(points), POINTS_PER_FRAME):
+            chunk = points[first:first + POINTS_PER_FRAME]
+            payload = HEADER.pack(first, len(points)) + b"".join(POINT.pack(*p) for p in chunk)
+            port.write(frame(CMD_METER_PROFILE, payload))
+            kind, reply = read_frame(port)
+            if kind != RSP_METER_PROFILE:
+                sys.exit(f"placa recusou o quadro a partir do ponto {first} (tabela cheia?)")
+            print(f"{struct.unpack('<H', reply)[0]}/{len(points)} pontos")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    c = sub.add_parser("check", help="total exato de pulsos do perfil")
+    c.add_argument("profile")
+    c.add_argument("--imp", type=int, required=True, help="constante do medidor (imp/kWh)")
+    c.add_argument("--passes", type=int, default=1, help="passadas pelo perfil (repetição)")
+    c.add_argument("--slice-ms", type=int, default=100, help="PULSE_METER_SLICE_MS do firmware")
+    s = sub.add_parser("send", help="carrega o perfil na placa")
+    s.add_argument("profile")
+    s.add_argument("--port", required=True)
+    s.add_argument("--baud", type=int, default=115200)
+    args = ap.parse_args()
+
+    if args.cmd == "check":
+        check(args)
+    else:
+        send(args)
+
+
+if __name__ == "__main__":
+    main()
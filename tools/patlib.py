@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""Monta e inspeciona a imagem da partição "patterns" (ver components/pulse_storage/include/pattern_lib.h).
+
+Cada arquivo de entrada vira um padrão com o nome do arquivo sem extensão
+(até 16 caracteres):
+    *.ts   um timestamp por linha em µs (captura; largura vem da configuração)
+    *.seq  "intervalo_us largura_us" por linha; o intervalo é até o próximo pulso
+Linhas vazias e texto após '#' são ignorados.
+
+A imagem vai para a placa pelo protocolo (send, com a placa esperando a
+biblioteca no menu do modo replay; precisa de pyserial) ou pelo parttool.py.
+
+Uso:
+    patlib.py build patterns.bin capturas/*.ts sequencias/*.seq
+    patlib.py list patterns.bin
+    patlib.py send patterns.bin --port /dev/ttyUSB0
+    parttool.py write_partition --partition-name patterns --input patterns.bin
+"""
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = 0x42494C50  # "PLIB"
+VERSION = 1
+NAME_LEN = 16
+KIND_TRACE = 1
+KIND_SEQUENCE = 2
+HEADER = struct.Struct("<IHHII")
+ENTRY = struct.Struct("<16sB3xIIIQ")
+PARTITION_SIZE = 0xF0000
+CMD_PATTERN_UPLOAD = 0x09
+RSP_PATTERN_UPLOAD = 0x89
+UPLOAD_HEADER = struct.Struct("<II")
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def read_varint(data, pos):
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def parse_lines(path):
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            fields = line.split("#", 1)[0].split()
+            if fields:
+                yield number, [int(x, 0) for x in fields]
+
+
+def encode_trace(path):
+    stamps = sorted(values[0] for _, values in parse_lines(path))
+    if not stamps:
+        return b"", 0, 0
+    data = bytearray()
+    prev = stamps[0]
+    for t in stamps:
+        data += varint(t - prev)
+        prev = t
+    return bytes(data), len(stamps), stamps[-1] - stamps[0]
+
+
+def encode_sequence(path):
+    data = bytearray()
+    delta = duration = count = 0
+    for number, values in parse_lines(path):
+        if len(values) != 2:
+            sys.exit(f"{path}:{number}: esperado 'intervalo_us largura_us'")
+        interval, width = values
+        if width >= interval:
+            sys.exit(f"{path}:{number}: largura {width} us não cabe no intervalo {interval} us")
+        data += varint(delta) + varint(width)
+        duration += delta
+        delta = interval
+        count += 1
+    return bytes(data), count, duration
+
+
+def build(output, inputs):
+    patterns = []
+    for path in inputs:
+        name, ext = os.path.splitext(os.path.basename(path))
+        if len(name.encode()) > NAME_LEN:
+            sys.exit(f"{path}: nome com mais de {NAME_LEN} bytes")
+        if any(p[0] == name for p in patterns):
+            sys.exit(f"{path}: nome '{name}' repetido")
+        if ext == ".ts":
+            kind, encoded = KIND_TRACE, encode_trace(path)
+        elif ext == ".seq":
+            kind, encoded = KIND_SEQUENCE, encode_sequence(path)
+        else:
+            sys.exit(f"{path}: extensão desconhecida (use .ts ou .seq)")
+        patterns.append((name, kind) + encoded)
+
+    offset = HEADER.size + ENTRY.size * len(patterns)
+    index = bytearray()
+    blob = bytearray()
+    for name, kind, data, count, duration in patterns:
+        index += ENTRY.pack(name.encode(), kind, offset + len(blob), len(data), count, duration)
+        blob += data
+
+    size = offset + len(blob)
+    if size > PARTITION_SIZE:
+        sys.exit(f"imagem de {size} bytes excede a partição ({PARTITION_SIZE})")
+
+    with open(output, "wb") as f:
+        f.write(HEADER.pack(MAGIC, VERSION, ENTRY.size, len(patterns), size) + index + blob)
+    print(f"{len(patterns)} padrões, {size} bytes")
+
+
+def list_image(path):
+    with open(path, "rb") as f:
+        image = f.read()
+    magic, version, entry_size, count, size = HEADER.unpack_from(image)
+    if magic != MAGIC or version != VERSION or entry_size != ENTRY.size or size > len(image):
+        sys.exit(f"{path}: imagem inválida")
+
+    for i in range(count):
+        raw, kind, offset, length, events, duration = ENTRY.unpack_from(
+            image, HEADER.size + i * ENTRY.size)
+        pos, end, decoded = offset, offset + length, 0
+        while pos < end:
+            _, pos = read_varint(image, pos)
+            if kind == KIND_SEQUENCE:
+                _, pos = read_varint(image, pos)
+            decoded += 1
+        status = "ok" if decoded == events and pos == end else "CORROMPIDO"
+        name = raw.rstrip(b"\0").decode()
+        kind_name = "sequência" if kind == KIND_SEQUENCE else "captura"
+        print(f"{i + 1}. {name:16} {kind_name:9} {events:8} eventos {duration:12} us {status}")
+
+
+def send(args):
+    import serial
+    from meter_profile import PROTO_MAX_PAYLOAD, frame, read_frame
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    magic, version, entry_size, _, size = HEADER.unpack_from(image)
+    if magic != MAGIC or version != VERSION or entry_size != ENTRY.size or size > len(image):
+        sys.exit(f"{args.image}: imagem inválida")
+    image = image[:size]
+
+    per_frame = PROTO_MAX_PAYLOAD - UPLOAD_HEADER.size
+    # Apagar um setor da flash leva dezenas de ms a cada 4 KB
+    with serial.Serial(args.port, args.baud, timeout=2) as port:
+        for offset in range(0, size, per_frame):
+            payload = UPLOAD_HEADER.pack(offset, size) + image[offset:offset + per_frame]
+            port.write(frame(CMD_PATTERN_UPLOAD, payload))
+            kind, reply = read_frame(port)
+            if kind != RSP_PATTERN_UPLOAD:
+                sys.exit(f"placa recusou o quadro no byte {offset} "
+                         f"(fora da espera pela biblioteca ou imagem inválida?)")
+            print(f"\r{struct.unpack('<I', reply)[0]}/{size} bytes", end="", flush=True)
+    print("\npressione ENTER no console da placa")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    b = sub.add_parser("build", help="monta a imagem a partir de arquivos de padrão")
+    b.add_argument("output")
+    b.add_argument("inputs", nargs="+")
+    ls = sub.add_parser("list", help="lista e verifica os padrões de uma imagem")
+    ls.add_argument("image")
+    s = sub.add_parser("send", help="grava a imagem na placa pelo protocolo")
+    s.add_argument("image")
+    s.add_argument("--port", required=True)
+    s.add_argument("--baud", type=int, default=115200)
+    args = ap.parse_args()
+
+    if args.cmd == "build":
+        build(args.output, args.inputs)
+    elif args.cmd == "send":
+        send(args)
+    else:
+        list_image(args.image)
+
+
+if __name__ == "__main__":
+    main()
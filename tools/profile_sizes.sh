@@ -0,0 +1,21 @@
+#!/bin/sh
+# Compila cada perfil de profiles/ em build_<perfil> e imprime o uso de
+# flash/RAM. Os ciclos por borda de cada perfil aparecem no status da placa
+# (tecla S ou PROTO_CMD_STATUS) em "ciclos/borda".
+#
+# Uso: tools/profile_sizes.sh [perfil ...]   (padrão: todos)
+set -e
+cd "$(dirname "$0")/.."
+
+profiles="$*"
+if [ -z "$profiles" ]; then
+    profiles=$(ls profiles | sed 's/^sdkconfig\.//')
+fi
+
+for p in $profiles; do
+    echo "===== $p ====="
+    idf.py -B "build_$p" -D SDKCONFIG="build_$p/sdkconfig" \
+        -D SDKCONFIG_DEFAULTS="sdkconfig.defaults;profiles/sdkconfig.$p" build size > "build_$p.log" 2>&1 ||
+        { tail -n 30 "build_$p.log"; exit 1; }
+    sed -n '/Total sizes/,$p' "build_$p.log"
+done
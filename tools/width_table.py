@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""Tabelas de largura por pulso (ver components/pulse_engine/include/pulse_width.h).
+
+Arquivo de tabela: uma largura em µs por linha, na ordem em que os pulsos
+saem (a tabela se repete). Linhas vazias e texto após '#' são ignorados.
+Com --bits a tabela vem de dados codificados em PWM: cada bit vira um pulso
+com a largura de --zero ou --one, do bit mais significativo de cada byte.
+
+    check  mostra o tamanho e a maior largura; com --interval confere a folga
+    send   carrega a tabela na placa pelo protocolo (PROTO_CMD_WIDTH_TABLE);
+           a placa deve estar na escolha da largura (precisa de pyserial)
+
+Uso:
+    width_table.py check larguras.txt [--interval 1000]
+    width_table.py check --bits 'A5 0F' --zero 200 --one 600
+    width_table.py send larguras.txt --port /dev/ttyUSB0
+"""
+import argparse
+import struct
+import sys
+
+from meter_profile import PROTO_MAX_PAYLOAD, frame, read_frame
+
+CMD_WIDTH_TABLE = 0x06
+RSP_WIDTH_TABLE = 0x86
+HEADER = struct.Struct("<HH")
+WIDTHS_PER_FRAME = (PROTO_MAX_PAYLOAD - HEADER.size) // 4
+MAX_WIDTH_US = 0xFFFFFFFF
+
+
+def load(path):
+    widths = []
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            text = line.split("#", 1)[0].strip()
+            if not text:
+                continue
+            try:
+                width = int(text)
+            except ValueError:
+                sys.exit(f"{path}:{number}: esperado um inteiro em µs")
+            if not 0 < width <= MAX_WIDTH_US:
+                sys.exit(f"{path}:{number}: largura fora de 1 a {MAX_WIDTH_US} µs")
+            widths.append(width)
+    return widths
+
+
+def from_bits(hex_bytes, zero_us, one_us):
+    try:
+        data = bytes.fromhex(hex_bytes)
+    except ValueError:
+        sys.exit("--bits espera bytes em hexadecimal")
+    return [one_us if byte & (0x80 >> bit) else zero_us for byte in data for bit in range(8)]
+
+
+def table(args):
+    if args.bits is not None:
+        if not args.zero or not args.one:
+            sys.exit("--bits precisa de --zero e --one")
+        widths = from_bits(args.bits, args.zero, args.one)
+    elif args.table:
+        widths = load(args.table)
+    else:
+        sys.exit("informe o arquivo de tabela ou --bits")
+    if not widths:
+        sys.exit("tabela vazia")
+    if len(widths) > args.max_table:
+        sys.exit(f"{len(widths)} larguras; a placa aceita {args.max_table} (PULSE_WIDTH_TABLE_SIZE)")
+    return widths
+
+
+def check(args):
+    widths = table(args)
+    widest = max(widths)
+    print(f"{len(widths)} larguras, de {min(widths)} a {widest} µs")
+    if args.interval:
+        if widest >= args.interval:
+            sys.exit(f"a largura de {widest} µs não cabe no intervalo de {args.interval} µs")
+        print(f"folga mínima de {args.interval - widest} µs até o próximo pulso")
+
+
+def send(args):
+    import serial
+
+    widths = table(args)
+    with serial.Serial(args.port, args.baud, timeout=2) as port:
+        for first in range(0, len(widths), WIDTHS_PER_FRAME):
+            chunk = widths[first:first + WIDTHS_PER_FRAME]
+            payload = HEADER.pack(first, len(widths)) + struct.pack(f"<{len(chunk)}I", *chunk)
+            port.write(frame(CMD_WIDTH_TABLE, payload))
+            kind, reply = read_frame(port)
+            if kind != RSP_WIDTH_TABLE:
+                sys.exit(f"placa recusou o quadro a partir da largura {first} (tabela cheia?)")
+            print(f"{struct.unpack('<H', reply)[0]}/{len(widths)} larguras")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    for name, help_text in (("check", "confere a tabela"), ("send", "carrega a tabela na placa")):
+        p = sub.add_parser(name, help=help_text)
+        p.add_argument("table", nargs="?")
+        p.add_argument("--bits", help="bytes em hexadecimal codificados em PWM")
+        p.add_argument("--zero", type=int, help="largura do bit 0 (µs)")
+        p.add_argument("--one", type=int, help="largura do bit 1 (µs)")
+        p.add_argument("--max-table", type=int, default=256, help="PULSE_WIDTH_TABLE_SIZE do firmware")
+        if name == "check":
+            p.add_argument("--interval", type=int, help="intervalo entre pulsos (µs)")
+        else:
+            p.add_argument("--port", required=True)
+            p.add_argument("--baud", type=int, default=115200)
+    args = ap.parse_args()
+
+    if args.cmd == "check":
+        check(args)
+    else:
+        send(args)
+
+
+if __name__ == "__main__":
+    main()